@@ -0,0 +1,158 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "esphome/core/log.h"
+#include "esphome/core/version.h"
+#include "cn105.h"
+
+namespace esphome {
+
+    /**
+     * cn105.refresh: continues the automation once the requested data group is at most max_age old.
+     * Returns immediately when data is fresh enough, otherwise waits for a single (shared) info request.
+     */
+    template<typename... Ts> class CN105RefreshAction : public Action<Ts...>, public Parented<CN105Climate> {
+    public:
+        TEMPLATABLE_VALUE(uint32_t, max_age)
+
+        void set_code(uint8_t code) { this->code_ = code; }
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+        void play_complex(const Ts &...x) override {
+#else
+        void play_complex(Ts... x) override {
+#endif
+            this->num_running_++;
+            // the run is registered before refresh(): a callback fired synchronously finds (and removes) it
+            uint32_t token = ++this->last_token_;
+            this->runs_.push_back(token);
+            this->parent_->refresh(this->code_, this->max_age_.value(x...), [this, token, x...](bool fresh) {
+                if (!this->finish_run_(token)) {
+                    return;                                 // stopped meanwhile: the run is not ours anymore
+                }
+                if (!fresh) {
+                    ESP_LOGW(LOG_CYCLE_TAG, "cn105.refresh 0x%02X: continuing with stale data", this->code_);
+                }
+                this->play_next_(x...);
+                });
+        }
+
+        void stop() override {
+            // a refresh answered after stop() must not advance a later run with this run's arguments
+            this->runs_.clear();
+        }
+
+    protected:
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+        void play(const Ts &...x) override { /* handled by play_complex */ }
+#else
+        void play(Ts... x) override { /* handled by play_complex */ }
+#endif
+
+        uint8_t code_{ 0x02 };
+        std::vector<uint32_t> runs_;                        // tokens of the runs waiting for their refresh
+        uint32_t last_token_ = 0;
+
+        bool finish_run_(uint32_t token) {
+            for (auto it = this->runs_.begin(); it != this->runs_.end(); ++it) {
+                if (*it == token) {
+                    this->runs_.erase(it);
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    /**
+     * cn105.apply: writes mode / setpoint / fan / vane, then runs on_success once a settings readback
+     * carries all of them, or on_failure when the deadline passes. The automation continues afterwards.
+     */
+    template<typename... Ts> class CN105ApplyAction : public Action<Ts...>, public Parented<CN105Climate> {
+    public:
+        TEMPLATABLE_VALUE(climate::ClimateMode, mode)
+        TEMPLATABLE_VALUE(float, target_temperature)
+        TEMPLATABLE_VALUE(climate::ClimateFanMode, fan_mode)
+        TEMPLATABLE_VALUE(std::string, vane)
+        TEMPLATABLE_VALUE(uint32_t, timeout)
+
+        void add_on_success(const std::initializer_list<Action<Ts...>*>& actions) {
+            this->on_success_.add_actions(actions);
+            this->on_success_.add_action(new LambdaAction<Ts...>([this](auto &&...x) { this->play_next_(x...); }));
+        }
+        void add_on_failure(const std::initializer_list<Action<Ts...>*>& actions) {
+            this->on_failure_.add_actions(actions);
+            this->on_failure_.add_action(new LambdaAction<Ts...>([this](auto &&...x) { this->play_next_(x...); }));
+        }
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+        void play_complex(const Ts &...x) override {
+#else
+        void play_complex(Ts... x) override {
+#endif
+            this->num_running_++;
+            CN105Climate::ApplyRequest request;
+            if (this->mode_.has_value()) request.mode = this->mode_.value(x...);
+            if (this->target_temperature_.has_value()) request.target_temperature = this->target_temperature_.value(x...);
+            if (this->fan_mode_.has_value()) request.fan_mode = this->fan_mode_.value(x...);
+            std::string vane = this->vane_.has_value() ? this->vane_.value(x...) : std::string();
+            if (!vane.empty()) request.vane = vane.c_str();
+
+            // the run is registered before apply(): a callback fired synchronously finds (and removes) it
+            uint32_t token = ++this->last_token_;
+            this->runs_.push_back(Run{ token, 0 });
+            uint32_t waiter = this->parent_->apply(request, this->timeout_.value(x...), [this, token, x...](bool confirmed) {
+                if (!this->finish_run_(token)) {
+                    return;                                 // stopped meanwhile: the run is not ours anymore
+                }
+                ActionList<Ts...>& branch = confirmed ? this->on_success_ : this->on_failure_;
+                if (branch.empty()) {
+                    this->play_next_(x...);
+                } else {
+                    branch.play(x...);
+                }
+                });
+            for (auto& run : this->runs_) {
+                if (run.token == token) run.waiter = waiter;
+            }
+        }
+
+        void stop() override {
+            // a confirmation arriving after stop() must not fire a branch of a later run
+            for (const auto& run : this->runs_) {
+                if (run.waiter != 0) this->parent_->cancel_apply(run.waiter);
+            }
+            this->runs_.clear();
+            this->on_success_.stop();
+            this->on_failure_.stop();
+        }
+
+    protected:
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+        void play(const Ts &...x) override { /* handled by play_complex */ }
+#else
+        void play(Ts... x) override { /* handled by play_complex */ }
+#endif
+
+        ActionList<Ts...> on_success_;
+        ActionList<Ts...> on_failure_;
+
+        struct Run {
+            uint32_t token;
+            uint32_t waiter;                                // CN105Climate::apply id, 0 once resolved
+        };
+        std::vector<Run> runs_;
+        uint32_t last_token_ = 0;
+
+        bool finish_run_(uint32_t token) {
+            for (auto it = this->runs_.begin(); it != this->runs_.end(); ++it) {
+                if (it->token == token) {
+                    this->runs_.erase(it);
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+}
@@ -1,5 +1,6 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
+from esphome import automation
 from esphome.components.uptime.sensor import UptimeSecondsSensor
 
 from esphome.components import (
@@ -28,11 +29,18 @@ from esphome.const import (
     CONF_ENTITY_CATEGORY,
     ENTITY_CATEGORY_DIAGNOSTIC,
     STATE_CLASS_TOTAL_INCREASING,
+    STATE_CLASS_MEASUREMENT,
     UNIT_SECOND,
+    UNIT_HOUR,
+    UNIT_PERCENT,
+    UNIT_KILOWATT_HOURS,
+    DEVICE_CLASS_ENERGY,
     ICON_TIMER,
     DEVICE_CLASS_DURATION,
     CONF_TX_PIN,
     CONF_RX_PIN,
+    CONF_TARGET_TEMPERATURE,
+    CONF_TIMEOUT,
 )
 from esphome.components.sensor import (
     CONF_UNIT_OF_MEASUREMENT as SENSOR_CONF_UNIT_OF_MEASUREMENT,
@@ -88,6 +96,9 @@ CONF_OPTIONS = "options"
 
 # Support explicite du DUAL setpoint via YAML
 CONF_DUAL_SETPOINT = "dual_setpoint"
+CONF_DEADBAND = "deadband"
+CONF_MIN_PUBLISH_INTERVAL = "min_publish_interval"
+CONF_MAX_PUBLISH_INTERVAL = "max_publish_interval"
 
 DEFAULT_CLIMATE_MODES = ["AUTO", "COOL", "HEAT", "DRY", "FAN_ONLY"]
 DEFAULT_FAN_MODES = ["AUTO", "MIDDLE", "QUIET", "LOW", "MEDIUM", "HIGH"]
@@ -99,6 +110,43 @@ CN105Climate = cg.global_ns.class_(
 )
 CONF_REMOTE_TEMP_TIMEOUT = "remote_temperature_timeout"
 CONF_DEBOUNCE_DELAY = "debounce_delay"
+CONF_BURST_DURATION = "burst_duration"
+CONF_BURST_UPDATE_INTERVAL = "burst_update_interval"
+CONF_HEARTBEAT_INTERVAL = "heartbeat_interval"
+CONF_HEARTBEAT_MAX_MISSED = "heartbeat_max_missed"
+CONF_HISTORY = "history"
+CONF_METRICS = "metrics"
+CONF_ENERGY = "energy"
+CONF_SAVE_INTERVAL = "save_interval"
+CONF_PUBLISH_INTERVAL = "publish_interval"
+CONF_INTEGRATED_ENERGY = "integrated_energy"
+CONF_ENERGY_COUNTER = "energy_counter"
+CONF_COMPRESSOR_RUNTIME = "compressor_runtime"
+CONF_COMPRESSOR_DUTY_CYCLE = "compressor_duty_cycle"
+CONF_DEFROST_TIME = "defrost_time"
+CONF_PREHEAT_TIME = "preheat_time"
+CONF_MAX_AGE = "max_age"
+CONF_DATA = "data"
+CONF_VANE = "vane"
+CONF_ON_SUCCESS = "on_success"
+CONF_ON_FAILURE = "on_failure"
+
+PublishedSensor = cg.esphome_ns.enum("PublishedSensor")
+EnergyReading = cg.esphome_ns.enum("EnergyReading")
+CN105RefreshAction = cg.global_ns.class_("CN105RefreshAction", automation.Action)
+CN105ApplyAction = cg.global_ns.class_("CN105ApplyAction", automation.Action)
+
+# positions de la vane verticale, mêmes libellés que VANE_MAP
+APPLY_VANE_OPTIONS = ["AUTO", "↑↑", "↑", "—", "↓", "↓↓", "SWING"]
+
+# codes des requêtes info 0x42 pouvant être rafraîchies à la demande
+REFRESH_DATA = {
+    "settings": 0x02,
+    "room_temperature": 0x03,
+    "status": 0x06,
+    "stage": 0x09,
+    "hvac_options": 0x42,
+}
 
 # Définitions des classes C++ (identiques à votre version)
 VaneOrientationSelect = cg.global_ns.class_(
@@ -181,27 +229,169 @@ def get_uart_port_index(core_config, target_uart_id_str):
     return idx
 
 
+def get_cn105_policy_defines(core_config):
+    # Une option qui a la même valeur dans toutes les instances cn105 devient un define:
+    # policies.h en fait une constante et le code de l'autre cas n'est pas compilé.
+    instances = [
+        conf
+        for conf in core_config.get("climate", [])
+        if conf.get("platform") == "cn105"
+    ]
+    if not instances:
+        return []
+    duals = {
+        bool(conf.get(CONF_SUPPORTS, {}).get(CONF_DUAL_SETPOINT, False))
+        for conf in instances
+    }
+    fahrenheits = {
+        bool(conf.get(CONF_FAHRENHEIT_SUPPORT_MODE, False)) for conf in instances
+    }
+    stages = {
+        bool(
+            conf.get(CONF_STAGE_SENSOR, {}).get(
+                CONF_USE_AS_OPERATING_FALLBACK, False
+            )
+        )
+        for conf in instances
+    }
+    defines = []
+    if len(duals) == 1:
+        defines.append(
+            "CN105_SETPOINT_DUAL" if duals.pop() else "CN105_SETPOINT_SINGLE"
+        )
+    if len(fahrenheits) == 1:
+        defines.append(
+            "CN105_UNITS_FAHRENHEIT_COMPAT"
+            if fahrenheits.pop()
+            else "CN105_UNITS_CELSIUS"
+        )
+    if len(stages) == 1:
+        defines.append(
+            "CN105_STAGE_STATUS_ON" if stages.pop() else "CN105_STAGE_STATUS_OFF"
+        )
+    return defines
+
+
+def add_publish_policy(var, published_sensor, conf):
+    if (
+        conf[CONF_DEADBAND] > 0
+        or conf[CONF_MIN_PUBLISH_INTERVAL].total_milliseconds > 0
+        or conf[CONF_MAX_PUBLISH_INTERVAL].total_milliseconds > 0
+    ):
+        cg.add(
+            var.set_publish_policy(
+                published_sensor,
+                conf[CONF_DEADBAND],
+                conf[CONF_MIN_PUBLISH_INTERVAL],
+                conf[CONF_MAX_PUBLISH_INTERVAL],
+            )
+        )
+
+
 # --- FIN de la fonction d'aide ---
 
 # Schémas pour les entités optionnelles (identiques à votre version)
 SELECT_SCHEMA = select.select_schema(VaneOrientationSelect).extend(
     {cv.GenerateID(CONF_ID): cv.declare_id(VaneOrientationSelect)}
 )
-COMPRESSOR_FREQUENCY_SENSOR_SCHEMA = sensor.sensor_schema(
-    CompressorFrequencySensor
-).extend({cv.GenerateID(CONF_ID): cv.declare_id(CompressorFrequencySensor)})
-INPUT_POWER_SENSOR_SCHEMA = sensor.sensor_schema(InputPowerSensor).extend(
-    {cv.GenerateID(CONF_ID): cv.declare_id(InputPowerSensor)}
+
+
+def validate_publish_intervals(config):
+    min_interval = config[CONF_MIN_PUBLISH_INTERVAL].total_milliseconds
+    max_interval = config[CONF_MAX_PUBLISH_INTERVAL].total_milliseconds
+    if min_interval > 0 and max_interval > 0 and max_interval < min_interval:
+        raise cv.Invalid(
+            f"{CONF_MAX_PUBLISH_INTERVAL} must not be shorter than "
+            f"{CONF_MIN_PUBLISH_INTERVAL}"
+        )
+    return config
+
+
+def validate_web_endpoint(value):
+    # /cn105/history et /cn105/metrics sont servis par le serveur web
+    value = cv.boolean(value)
+    if value:
+        cv.requires_component("web_server_base")(value)
+    return value
+
+
+# Filtrage appliqué dans le composant, avant publish_state (0 = désactivé)
+PUBLISH_POLICY_SCHEMA = {
+    cv.Optional(CONF_DEADBAND, default=0.0): cv.positive_float,
+    cv.Optional(
+        CONF_MIN_PUBLISH_INTERVAL, default="0s"
+    ): cv.positive_time_period_milliseconds,
+    cv.Optional(
+        CONF_MAX_PUBLISH_INTERVAL, default="0s"
+    ): cv.positive_time_period_milliseconds,
+}
+
+# Cumuls calculés sur l'ESP; persistés en flash au plus une fois par save_interval
+ENERGY_TOTAL_SENSOR_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_KILOWATT_HOURS,
+    accuracy_decimals=3,
+    device_class=DEVICE_CLASS_ENERGY,
+    state_class=STATE_CLASS_TOTAL_INCREASING,
+)
+ENERGY_DURATION_SENSOR_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_HOUR,
+    icon=ICON_TIMER,
+    accuracy_decimals=2,
+    device_class=DEVICE_CLASS_DURATION,
+    state_class=STATE_CLASS_TOTAL_INCREASING,
+)
+ENERGY_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_SAVE_INTERVAL, default="15min"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(min=cv.TimePeriod(minutes=1)),
+        ),
+        cv.Optional(
+            CONF_PUBLISH_INTERVAL, default="60s"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_INTEGRATED_ENERGY): ENERGY_TOTAL_SENSOR_SCHEMA,
+        cv.Optional(CONF_ENERGY_COUNTER): ENERGY_TOTAL_SENSOR_SCHEMA,
+        cv.Optional(CONF_COMPRESSOR_RUNTIME): ENERGY_DURATION_SENSOR_SCHEMA,
+        cv.Optional(CONF_COMPRESSOR_DUTY_CYCLE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_DEFROST_TIME): ENERGY_DURATION_SENSOR_SCHEMA,
+        cv.Optional(CONF_PREHEAT_TIME): ENERGY_DURATION_SENSOR_SCHEMA,
+    }
+)
+
+COMPRESSOR_FREQUENCY_SENSOR_SCHEMA = cv.All(
+    sensor.sensor_schema(CompressorFrequencySensor)
+    .extend({cv.GenerateID(CONF_ID): cv.declare_id(CompressorFrequencySensor)})
+    .extend(PUBLISH_POLICY_SCHEMA),
+    validate_publish_intervals,
+)
+INPUT_POWER_SENSOR_SCHEMA = cv.All(
+    sensor.sensor_schema(InputPowerSensor)
+    .extend({cv.GenerateID(CONF_ID): cv.declare_id(InputPowerSensor)})
+    .extend(PUBLISH_POLICY_SCHEMA),
+    validate_publish_intervals,
+)
+KWH_SENSOR_SCHEMA = cv.All(
+    sensor.sensor_schema(kWhSensor)
+    .extend({cv.GenerateID(CONF_ID): cv.declare_id(kWhSensor)})
+    .extend(PUBLISH_POLICY_SCHEMA),
+    validate_publish_intervals,
 )
-KWH_SENSOR_SCHEMA = sensor.sensor_schema(kWhSensor).extend(
-    {cv.GenerateID(CONF_ID): cv.declare_id(kWhSensor)}
+RUNTIME_HOURS_SENSOR_SCHEMA = cv.All(
+    sensor.sensor_schema(RuntimeHoursSensor)
+    .extend({cv.GenerateID(CONF_ID): cv.declare_id(RuntimeHoursSensor)})
+    .extend(PUBLISH_POLICY_SCHEMA),
+    validate_publish_intervals,
 )
-RUNTIME_HOURS_SENSOR_SCHEMA = sensor.sensor_schema(RuntimeHoursSensor).extend(
-    {cv.GenerateID(CONF_ID): cv.declare_id(RuntimeHoursSensor)}
+OUTSIDE_AIR_TEMPERATURE_SENSOR_SCHEMA = cv.All(
+    sensor.sensor_schema(OutsideAirTemperatureSensor)
+    .extend({cv.GenerateID(CONF_ID): cv.declare_id(OutsideAirTemperatureSensor)})
+    .extend(PUBLISH_POLICY_SCHEMA),
+    validate_publish_intervals,
 )
-OUTSIDE_AIR_TEMPERATURE_SENSOR_SCHEMA = sensor.sensor_schema(
-    OutsideAirTemperatureSensor
-).extend({cv.GenerateID(CONF_ID): cv.declare_id(OutsideAirTemperatureSensor)})
 ISEE_SENSOR_SCHEMA = binary_sensor.binary_sensor_schema(ISeeSensor).extend(
     {cv.GenerateID(CONF_ID): cv.declare_id(ISeeSensor)}
 )
@@ -305,6 +495,19 @@ CONFIG_SCHEMA = (
             cv.Optional(CONF_DEBOUNCE_DELAY, default="100ms"): cv.All(
                 cv.update_interval
             ),
+            cv.Optional(
+                CONF_BURST_DURATION, default="15s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_BURST_UPDATE_INTERVAL, default="500ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(milliseconds=100)),
+            ),
+            cv.Optional(
+                CONF_HEARTBEAT_INTERVAL, default="5s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_HEARTBEAT_MAX_MISSED, default=3): cv.int_range(
+                min=1, max=255
+            ),
             cv.Optional(
                 CONF_HP_UP_TIME_CONNECTION_SENSOR
             ): HP_UP_TIME_CONNECTION_SENSOR_SCHEMA,
@@ -313,6 +516,9 @@ CONFIG_SCHEMA = (
             cv.Optional(CONF_NIGHT_MODE_SWITCH): HVAC_OPTION_SWITCH_SCHEMA,
             cv.Optional(CONF_CIRCULATOR_SWITCH): HVAC_OPTION_SWITCH_SCHEMA,
             cv.Optional(CONF_HARDWARE_SETTINGS): HARDWARE_SETTING_SCHEMA,
+            cv.Optional(CONF_HISTORY, default=False): validate_web_endpoint,
+            cv.Optional(CONF_METRICS, default=False): validate_web_endpoint,
+            cv.Optional(CONF_ENERGY): ENERGY_SCHEMA,
             cv.Optional(CONF_SUPPORTS, default={}): cv.Schema(
                 {
                     cv.Optional(
@@ -349,6 +555,9 @@ def to_code(config):
     uart_id_str_for_lookup = str(uart_id_object)
     tx_pin, rx_pin = get_uart_pins_from_config(CORE.config, uart_id_str_for_lookup)
     cg.add(var.set_tx_rx_pins(tx_pin, rx_pin))
+
+    for define in get_cn105_policy_defines(CORE.config):
+        cg.add_define(define)
     uart_port_index = get_uart_port_index(CORE.config, uart_id_str_for_lookup)
     cg.add(var.set_uart_port(uart_port_index))
 
@@ -393,6 +602,38 @@ def to_code(config):
 
     cg.add(var.set_remote_temp_timeout(config[CONF_REMOTE_TEMP_TIMEOUT]))
     cg.add(var.set_debounce_delay(config[CONF_DEBOUNCE_DELAY]))
+    cg.add(var.set_burst_duration(config[CONF_BURST_DURATION]))
+    cg.add(var.set_burst_update_interval(config[CONF_BURST_UPDATE_INTERVAL]))
+    cg.add(var.set_heartbeat_interval(config[CONF_HEARTBEAT_INTERVAL]))
+    cg.add(var.set_heartbeat_max_missed(config[CONF_HEARTBEAT_MAX_MISSED]))
+
+    if config[CONF_HISTORY]:
+        cg.add_define("USE_CN105_WEB")
+        cg.add_define("USE_CN105_HISTORY")
+        cg.add(var.enable_history())
+
+    if config[CONF_METRICS]:
+        cg.add_define("USE_CN105_WEB")
+        cg.add_define("USE_CN105_METRICS")
+        cg.add(var.enable_metrics())
+
+    if CONF_ENERGY in config:
+        energy = config[CONF_ENERGY]
+        cg.add_define("USE_CN105_ENERGY")
+        cg.add(
+            var.enable_energy(energy[CONF_SAVE_INTERVAL], energy[CONF_PUBLISH_INTERVAL])
+        )
+        for key, reading in (
+            (CONF_INTEGRATED_ENERGY, EnergyReading.ENERGY_INTEGRATED),
+            (CONF_ENERGY_COUNTER, EnergyReading.ENERGY_COUNTER),
+            (CONF_COMPRESSOR_RUNTIME, EnergyReading.ENERGY_COMPRESSOR_RUNTIME),
+            (CONF_COMPRESSOR_DUTY_CYCLE, EnergyReading.ENERGY_COMPRESSOR_DUTY_CYCLE),
+            (CONF_DEFROST_TIME, EnergyReading.ENERGY_DEFROST_TIME),
+            (CONF_PREHEAT_TIME, EnergyReading.ENERGY_PREHEAT_TIME),
+        ):
+            if key in energy:
+                sensor_var = yield sensor.new_sensor(energy[key])
+                cg.add(var.set_energy_sensor(reading, sensor_var))
 
     # --- Configuration des entités optionnelles (style original) ---
     if CONF_HORIZONTAL_SWING_SELECT in config:
@@ -431,6 +672,9 @@ def to_code(config):
             conf_item["force_update"] = False
         sensor_var = yield sensor.new_sensor(conf_item)
         cg.add(var.set_compressor_frequency_sensor(sensor_var))
+        add_publish_policy(
+            var, PublishedSensor.PUBLISHED_COMPRESSOR_FREQUENCY, conf_item
+        )
 
     if CONF_INPUT_POWER_SENSOR in config:
         conf_item = config[CONF_INPUT_POWER_SENSOR]
@@ -438,6 +682,7 @@ def to_code(config):
             conf_item["force_update"] = False
         sensor_var = yield sensor.new_sensor(conf_item)
         cg.add(var.set_input_power_sensor(sensor_var))
+        add_publish_policy(var, PublishedSensor.PUBLISHED_INPUT_POWER, conf_item)
 
     if CONF_KWH_SENSOR in config:
         conf_item = config[CONF_KWH_SENSOR]
@@ -445,6 +690,7 @@ def to_code(config):
             conf_item["force_update"] = False
         sensor_var = yield sensor.new_sensor(conf_item)
         cg.add(var.set_kwh_sensor(sensor_var))
+        add_publish_policy(var, PublishedSensor.PUBLISHED_KWH, conf_item)
 
     if CONF_RUNTIME_HOURS_SENSOR in config:
         conf_item = config[CONF_RUNTIME_HOURS_SENSOR]
@@ -452,6 +698,7 @@ def to_code(config):
             conf_item["force_update"] = False
         sensor_var = yield sensor.new_sensor(conf_item)
         cg.add(var.set_runtime_hours_sensor(sensor_var))
+        add_publish_policy(var, PublishedSensor.PUBLISHED_RUNTIME_HOURS, conf_item)
 
     if CONF_OUTSIDE_AIR_TEMPERATURE_SENSOR in config:
         conf_item = config[CONF_OUTSIDE_AIR_TEMPERATURE_SENSOR]
@@ -459,6 +706,9 @@ def to_code(config):
             conf_item["force_update"] = False
         sensor_var = yield sensor.new_sensor(conf_item)
         cg.add(var.set_outside_air_temperature_sensor(sensor_var))
+        add_publish_policy(
+            var, PublishedSensor.PUBLISHED_OUTSIDE_TEMPERATURE, conf_item
+        )
 
     if CONF_ISEE_SENSOR in config:
         bsensor_var = yield binary_sensor.new_binary_sensor(config[CONF_ISEE_SENSOR])
@@ -567,3 +817,84 @@ def to_code(config):
 
     yield cg.register_component(var, config)
     yield climate.register_climate(var, config)
+
+
+CN105_REFRESH_ACTION_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(CN105Climate),
+        cv.Optional(CONF_DATA, default="settings"): cv.enum(REFRESH_DATA, lower=True),
+        cv.Optional(CONF_MAX_AGE, default="0s"): cv.templatable(
+            cv.positive_time_period_milliseconds
+        ),
+    }
+)
+
+
+@automation.register_action(
+    "cn105.refresh", CN105RefreshAction, CN105_REFRESH_ACTION_SCHEMA
+)
+async def cn105_refresh_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(var.set_code(config[CONF_DATA]))
+    max_age = await cg.templatable(
+        config[CONF_MAX_AGE], args, cg.uint32, to_exp=lambda x: x.total_milliseconds
+    )
+    cg.add(var.set_max_age(max_age))
+    return var
+
+
+CN105_APPLY_ACTION_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(CN105Climate),
+            cv.Optional(CONF_MODE): cv.templatable(climate.validate_climate_mode),
+            cv.Optional(CONF_TARGET_TEMPERATURE): cv.templatable(cv.temperature),
+            cv.Optional(CONF_FAN_MODE): cv.templatable(climate.validate_climate_fan_mode),
+            cv.Optional(CONF_VANE): cv.templatable(
+                cv.one_of(*APPLY_VANE_OPTIONS, upper=True)
+            ),
+            cv.Optional(CONF_TIMEOUT, default="30s"): cv.templatable(
+                cv.positive_time_period_milliseconds
+            ),
+            cv.Optional(CONF_ON_SUCCESS): automation.validate_action_list,
+            cv.Optional(CONF_ON_FAILURE): automation.validate_action_list,
+        }
+    ),
+    cv.has_at_least_one_key(CONF_MODE, CONF_TARGET_TEMPERATURE, CONF_FAN_MODE, CONF_VANE),
+)
+
+
+@automation.register_action(
+    "cn105.apply", CN105ApplyAction, CN105_APPLY_ACTION_SCHEMA
+)
+async def cn105_apply_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    if CONF_MODE in config:
+        mode = await cg.templatable(config[CONF_MODE], args, climate.ClimateMode)
+        cg.add(var.set_mode(mode))
+    if CONF_TARGET_TEMPERATURE in config:
+        target = await cg.templatable(config[CONF_TARGET_TEMPERATURE], args, cg.float_)
+        cg.add(var.set_target_temperature(target))
+    if CONF_FAN_MODE in config:
+        fan_mode = await cg.templatable(config[CONF_FAN_MODE], args, climate.ClimateFanMode)
+        cg.add(var.set_fan_mode(fan_mode))
+    if CONF_VANE in config:
+        vane = await cg.templatable(config[CONF_VANE], args, cg.std_string)
+        cg.add(var.set_vane(vane))
+    timeout = await cg.templatable(
+        config[CONF_TIMEOUT], args, cg.uint32, to_exp=lambda x: x.total_milliseconds
+    )
+    cg.add(var.set_timeout(timeout))
+    if CONF_ON_SUCCESS in config:
+        actions = await automation.build_action_list(
+            config[CONF_ON_SUCCESS], template_arg, args
+        )
+        cg.add(var.add_on_success(actions))
+    if CONF_ON_FAILURE in config:
+        actions = await automation.build_action_list(
+            config[CONF_ON_FAILURE], template_arg, args
+        )
+        cg.add(var.add_on_failure(actions))
+    return var
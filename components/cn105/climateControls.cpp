@@ -28,23 +28,11 @@ void CN105Climate::checkPendingWantedRunStates() {
     this->sendWantedRunStates();
 }
 
-void logCheckWantedSettingsMutex(wantedHeatpumpSettings& settings) {
-
-    if (settings.hasBeenSent) {
-        ESP_LOGE("control", "Mutex lock faillure: wantedSettings should be locked while sending.");
-        ESP_LOGD("control", "-- This is an assertion test on wantedSettings.hasBeenSent");
-        ESP_LOGD("control", "-- wantedSettings.hasBeenSent = true is unexpected");
-        ESP_LOGD("control", "-- should be false because mutex should prevent running this while sending");
-        ESP_LOGD("control", "-- and mutex should be released only when hasBeenSent is false");
-    }
-
-}
-
 void CN105Climate::controlDelegate(const esphome::climate::ClimateCall& call) {
     ESP_LOGD("control", "espHome control() interface method called...");
     bool updated = false;
 
-    logCheckWantedSettingsMutex(this->wantedSettings);
+    this->stagedDelta_ = SettingsDelta{};
 
     updated = this->processModeChange(call) || updated;
     updated = this->processTemperatureChange(call) || updated;
@@ -66,8 +54,8 @@ bool CN105Climate::processModeChange(const esphome::climate::ClimateCall& call)
     return true;
 }
 
-void CN105Climate::handleDualSetpointBoth(float low, float high) {
-    ESP_LOGD("control", "handleDualSetpointBoth - low: %.1f, high: %.1f", low, high);
+void CN105Climate::handleDualSetpointBoth(HalfDegrees low, HalfDegrees high) {
+    ESP_LOGD("control", "handleDualSetpointBoth - low: %.1f, high: %.1f", low.celsius(), high.celsius());
     this->setTargetTemperatureLow(low);
     this->setTargetTemperatureHigh(high);
     this->last_dual_setpoint_side_ = 'N';
@@ -76,21 +64,21 @@ void CN105Climate::handleDualSetpointBoth(float low, float high) {
     this->currentSettings.dual_high_target = this->getTargetTemperatureHigh();
 }
 
-void CN105Climate::handleDualSetpointLowOnly(float low) {
-    ESP_LOGD("control", "handleDualSetpointLowOnly - LOW: %.1f", low);
+void CN105Climate::handleDualSetpointLowOnly(HalfDegrees low) {
+    ESP_LOGD("control", "handleDualSetpointLowOnly - LOW: %.1f", low.celsius());
     if (this->last_dual_setpoint_side_ == 'H' && (CUSTOM_MILLIS - this->last_dual_setpoint_change_ms_) < UI_SETPOINT_ANTIREBOUND_MS) {
         ESP_LOGD("control", "IGNORED low setpoint due to UI anti-rebound after high change");
         return;
     }
-    if (!std::isnan(this->getTargetTemperatureLow()) && fabsf(low - this->getTargetTemperatureLow()) < 0.05f) {
+    if (this->getTargetTemperatureLow().is_set() && (low == this->getTargetTemperatureLow())) {
         ESP_LOGD("control", "IGNORED low setpoint: no effective change vs current low target");
         return;
     }
     this->setTargetTemperatureLow(low);
     if (this->mode == climate::CLIMATE_MODE_AUTO) {
-        const float amplitude = 4.0f;
+        const HalfDegrees amplitude = HalfDegrees::from_degrees(4);
         this->setTargetTemperatureHigh(this->getTargetTemperatureLow() + amplitude);
-        ESP_LOGD("control", "mode auto: sliding high to preserve amplitude %.1f => [%.1f - %.1f]", amplitude, this->getTargetTemperatureLow(), this->getTargetTemperatureHigh());
+        ESP_LOGD("control", "mode auto: sliding high to preserve amplitude %.1f => [%.1f - %.1f]", amplitude.celsius(), this->getTargetTemperatureLow().celsius(), this->getTargetTemperatureHigh().celsius());
     }
     this->last_dual_setpoint_side_ = 'L';
     this->last_dual_setpoint_change_ms_ = CUSTOM_MILLIS;
@@ -98,21 +86,21 @@ void CN105Climate::handleDualSetpointLowOnly(float low) {
     this->currentSettings.dual_high_target = this->getTargetTemperatureHigh();
 }
 
-void CN105Climate::handleDualSetpointHighOnly(float high) {
-    ESP_LOGI("control", "HIGH: handleDualSetpointHighOnly - HIGH : %.1f", high);
+void CN105Climate::handleDualSetpointHighOnly(HalfDegrees high) {
+    ESP_LOGI("control", "HIGH: handleDualSetpointHighOnly - HIGH : %.1f", high.celsius());
     if (this->last_dual_setpoint_side_ == 'L' && (CUSTOM_MILLIS - this->last_dual_setpoint_change_ms_) < UI_SETPOINT_ANTIREBOUND_MS) {
         ESP_LOGD("control", "ignored high setpoint due to UI anti-rebound after low change");
         return;
     }
-    if (!std::isnan(this->getTargetTemperatureHigh()) && fabsf(high - this->getTargetTemperatureHigh()) < 0.05f) {
+    if (this->getTargetTemperatureHigh().is_set() && (high == this->getTargetTemperatureHigh())) {
         ESP_LOGD("control", "ignored high setpoint: no effective change vs current high target");
         return;
     }
     this->setTargetTemperatureHigh(high);
     if (this->mode == climate::CLIMATE_MODE_AUTO) {
-        const float amplitude = 4.0f;
+        const HalfDegrees amplitude = HalfDegrees::from_degrees(4);
         this->setTargetTemperatureLow(this->getTargetTemperatureHigh() - amplitude);
-        ESP_LOGD("control", "mode auto: sliding low to preserve amplitude %.1f => [%.1f - %.1f]", amplitude, this->getTargetTemperatureLow(), this->getTargetTemperatureHigh());
+        ESP_LOGD("control", "mode auto: sliding low to preserve amplitude %.1f => [%.1f - %.1f]", amplitude.celsius(), this->getTargetTemperatureLow().celsius(), this->getTargetTemperatureHigh().celsius());
     }
     this->last_dual_setpoint_side_ = 'H';
     this->last_dual_setpoint_change_ms_ = CUSTOM_MILLIS;
@@ -120,10 +108,10 @@ void CN105Climate::handleDualSetpointHighOnly(float high) {
     this->currentSettings.dual_high_target = this->getTargetTemperatureHigh();
 }
 
-void CN105Climate::handleSingleTargetInAutoOrDry(float requested) {
-    ESP_LOGD("control", "handleSingleTargetInAutoOrDry - SINGLE: %.1f", requested);
+void CN105Climate::handleSingleTargetInAutoOrDry(HalfDegrees requested) {
+    ESP_LOGD("control", "handleSingleTargetInAutoOrDry - SINGLE: %.1f", requested.celsius());
     if (this->mode == climate::CLIMATE_MODE_AUTO) {
-        const float half_span = 2.0f;
+        const HalfDegrees half_span = HalfDegrees::from_degrees(2);
         this->setTargetTemperatureLow(requested - half_span);
         this->setTargetTemperatureHigh(requested + half_span);
         this->last_dual_setpoint_side_ = 'N';
@@ -131,11 +119,11 @@ void CN105Climate::handleSingleTargetInAutoOrDry(float requested) {
         this->currentSettings.dual_low_target = this->getTargetTemperatureLow();
         this->currentSettings.dual_high_target = this->getTargetTemperatureHigh();
         this->setTargetTemperature(requested);
-        ESP_LOGD("control", "AUTO received single target: median=%.1f => [%.1f - %.1f]", requested, this->getTargetTemperatureLow(), this->getTargetTemperatureHigh());
+        ESP_LOGD("control", "AUTO received single target: median=%.1f => [%.1f - %.1f]", requested.celsius(), this->getTargetTemperatureLow().celsius(), this->getTargetTemperatureHigh().celsius());
     }
     if (this->mode == climate::CLIMATE_MODE_DRY) {
         this->setTargetTemperatureHigh(requested);
-        if (std::isnan(this->getTargetTemperatureLow())) {
+        if (!this->getTargetTemperatureLow().is_set()) {
             this->setTargetTemperatureLow(requested);
         }
         this->last_dual_setpoint_side_ = 'H';
@@ -143,7 +131,7 @@ void CN105Climate::handleSingleTargetInAutoOrDry(float requested) {
         this->currentSettings.dual_low_target = this->getTargetTemperatureLow();
         this->currentSettings.dual_high_target = this->getTargetTemperatureHigh();
         this->setTargetTemperature(requested);
-        ESP_LOGD("control", "DRY received single target: high=%.1f (low now %.1f)", this->getTargetTemperatureHigh(), this->getTargetTemperatureLow());
+        ESP_LOGD("control", "DRY received single target: high=%.1f (low now %.1f)", this->getTargetTemperatureHigh().celsius(), this->getTargetTemperatureLow().celsius());
     }
 }
 
@@ -158,9 +146,9 @@ bool CN105Climate::processTemperatureChange(const esphome::climate::ClimateCall&
         ESP_LOGD("control", "A temperature setpoint value has been provided...");
     }
 
-    float temp_low = NAN;
-    float temp_high = NAN;
-    float temp_single = NAN;
+    HalfDegrees temp_low;
+    HalfDegrees temp_high;
+    HalfDegrees temp_single;
     if (call.get_target_temperature_low().has_value()) {
         temp_low = this->fahrenheitSupport_.normalizeUiTemperatureToHeatpumpTemperature(*call.get_target_temperature_low());
     }
@@ -172,8 +160,8 @@ bool CN105Climate::processTemperatureChange(const esphome::climate::ClimateCall&
     }
 
     // 🔧 FIX: has_feature_flags/CLIMATE_REQUIRES... is not available in your ESPHome build.
-    // Use the traits API that exists: supports two-point target temperature.
-    if (this->traits_.get_supports_two_point_target_temperature()) {
+    // Dual setpoint support comes from the traits, snapshotted once in setup().
+    if (this->hasCapability(CAP_DUAL_SETPOINT)) {
         ESP_LOGD("control", "Processing with dual setpoint support...");
         if (call.get_target_temperature_low().has_value() && call.get_target_temperature_high().has_value()) {
             this->handleDualSetpointBoth(temp_low, temp_high);
@@ -189,12 +177,12 @@ bool CN105Climate::processTemperatureChange(const esphome::climate::ClimateCall&
         ESP_LOGD("control", "Processing without dual setpoint support...");
         if (call.get_target_temperature().has_value()) {
             this->setTargetTemperature(temp_single);
-            ESP_LOGI("control", "Setting heatpump setpoint : %.1f", this->getTargetTemperature());
+            ESP_LOGI("control", "Setting heatpump setpoint : %.1f", this->getTargetTemperature().celsius());
         }
     }
 
     this->controlTemperature();
-    ESP_LOGD("control", "controlled temperature to: %.1f", this->wantedSettings.temperature);
+    ESP_LOGD("control", "controlled temperature to: %.1f", this->stagedDelta_.temperature.celsius());
     return true;
 }
 
@@ -223,58 +211,201 @@ void CN105Climate::finalizeControlIfUpdated(bool updated) {
         return;
     }
     ESP_LOGD(LOG_ACTION_EVT_TAG, "clim.control() -> User changed something...");
-    logCheckWantedSettingsMutex(this->wantedSettings);
-    this->wantedSettings.hasChanged = true;
-    this->wantedSettings.hasBeenSent = false;
-    this->wantedSettings.lastChange = CUSTOM_MILLIS;
-    this->debugSettings("control (wantedSettings)", this->wantedSettings);
-    this->publish_state();
+    this->postStagedDelta();
+    this->publishClimateNow();
 }
 
 void CN105Climate::control(const esphome::climate::ClimateCall& call) {
-#ifdef USE_ESP32
-    std::lock_guard<std::mutex> guard(wantedSettingsMutex);
+    // no lock: the changes are posted to the mailbox and merged into wantedSettings by loop()
     this->controlDelegate(call);
-#else
-    this->emulateMutex("CONTROL_WANTED_SETTINGS", std::bind(&CN105Climate::controlDelegate, this, call));
-#endif
+}
+
+/**
+ * Posts the delta built by the set*Setting() helpers, then starts a new one
+ */
+void CN105Climate::postStagedDelta() {
+    if (this->stagedDelta_.empty()) {
+        return;
+    }
+    this->stagedDelta_.stampMs = CUSTOM_MILLIS;
+    this->lastPostedDelta_ = this->stagedDelta_;
+    if (!this->settingsMailbox_.post(this->stagedDelta_)) {
+        ESP_LOGW(LOG_ACTION_EVT_TAG, "settings mailbox full, user change dropped (%lu so far)",
+            (unsigned long)this->settingsMailbox_.get_dropped());
+    }
+    this->stagedDelta_ = SettingsDelta{};
+}
+
+/**
+ * cn105.apply: the request goes through control() like any HA call (same mailbox, TX queue and ACK tracking),
+ * then waits for a settings readback (0x02) holding every requested value
+ */
+uint32_t CN105Climate::apply(const ApplyRequest& request, uint32_t timeout_ms, std::function<void(bool)>&& callback) {
+    SettingsDelta expected{};
+
+    if (request.mode.has_value() || request.target_temperature.has_value() || request.fan_mode.has_value()) {
+        auto call = this->make_call();
+        if (request.mode.has_value()) call.set_mode(*request.mode);
+        if (request.target_temperature.has_value()) {
+            float requested = *request.target_temperature;
+            if (!this->hasCapability(CAP_DUAL_SETPOINT)) {
+                call.set_target_temperature(requested);
+            } else {
+                // the call validation drops a single target on two-point units: use the side the mode reads
+                climate::ClimateMode mode = request.mode.has_value() ? *request.mode : this->mode;
+                if (mode == climate::CLIMATE_MODE_HEAT) {
+                    call.set_target_temperature_low(requested);
+                } else if (mode == climate::CLIMATE_MODE_COOL || mode == climate::CLIMATE_MODE_DRY) {
+                    call.set_target_temperature_high(requested);
+                } else {
+                    call.set_target_temperature_low(requested - 2.0f);     // median of the range
+                    call.set_target_temperature_high(requested + 2.0f);
+                }
+            }
+        }
+        if (request.fan_mode.has_value()) call.set_fan_mode(*request.fan_mode);
+        this->lastPostedDelta_ = SettingsDelta{};
+        call.perform();                             // synchronous: control() posts its delta before returning
+
+        if (request.target_temperature.has_value()) {
+            // what the encoder will send: whole degrees between 16 and 31 without tempMode
+            HalfDegrees setpoint = this->calculateTemperatureSetting(
+                this->fahrenheitSupport_.normalizeUiTemperatureToHeatpumpTemperature(*request.target_temperature));
+            if (!(this->lastPostedDelta_.fields & DELTA_TEMPERATURE) || this->lastPostedDelta_.temperature != setpoint) {
+                ESP_LOGW(LOG_CONFIRM_TAG, "cn105.apply: setpoint %.1f not accepted in this mode", setpoint.celsius());
+                callback(false);
+                return 0;
+            }
+        }
+        expected.merge(this->lastPostedDelta_);
+    }
+    if (request.vane != nullptr) {
+        int vane = lookupByteMapIndex(VANE_MAP, 7, request.vane, "apply vane");
+        if (vane > -1) {
+            this->stagedDelta_ = SettingsDelta{};
+            this->setVaneSetting(vane);
+            expected.merge(this->stagedDelta_);
+            this->postStagedDelta();
+        }
+    }
+
+    if (expected.empty()) {
+        ESP_LOGW(LOG_CONFIRM_TAG, "cn105.apply: nothing to apply");
+        callback(false);
+        return 0;
+    }
+
+    if (expected.fields & DELTA_TEMPERATURE) {
+        // the readback carries the setpoint as encoded, never finer
+        expected.temperature = this->calculateTemperatureSetting(expected.temperature);
+    }
+
+    uint32_t now = CUSTOM_MILLIS;
+    if (++this->lastApplyId_ == 0) this->lastApplyId_ = 1;     // 0 means "already resolved"
+    ApplyWaiter waiter{ this->lastApplyId_, expected, now, now + timeout_ms, std::move(callback) };
+    // already the unit's confirmed state, and no write in flight that could change it
+    if (!this->confirmations_.any_pending() && expected.matches(this->currentSettings)) {
+        ESP_LOGD(LOG_CONFIRM_TAG, "cn105.apply: heatpump already in the requested state");
+        waiter.callback(true);
+        return 0;
+    }
+    this->applyWaiters_.push_back(std::move(waiter));
+    return this->lastApplyId_;
+}
+
+void CN105Climate::cancel_apply(uint32_t id) {
+    for (auto it = this->applyWaiters_.begin(); it != this->applyWaiters_.end(); ++it) {
+        if (it->id == id) {
+            ESP_LOGD(LOG_CONFIRM_TAG, "cn105.apply cancelled after %u ms", (unsigned) (CUSTOM_MILLIS - it->started_ms));
+            this->applyWaiters_.erase(it);
+            return;
+        }
+    }
+}
+
+void CN105Climate::checkApplyWaiters(const heatpumpSettings& settings) {
+    uint32_t now = CUSTOM_MILLIS;
+    for (auto it = this->applyWaiters_.begin(); it != this->applyWaiters_.end();) {
+        if (it->expected.matches(settings)) {
+            ESP_LOGI(LOG_CONFIRM_TAG, "cn105.apply confirmed in %u ms", (unsigned) (now - it->started_ms));
+            auto callback = std::move(it->callback);
+            it = this->applyWaiters_.erase(it);
+            callback(true);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * Fails the waiters past their deadline, and those expecting a field of a lost settings write
+ * (lostFields: DELTA_* mask of that frame, 0 for a deadline check only)
+ */
+void CN105Climate::failApplyWaiters(uint8_t lostFields) {
+    uint32_t now = CUSTOM_MILLIS;
+    for (auto it = this->applyWaiters_.begin(); it != this->applyWaiters_.end();) {
+        if ((it->expected.fields & lostFields) || (int32_t) (now - it->deadline_ms) >= 0) {
+            ESP_LOGW(LOG_CONFIRM_TAG, "cn105.apply not confirmed after %u ms", (unsigned) (now - it->started_ms));
+            auto callback = std::move(it->callback);
+            it = this->applyWaiters_.erase(it);
+            callback(false);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * Merges the pending user changes into wantedSettings, oldest first
+ * Called from loop() only: wantedSettings has a single writer
+ */
+void CN105Climate::mergeSettingsMailbox() {
+    SettingsDelta delta;
+    bool merged = false;
+    while (this->settingsMailbox_.take(delta)) {
+        delta.applyTo(this->wantedSettings);
+        merged = true;
+    }
+    if (merged) {
+        this->debugSettings("control (wantedSettings)", this->wantedSettings);
+    }
 }
 
 void CN105Climate::controlSwing() {
-    bool wideVaneSupported = this->traits_.supports_swing_mode(climate::CLIMATE_SWING_HORIZONTAL);
-    bool vane_is_swing = (this->currentSettings.vane != nullptr) && (strcmp(this->currentSettings.vane, "SWING") == 0);
-    bool wide_is_swing = (this->currentSettings.wideVane != nullptr) && (strcmp(this->currentSettings.wideVane, "SWING") == 0);
+    bool wideVaneSupported = this->hasCapability(CAP_SWING_HORIZONTAL);
+    bool vane_is_swing = (this->currentSettings.vane == HP_VANE_SWING);
+    bool wide_is_swing = (this->currentSettings.wideVane == HP_WIDEVANE_SWING);
 
     switch (this->swing_mode) {
     case climate::CLIMATE_SWING_OFF:
         if (vane_is_swing) {
-            this->setVaneSetting("AUTO");
+            this->setVaneSetting(HP_VANE_AUTO);
         }
         if (wideVaneSupported && wide_is_swing) {
-            this->setWideVaneSetting("|");
+            this->setWideVaneSetting(HP_WIDEVANE_CENTER);
         }
         break;
 
     case climate::CLIMATE_SWING_VERTICAL:
-        this->setVaneSetting("SWING");
+        this->setVaneSetting(HP_VANE_SWING);
         if (wideVaneSupported && wide_is_swing) {
-            this->setWideVaneSetting("|");
+            this->setWideVaneSetting(HP_WIDEVANE_CENTER);
         }
         break;
 
     case climate::CLIMATE_SWING_HORIZONTAL:
         if (vane_is_swing) {
-            this->setVaneSetting("AUTO");
+            this->setVaneSetting(HP_VANE_AUTO);
         }
         if (wideVaneSupported) {
-            this->setWideVaneSetting("SWING");
+            this->setWideVaneSetting(HP_WIDEVANE_SWING);
         }
         break;
 
     case climate::CLIMATE_SWING_BOTH:
-        this->setVaneSetting("SWING");
+        this->setVaneSetting(HP_VANE_SWING);
         if (wideVaneSupported) {
-            this->setWideVaneSetting("SWING");
+            this->setWideVaneSetting(HP_WIDEVANE_SWING);
         }
         break;
 
@@ -287,52 +418,52 @@ void CN105Climate::controlSwing() {
 void CN105Climate::controlFan() {
     switch (this->fan_mode.value()) {
     case climate::CLIMATE_FAN_OFF:
-        this->setPowerSetting("OFF");
+        this->setPowerSetting(HP_POWER_OFF);
         break;
     case climate::CLIMATE_FAN_QUIET:
-        this->setFanSpeed("QUIET");
+        this->setFanSpeed(HP_FAN_QUIET);
         break;
     case climate::CLIMATE_FAN_DIFFUSE:
-        this->setFanSpeed("QUIET");
+        this->setFanSpeed(HP_FAN_QUIET);
         break;
     case climate::CLIMATE_FAN_LOW:
-        this->setFanSpeed("1");
+        this->setFanSpeed(HP_FAN_1);
         break;
     case climate::CLIMATE_FAN_MEDIUM:
-        this->setFanSpeed("2");
+        this->setFanSpeed(HP_FAN_2);
         break;
     case climate::CLIMATE_FAN_MIDDLE:
-        this->setFanSpeed("3");
+        this->setFanSpeed(HP_FAN_3);
         break;
     case climate::CLIMATE_FAN_HIGH:
-        this->setFanSpeed("4");
+        this->setFanSpeed(HP_FAN_4);
         break;
     case climate::CLIMATE_FAN_ON:
     case climate::CLIMATE_FAN_AUTO:
     default:
-        this->setFanSpeed("AUTO");
+        this->setFanSpeed(HP_FAN_AUTO);
         break;
     }
 }
 
 void CN105Climate::controlTemperature() {
-    float setting;
+    HalfDegrees setting;
 
     // 🔧 FIX: use two-point target support instead of has_feature_flags
-    if (this->traits_.get_supports_two_point_target_temperature()) {
+    if (this->hasCapability(CAP_DUAL_SETPOINT)) {
         this->sanitizeDualSetpoints();
 
         switch (this->mode) {
         case climate::CLIMATE_MODE_AUTO:
-            if (this->traits_.get_supports_two_point_target_temperature()) {
-                if ((!std::isnan(currentSettings.temperature)) && (currentSettings.temperature > 0)) {
-                    this->setTargetTemperatureLow(currentSettings.temperature - 2.0f);
-                    this->setTargetTemperatureHigh(currentSettings.temperature + 2.0f);
+            if (this->hasCapability(CAP_DUAL_SETPOINT)) {
+                if (currentSettings.temperature > HalfDegrees::from_halves(0)) {
+                    this->setTargetTemperatureLow(currentSettings.temperature - HalfDegrees::from_degrees(2));
+                    this->setTargetTemperatureHigh(currentSettings.temperature + HalfDegrees::from_degrees(2));
                     ESP_LOGI("control", "Initializing AUTO mode temps from current PAC temp: %.1f -> [%.1f - %.1f]",
-                        currentSettings.temperature, this->getTargetTemperatureLow(), this->getTargetTemperatureHigh());
+                        currentSettings.temperature.celsius(), this->getTargetTemperatureLow().celsius(), this->getTargetTemperatureHigh().celsius());
                 }
                 setting = currentSettings.temperature;
-                ESP_LOGD("control", "AUTO mode : getting median temperature from current PAC temp: %.1f", setting);
+                ESP_LOGD("control", "AUTO mode : getting median temperature from current PAC temp: %.1f", setting.celsius());
             } else {
                 setting = this->getTargetTemperature();
             }
@@ -340,27 +471,27 @@ void CN105Climate::controlTemperature() {
 
         case climate::CLIMATE_MODE_HEAT:
             setting = this->getTargetTemperatureLow();
-            ESP_LOGD("control", "HEAT mode : getting temperature low:%1.f", this->getTargetTemperatureLow());
+            ESP_LOGD("control", "HEAT mode : getting temperature low:%1.f", setting.celsius());
             break;
 
         case climate::CLIMATE_MODE_COOL:
             setting = this->getTargetTemperatureHigh();
-            ESP_LOGD("control", "COOL mode : getting temperature high:%1.f", this->getTargetTemperatureHigh());
+            ESP_LOGD("control", "COOL mode : getting temperature high:%1.f", setting.celsius());
             break;
 
         case climate::CLIMATE_MODE_DRY:
             setting = this->getTargetTemperatureHigh();
-            ESP_LOGD("control", "DRY mode : getting temperature high:%1.f", this->getTargetTemperatureHigh());
+            ESP_LOGD("control", "DRY mode : getting temperature high:%1.f", setting.celsius());
             break;
 
         default:
             // Other modes : use median temperature
-            if (this->traits_.get_supports_two_point_target_temperature()) {
-                setting = (this->getTargetTemperatureLow() + this->getTargetTemperatureHigh()) / 2.0f;
+            if (this->hasCapability(CAP_DUAL_SETPOINT)) {
+                setting = HalfDegrees::midpoint(this->getTargetTemperatureLow(), this->getTargetTemperatureHigh());
             } else {
                 setting = this->getTargetTemperature();
             }
-            ESP_LOGD("control", "DEFAULT mode : getting temperature median:%1.f", setting);
+            ESP_LOGD("control", "DEFAULT mode : getting temperature median:%1.f", setting.celsius());
             break;
         }
     } else {
@@ -368,40 +499,41 @@ void CN105Climate::controlTemperature() {
     }
 
     setting = this->calculateTemperatureSetting(setting);
-    this->wantedSettings.temperature = setting;
-    ESP_LOGI("control", "setting wanted temperature to %.1f", setting);
+    this->stagedDelta_.temperature = setting;
+    this->stagedDelta_.fields |= DELTA_TEMPERATURE;
+    ESP_LOGI("control", "setting wanted temperature to %.1f", setting.celsius());
 }
 
 void CN105Climate::controlMode() {
     switch (this->mode) {
     case climate::CLIMATE_MODE_COOL:
         ESP_LOGI("control", "changing mode to COOL");
-        this->setModeSetting("COOL");
-        this->setPowerSetting("ON");
+        this->setModeSetting(HP_MODE_COOL);
+        this->setPowerSetting(HP_POWER_ON);
         break;
     case climate::CLIMATE_MODE_HEAT:
         ESP_LOGI("control", "changing mode to HEAT");
-        this->setModeSetting("HEAT");
-        this->setPowerSetting("ON");
+        this->setModeSetting(HP_MODE_HEAT);
+        this->setPowerSetting(HP_POWER_ON);
         break;
     case climate::CLIMATE_MODE_DRY:
         ESP_LOGI("control", "changing mode to DRY");
-        this->setModeSetting("DRY");
-        this->setPowerSetting("ON");
+        this->setModeSetting(HP_MODE_DRY);
+        this->setPowerSetting(HP_POWER_ON);
         break;
     case climate::CLIMATE_MODE_AUTO:
         ESP_LOGI("control", "changing mode to AUTO");
-        this->setModeSetting("AUTO");
-        this->setPowerSetting("ON");
+        this->setModeSetting(HP_MODE_AUTO);
+        this->setPowerSetting(HP_POWER_ON);
         break;
     case climate::CLIMATE_MODE_FAN_ONLY:
         ESP_LOGI("control", "changing mode to FAN_ONLY");
-        this->setModeSetting("FAN");
-        this->setPowerSetting("ON");
+        this->setModeSetting(HP_MODE_FAN);
+        this->setPowerSetting(HP_POWER_ON);
         break;
     case climate::CLIMATE_MODE_OFF:
         ESP_LOGI("control", "changing mode to OFF");
-        this->setPowerSetting("OFF");
+        this->setPowerSetting(HP_POWER_OFF);
         break;
     default:
         ESP_LOGW("control", "unsupported mode");
@@ -409,14 +541,14 @@ void CN105Climate::controlMode() {
 }
 
 void CN105Climate::setActionIfOperatingTo(climate::ClimateAction action_if_operating) {
-    bool stage_is_active = this->use_stage_for_operating_status_ &&
-        this->currentSettings.stage != nullptr &&
-        strcmp(this->currentSettings.stage, STAGE_MAP[0 /*IDLE*/]) != 0;
+    bool stage_is_active = this->useStageForOperatingStatus() &&
+        this->currentSettings.stage != SETTING_UNSET &&
+        this->currentSettings.stage != HP_STAGE_IDLE;
 
     ESP_LOGD(LOG_OPERATING_STATUS_TAG, "Setting action (operating: %s, stage_fallback_enabled: %s, stage: %s, stage_is_active: %s)",
         this->currentStatus.operating ? "true" : "false",
-        this->use_stage_for_operating_status_ ? "yes" : "no",
-        getIfNotNull(this->currentSettings.stage, "N/A"),
+        this->useStageForOperatingStatus() ? "yes" : "no",
+        settingLabel(STAGE_MAP, this->currentSettings.stage, "N/A"),
         stage_is_active ? "yes" : "no");
 
     if (this->currentStatus.operating) {
@@ -424,7 +556,7 @@ void CN105Climate::setActionIfOperatingTo(climate::ClimateAction action_if_opera
         ESP_LOGD(LOG_OPERATING_STATUS_TAG, "Action set by operating status (compressor running)");
     } else if (stage_is_active) {
         this->action = action_if_operating;
-        ESP_LOGD(LOG_OPERATING_STATUS_TAG, "Action set by stage fallback (stage: %s)", this->currentSettings.stage);
+        ESP_LOGD(LOG_OPERATING_STATUS_TAG, "Action set by stage fallback (stage: %s)", STAGE_MAP[this->currentSettings.stage]);
     } else {
         this->action = climate::CLIMATE_ACTION_IDLE;
         ESP_LOGD(LOG_OPERATING_STATUS_TAG, "Action set to IDLE (no activity detected)");
@@ -445,7 +577,7 @@ void CN105Climate::updateAction() {
     ESP_LOGV(TAG, "updating action back to espHome...");
 
     // 🔧 FIX: use two-point target support instead of has_feature_flags
-    if (this->traits().get_supports_two_point_target_temperature()) {
+    if (this->hasCapability(CAP_DUAL_SETPOINT)) {
         this->sanitizeDualSetpoints();
     }
 
@@ -457,8 +589,8 @@ void CN105Climate::updateAction() {
         this->setActionIfOperatingTo(climate::CLIMATE_ACTION_COOLING);
         break;
     case climate::CLIMATE_MODE_AUTO:
-        if (this->traits().supports_mode(climate::CLIMATE_MODE_HEAT) &&
-            this->traits().supports_mode(climate::CLIMATE_MODE_COOL)) {
+        if (this->hasCapability(CAP_MODE_HEAT) &&
+            this->hasCapability(CAP_MODE_COOL)) {
             if (this->getCurrentTemperature() >= this->getTargetTemperatureHigh()) {
                 this->setActionIfOperatingTo(climate::CLIMATE_ACTION_COOLING);
             } else if (this->getCurrentTemperature() <= this->getTargetTemperatureLow()) {
@@ -466,13 +598,13 @@ void CN105Climate::updateAction() {
             } else {
                 this->setActionIfOperatingTo(climate::CLIMATE_ACTION_IDLE);
             }
-        } else if (this->traits().supports_mode(climate::CLIMATE_MODE_COOL)) {
+        } else if (this->hasCapability(CAP_MODE_COOL)) {
             if (this->getCurrentTemperature() < this->getTargetTemperatureHigh()) {
                 this->setActionIfOperatingTo(climate::CLIMATE_ACTION_IDLE);
             } else {
                 this->setActionIfOperatingTo(climate::CLIMATE_ACTION_COOLING);
             }
-        } else if (this->traits().supports_mode(climate::CLIMATE_MODE_HEAT)) {
+        } else if (this->hasCapability(CAP_MODE_HEAT)) {
             if (this->getCurrentTemperature() >= this->getTargetTemperatureLow()) {
                 this->setActionIfOperatingTo(climate::CLIMATE_ACTION_IDLE);
             } else {
@@ -506,58 +638,52 @@ climate::ClimateTraits& CN105Climate::config_traits() {
     return traits_;
 }
 
-void CN105Climate::setModeSetting(const char* setting) {
-    int index = lookupByteMapIndex(MODE_MAP, 5, setting);
-    if (index > -1) {
-        wantedSettings.mode = MODE_MAP[index];
-    } else {
-        wantedSettings.mode = MODE_MAP[0];
-    }
+/**
+ * Les traits sont configurés par le code généré avant setup() et ne changent plus ensuite:
+ * on en garde un masque de bits une fois pour toutes
+ */
+void CN105Climate::snapshotCapabilities() {
+    uint16_t caps = 0;
+    if (this->traits_.get_supports_two_point_target_temperature()) caps |= CAP_DUAL_SETPOINT;
+    if (this->traits_.supports_mode(climate::CLIMATE_MODE_HEAT)) caps |= CAP_MODE_HEAT;
+    if (this->traits_.supports_mode(climate::CLIMATE_MODE_COOL)) caps |= CAP_MODE_COOL;
+    if (this->traits_.supports_mode(climate::CLIMATE_MODE_DRY)) caps |= CAP_MODE_DRY;
+    if (this->traits_.supports_mode(climate::CLIMATE_MODE_FAN_ONLY)) caps |= CAP_MODE_FAN_ONLY;
+    if (this->traits_.supports_mode(climate::CLIMATE_MODE_AUTO)) caps |= CAP_MODE_AUTO;
+    if (this->traits_.supports_swing_mode(climate::CLIMATE_SWING_VERTICAL)) caps |= CAP_SWING_VERTICAL;
+    if (this->traits_.supports_swing_mode(climate::CLIMATE_SWING_HORIZONTAL)) caps |= CAP_SWING_HORIZONTAL;
+    if (this->fahrenheitSupport_.isEnabled()) caps |= CAP_FAHRENHEIT;
+    this->capabilities_ = caps;
+    ESP_LOGI(TAG, "Capabilities: 0x%03X", this->capabilities_);
 }
 
-void CN105Climate::setPowerSetting(const char* setting) {
-    int index = lookupByteMapIndex(POWER_MAP, 2, setting);
-    if (index > -1) {
-        wantedSettings.power = POWER_MAP[index];
-    } else {
-        wantedSettings.power = POWER_MAP[0];
-    }
+void CN105Climate::setModeSetting(uint8_t setting) {
+    this->stagedDelta_.mode = setting < sizeof(MODE) ? setting : 0;
+    this->stagedDelta_.fields |= DELTA_MODE;
 }
 
-void CN105Climate::setFanSpeed(const char* setting) {
-    int index = lookupByteMapIndex(FAN_MAP, 6, setting);
-    if (index > -1) {
-        wantedSettings.fan = FAN_MAP[index];
-    } else {
-        wantedSettings.fan = FAN_MAP[0];
-    }
+void CN105Climate::setPowerSetting(uint8_t setting) {
+    this->stagedDelta_.power = setting < sizeof(POWER) ? setting : 0;
+    this->stagedDelta_.fields |= DELTA_POWER;
 }
 
-void CN105Climate::setVaneSetting(const char* setting) {
-    int index = lookupByteMapIndex(VANE_MAP, 7, setting);
-    if (index > -1) {
-        wantedSettings.vane = VANE_MAP[index];
-    } else {
-        wantedSettings.vane = VANE_MAP[0];
-    }
+void CN105Climate::setFanSpeed(uint8_t setting) {
+    this->stagedDelta_.fan = setting < sizeof(FAN) ? setting : 0;
+    this->stagedDelta_.fields |= DELTA_FAN;
 }
 
-void CN105Climate::setWideVaneSetting(const char* setting) {
-    int index = lookupByteMapIndex(WIDEVANE_MAP, 8, setting);
-    if (index > -1) {
-        wantedSettings.wideVane = WIDEVANE_MAP[index];
-    } else {
-        wantedSettings.wideVane = WIDEVANE_MAP[0];
-    }
+void CN105Climate::setVaneSetting(uint8_t setting) {
+    this->stagedDelta_.vane = setting < sizeof(VANE) ? setting : 0;
+    this->stagedDelta_.fields |= DELTA_VANE;
 }
 
-void CN105Climate::setAirflowControlSetting(const char* setting) {
-    int index = lookupByteMapIndex(AIRFLOW_CONTROL_MAP, 3, setting);
-    if (index > -1) {
-        wantedRunStates.airflow_control = AIRFLOW_CONTROL_MAP[index];
-    } else {
-        wantedRunStates.airflow_control = AIRFLOW_CONTROL_MAP[0];
-    }
+void CN105Climate::setWideVaneSetting(uint8_t setting) {
+    this->stagedDelta_.wideVane = setting < sizeof(WIDEVANE) ? setting : 0;
+    this->stagedDelta_.fields |= DELTA_WIDEVANE;
+}
+
+void CN105Climate::setAirflowControlSetting(uint8_t setting) {
+    wantedRunStates.airflow_control = setting < sizeof(AIRFLOW_CONTROL) ? setting : 0;
 }
 
 void CN105Climate::set_remote_temperature(float setting) {
@@ -569,7 +695,7 @@ void CN105Climate::set_remote_temperature(float setting) {
     // Toujours renvoyer la température distante lorsqu’un nouvel échantillon arrive,
     // même si la valeur n’a pas changé, afin d’éviter que l’unité Mitsubishi
     // ne repasse sur la sonde interne faute de mise à jour régulière (#474).
-    this->remoteTemperature_ = setting;
+    this->remoteTemperature_ = HalfDegrees::from_celsius(setting);
     this->shouldSendExternalTemperature_ = true;
-    ESP_LOGD(LOG_REMOTE_TEMP, "setting remote temperature to %f", this->remoteTemperature_);
+    ESP_LOGD(LOG_REMOTE_TEMP, "setting remote temperature to %.1f", this->remoteTemperature_.celsius());
 }
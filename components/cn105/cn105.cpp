@@ -8,6 +8,23 @@
 
 using namespace esphome;
 
+static_assert(DELTA_POWER == (1 << CONFIRM_POWER) && DELTA_MODE == (1 << CONFIRM_MODE) &&
+    DELTA_TEMPERATURE == (1 << CONFIRM_TEMPERATURE) && DELTA_FAN == (1 << CONFIRM_FAN) &&
+    DELTA_VANE == (1 << CONFIRM_VANE) && DELTA_WIDEVANE == (1 << CONFIRM_WIDEVANE),
+    "settings delta and confirmation masks must share their bits");
+
+// champs portés par une trame 0x01, en masque DELTA_* (== 1 << ConfirmField)
+static uint8_t settingsFieldsOf(const uint8_t* packet) {
+    uint8_t fields = 0;
+    if (packet[FIELD_POWER.flag_byte] & FIELD_POWER.flag_mask) fields |= DELTA_POWER;
+    if (packet[FIELD_MODE.flag_byte] & FIELD_MODE.flag_mask) fields |= DELTA_MODE;
+    if (packet[FIELD_TEMPERATURE.flag_byte] & FIELD_TEMPERATURE.flag_mask) fields |= DELTA_TEMPERATURE;
+    if (packet[FIELD_FAN.flag_byte] & FIELD_FAN.flag_mask) fields |= DELTA_FAN;
+    if (packet[FIELD_VANE.flag_byte] & FIELD_VANE.flag_mask) fields |= DELTA_VANE;
+    if (packet[FIELD_WIDEVANE.flag_byte] & FIELD_WIDEVANE.flag_mask) fields |= DELTA_WIDEVANE;
+    return fields;
+}
+
 CN105Climate::CN105Climate(uart::UARTComponent* uart) :
     UARTDevice(uart),
     scheduler_(
@@ -21,6 +38,23 @@ CN105Climate::CN105Climate(uart::UARTComponent* uart) :
         [this]() { this->terminateCycle(); },
         // context_callback: retourne this pour les callbacks canSend et onResponse
         [this]() -> CN105Climate* { return this; }
+    ),
+    writeTxns_(
+        // resend_callback: renvoie une écriture non acquittée
+        [this](uint8_t* packet, int length) { return this->resendPacket(packet, length); },
+        // outcome_callback: une écriture perdue est un échec de liaison (et du repos armé, s'il y en a un)
+        [this](uint8_t type, bool acked, const uint8_t* packet) {
+            if (!acked) {
+                this->reportLinkError("write not acknowledged");
+                if (type == 0x01) {
+                    // these settings never reached the unit: no readback will confirm them
+                    // (fields rewritten by a newer frame are no longer in the tracked packet)
+                    uint8_t lost = settingsFieldsOf(packet);
+                    this->rollbackUnconfirmedSettings(this->confirmations_.abandon(lost));
+                    this->failApplyWaiters(lost);
+                }
+            }
+        }
     ) {
 
     // ✅ ESPHome-yhteensopiva tapa: älä käytä feature_flags-APIa (puuttuu sun buildissä)
@@ -73,9 +107,6 @@ CN105Climate::CN105Climate(uart::UARTComponent* uart) :
     this->loopCycle.init();
     this->wantedSettings.resetSettings();
     this->wantedRunStates.resetSettings();
-#ifndef USE_ESP32
-    this->wantedSettingsMutex = false;
-#endif
 
     // Register info requests moved to setup() to ensure hardware_settings_ are populated
 }
@@ -85,6 +116,7 @@ void CN105Climate::registerInfoRequests() {
 
     // 0x02 Settings
     InfoRequest r_settings("settings", "Settings", 0x02, 3, 0);
+    r_settings.burst = true;
     r_settings.onResponse = [this](CN105Climate& self) { (void)self; this->getSettingsFromResponsePacket(); };
     scheduler_.register_request(r_settings);
 
@@ -95,16 +127,19 @@ void CN105Climate::registerInfoRequests() {
 
     // 0x06 Status
     InfoRequest r_status("status", "Status", 0x06, 3, 0);
+    r_status.burst = true;
     r_status.onResponse = [this](CN105Climate& self) { (void)self; this->getOperatingAndCompressorFreqFromResponsePacket(); };
     scheduler_.register_request(r_status);
 
     // 0x09 Standby/Power
     InfoRequest r_power("standby", "Power/Standby", 0x09, 3, 500);
+    r_power.burst = true;
     r_power.onResponse = [this](CN105Climate& self) { (void)self; this->getPowerFromResponsePacket(); };
     scheduler_.register_request(r_power);
 
     // 0x42 HVAC options
     InfoRequest r_hvac_opts("hvac_options", "HVAC options", 0x42, 3, 500);
+    r_hvac_opts.burst = true;
     r_hvac_opts.canSend = [this](const CN105Climate& self) {
         (void)self;
         return (this->air_purifier_switch_ != nullptr || this->night_mode_switch_ != nullptr || this->circulator_switch_ != nullptr);
@@ -217,6 +252,26 @@ void CN105Climate::set_debounce_delay(uint32_t delay) {
     log_info_uint32(LOG_ACTION_EVT_TAG, "set_debounce_delay is set to ", delay);
 }
 
+void CN105Climate::set_burst_duration(uint32_t duration) {
+    this->burst_duration_ms_ = duration;
+    log_info_uint32(LOG_CYCLE_TAG, "burst_duration is set to ", duration, " ms");
+}
+
+void CN105Climate::set_burst_update_interval(uint32_t interval) {
+    this->burst_update_interval_ms_ = interval;
+    log_info_uint32(LOG_CYCLE_TAG, "burst_update_interval is set to ", interval, " ms");
+}
+
+void CN105Climate::set_heartbeat_interval(uint32_t interval) {
+    this->heartbeat_interval_ms_ = interval;
+    log_info_uint32(LOG_CYCLE_TAG, "heartbeat_interval is set to ", interval, " ms");
+}
+
+void CN105Climate::set_heartbeat_max_missed(uint8_t max_missed) {
+    this->heartbeat_max_missed_ = max_missed;
+    log_info_uint32(LOG_CYCLE_TAG, "heartbeat_max_missed is set to ", max_missed);
+}
+
 float CN105Climate::get_compressor_frequency() {
     return currentStatus.compressorFrequency;
 }
@@ -246,6 +301,10 @@ bool CN105Climate::is_circulator() {
 void CN105Climate::setupUART() {
 
     log_info_uint32(TAG, "setupUART() with baudrate ", this->parent_->get_baud_rate());
+    this->writeTxns_.set_baud_rate(this->parent_->get_baud_rate());
+    if (this->parent_->get_baud_rate() > 0) {
+        this->txByteTimeUs_ = 11 * 1000000 / this->parent_->get_baud_rate();
+    }
     this->setHeatpumpConnected(false);
     this->isUARTConnected_ = false;
 
@@ -281,12 +340,14 @@ void CN105Climate::disconnectUART() {
     this->uart_setup_switch = false;
     this->setHeatpumpConnected(false);
     this->firstRun = true;
-    this->publish_state();
+    this->publishClimateNow();
 }
 
 void CN105Climate::reconnectUART() {
     ESP_LOGD(TAG, "reconnectUART()");
     this->lastReconnectTimeMs = CUSTOM_MILLIS;
+    this->linkStats_.reconnects++;
+    this->writeTxns_.clear();           // the unit will be fully resynced after the handshake
     this->disconnectUART();
     this->force_low_level_uart_reinit();
     this->setupUART();
@@ -21,6 +21,18 @@
 #include "localization.h"
 #include "info_request.h"
 #include "request_scheduler.h"
+#include "pacing_controller.h"
+#include "write_transactions.h"
+#include "tx_queue.h"
+#include "packet_encoder.h"
+#include "settings_mailbox.h"
+#include "confirmation_tracker.h"
+#include "state_snapshot.h"
+#include "publish_policy.h"
+#include "history.h"
+#include "energy_integrator.h"
+#include "web_handler.h"
+#include "metrics.h"
 #include <esphome/components/sensor/sensor.h>
 #include <esphome/components/button/button.h>
 #include <esphome/components/binary_sensor/binary_sensor.h>
@@ -28,7 +40,7 @@
 #include <vector>
 #include <map>
 
-#ifdef USE_ESP32
+#if defined(USE_ESP32) && defined(TEST_MODE)
 #include <mutex>
 #endif
 
@@ -53,6 +65,7 @@ namespace esphome {
         void set_kwh_sensor(esphome::sensor::Sensor* kwh_sensor);
         void set_runtime_hours_sensor(esphome::sensor::Sensor* runtime_hours_sensor);
         void set_outside_air_temperature_sensor(esphome::sensor::Sensor* outside_air_temperature_sensor);
+        void set_publish_policy(PublishedSensor sensor, float deadband, uint32_t min_interval_ms, uint32_t max_interval_ms);
         void set_isee_sensor(esphome::binary_sensor::BinarySensor* iSee_sensor);
         void set_stage_sensor(esphome::text_sensor::TextSensor* Stage_sensor);
         void set_use_stage_for_operating_status(bool value);
@@ -78,6 +91,7 @@ namespace esphome {
         binary_sensor::BinarySensor* iSee_sensor_ = nullptr;
         text_sensor::TextSensor* stage_sensor_{ nullptr }; // to save ref if needed
         bool use_stage_for_operating_status_{ false };
+        bool useStageForOperatingStatus() const { return cn105_policy::StageStatus::enabled(this->use_stage_for_operating_status_); }
         FahrenheitSupport fahrenheitSupport_;
         text_sensor::TextSensor* Functions_sensor_ = nullptr;
         FunctionsButton* Functions_get_button_ = nullptr;
@@ -92,6 +106,11 @@ namespace esphome {
         std::vector<HardwareSettingSelect*> hardware_settings_;
         uint32_t hardware_settings_interval_ms_{ 86400000 };  // Default 24h
 
+        // hardware select changes collected for HW_SETTINGS_BATCH_WINDOW_MS, then read-modify-write-verify as one transaction
+        std::vector<std::pair<int, int>> hwSettingsStaged_;   // code, value
+        heatpumpFunctions hwSettingsExpected_;
+        bool hwSettingsBatchInFlight_{ false };
+
         // The value of the code and value for the functions set.
         int functions_code_;
         int functions_value_;
@@ -125,12 +144,43 @@ namespace esphome {
         float get_kwh();
         float get_runtime_hours();
         bool is_operating();
+
+        // état décodé d'un bloc, cohérent entre champs et horodaté champ par champ (voir state_snapshot.h)
+        // borné: si l'écriture ne se termine pas, renvoie un snapshot vide (version 0, aucun champ reçu)
+        StateSnapshot snapshot() const {
+            StateSnapshot out;
+            if (!this->snapshot_.read(out)) {
+                out = StateSnapshot{};
+            }
+            return out;
+        }
+        bool try_snapshot(StateSnapshot& out) const { return this->snapshot_.try_read(out); }
+
+#ifdef USE_CN105_HISTORY
+        // historique 1 min / 15 min servi sur /cn105/history (voir history.h)
+        void enable_history();
+        bool hasHistory() const { return this->history_ != nullptr; }
+        void dumpHistory(const std::function<void(const char*)>& write) const;
+#endif
+#ifdef USE_CN105_METRICS
+        // compteurs internes servis sur /cn105/metrics (voir metrics.h)
+        void enable_metrics() { this->metricsEnabled_ = true; }
+        bool hasMetrics() const { return this->metricsEnabled_; }
+#endif
+#ifdef USE_CN105_ENERGY
+        // cumuls d'énergie / compresseur / dégivrage calculés sur l'ESP (voir energy_integrator.h)
+        void enable_energy(uint32_t save_interval_ms, uint32_t publish_interval_ms);
+        void set_energy_sensor(EnergyReading reading, sensor::Sensor* sensor);
+        float get_energy_reading(EnergyReading reading) const;
+        void on_safe_shutdown() override;
+#endif
         bool is_air_purifier();
         bool is_night_mode();
         bool is_circulator();
 
         // checks if the field has changed
         bool hasChanged(const char* before, const char* now, const char* field, bool checkNotNull = false);
+        bool hasChanged(uint8_t before, uint8_t now, const char* field, bool checkNotNull = false);
 
 
         float get_setup_priority() const override {
@@ -168,6 +218,38 @@ namespace esphome {
 
         void set_debounce_delay(uint32_t delay);
 
+        // post-command burst polling: faster cycles for a short window after a user command
+        void set_burst_duration(uint32_t duration);
+        void set_burst_update_interval(uint32_t interval);
+        void armBurstMode(const char* reason);
+
+        // liveness heartbeat: a single info request when the bus has been idle for heartbeat_interval
+        void set_heartbeat_interval(uint32_t interval);
+        void set_heartbeat_max_missed(uint8_t max_missed);
+
+        // read-through refresh of one info code (0x02 settings, 0x03 room temp, 0x06 status, 0x09 stage, 0x42 options)
+        void refresh(uint8_t code, uint32_t max_age_ms, std::function<void(bool)>&& callback);
+        // set-and-confirm: callback(true) once a settings readback carries every requested value, false at the deadline
+        struct ApplyRequest {
+            optional<climate::ClimateMode> mode;
+            optional<float> target_temperature;
+            optional<climate::ClimateFanMode> fan_mode;
+            const char* vane = nullptr;
+        };
+        // returns a waiter id for cancel_apply(), 0 when the callback already ran
+        uint32_t apply(const ApplyRequest& request, uint32_t timeout_ms, std::function<void(bool)>&& callback);
+        // drops a pending apply without calling its callback (action stopped)
+        void cancel_apply(uint32_t id);
+        // per write type ACK latency and loss (0x01 settings, 0x07 remote temp, 0x08 run states, 0x1F/0x21 functions)
+        const WriteTransactions::Stats& get_write_stats(uint8_t type) const { return this->writeTxns_.get_stats(type); }
+        const ConfirmationTracker::Stats& get_confirmation_stats(ConfirmField field) const { return this->confirmations_.get_stats(field); }
+        // time until the last byte handed to the UART has left the FIFO
+        uint32_t getTxRemainingMs() const;
+        // age in ms of the last decoded response for an info code, UINT32_MAX if never received
+        uint32_t get_data_age(uint8_t code) const;
+        bool isBurstModeActive();
+        uint32_t getEffectiveUpdateInterval();
+
         // this is the ping or heartbeat of the setRemotetemperature for timeout management
         void pingExternalTemperature();
 
@@ -179,19 +261,23 @@ namespace esphome {
         // Get a mutable reference to the traits that we support.
         climate::ClimateTraits& config_traits();
 
+        // capacités figées dans setup() (ou à la compilation, voir policies.h), le code interne n'appelle pas traits()
+        bool hasCapability(Capability capability) const { return (cn105_policy::capabilities(this->capabilities_) & capability) != 0; }
+
         void control(const esphome::climate::ClimateCall& call) override;
         void controlMode();
         void controlTemperature();
-        float calculateTemperatureSetting(float setting);
-        float getTargetTemperatureInCurrentMode();
-        float getTargetTemperature();
-        float getTargetTemperatureLow();
-        float getTargetTemperatureHigh();
-        float getCurrentTemperature();
-        void setTargetTemperature(float temperature);
-        void setTargetTemperatureLow(float temperature);
-        void setTargetTemperatureHigh(float temperature);
-        void setCurrentTemperature(float temperature);
+        // the climate's float fields are read and written here only, in unit half degrees (Fahrenheit mode applied)
+        HalfDegrees calculateTemperatureSetting(HalfDegrees setting);
+        HalfDegrees getTargetTemperatureInCurrentMode();
+        HalfDegrees getTargetTemperature();
+        HalfDegrees getTargetTemperatureLow();
+        HalfDegrees getTargetTemperatureHigh();
+        HalfDegrees getCurrentTemperature();
+        void setTargetTemperature(HalfDegrees temperature);
+        void setTargetTemperatureLow(HalfDegrees temperature);
+        void setTargetTemperatureHigh(HalfDegrees temperature);
+        void setCurrentTemperature(HalfDegrees temperature);
 
         void controlFan();
         void controlSwing();
@@ -205,15 +291,23 @@ namespace esphome {
         bool isUARTConnected_ = false;
         bool isHeatpumpConnected_ = false;
         bool shouldSendExternalTemperature_ = false;
-        float remoteTemperature_ = 0;
+        HalfDegrees remoteTemperature_;
 
         unsigned long nbCompleteCycles_ = 0;
         unsigned long nbCycles_ = 0;
+        unsigned long nbSkippedSettingsWrites_ = 0;     // settings writes dropped because nothing differed
         unsigned int nbHeatpumpConnections_ = 0;
+        LinkStats linkStats_{};
+#ifdef USE_CN105_METRICS
+        bool metricsEnabled_ = false;
+        friend class MetricsExporter;
+#endif
 
 
         void sendFirstConnectionPacket();
         void terminateCycle();
+        // lost or corrupted reply: the pacing controller backs off
+        void reportLinkError(const char* reason);
         //bool can_proceed() override;
 
 
@@ -221,6 +315,12 @@ namespace esphome {
         void getFunctionsPart2();
         void functionsArrived();
         bool setFunctions(heatpumpFunctions const& functions);
+        bool writeFunctionParts(heatpumpFunctions const& functions, bool part1, bool part2);
+        void stageHardwareSetting(int code, int value);
+        void commitHardwareSettingsBatch();
+        void writeHardwareSettingsBatch(bool fresh);
+        void verifyHardwareSettingsBatch(bool fresh);
+        bool isHardwareSettingStaged(int code) const;
 
         // helpers
         const char* getIfNotNull(const char* what, const char* defaultValue);
@@ -245,6 +345,9 @@ namespace esphome {
         uint32_t update_interval_;
 
         climate::ClimateTraits traits_;
+        uint16_t capabilities_ = 0;     // masque de Capability, calculé une fois par snapshotCapabilities()
+
+        void snapshotCapabilities();
 
         //Accessor method for the HardwareSerial pointer
         uart::UARTComponent* get_hw_serial_() {
@@ -267,47 +370,69 @@ namespace esphome {
         void updateSuccess();
         void processCommand();
         bool checkSum();
-        uint8_t checkSum(uint8_t bytes[], int len);
-
-        const char* getModeSetting();
-        const char* getPowerSetting();
-        const char* getVaneSetting();
-        const char* getWideVaneSetting();
-        const char* getAirflowControlSetting();
-        const char* getFanSpeedSetting();
-        float getTemperatureSetting();
+
+        uint8_t getModeSetting();
+        uint8_t getPowerSetting();
+        uint8_t getVaneSetting();
+        uint8_t getWideVaneSetting();
+        uint8_t getAirflowControlSetting();
+        uint8_t getFanSpeedSetting();
+        HalfDegrees getTemperatureSetting();
         bool getAirPurifierRunState();
         bool getNightModeRunState();
         bool getCirculatorRunState();
 
-        void setModeSetting(const char* setting);
-        void setPowerSetting(const char* setting);
-        void setVaneSetting(const char* setting);
-        void setWideVaneSetting(const char* setting);
-        void setAirflowControlSetting(const char* setting);
-        void setFanSpeed(const char* setting);
+        // setting: index in the matching table (ModeSetting, PowerSetting, VaneSetting...)
+        void setModeSetting(uint8_t setting);
+        void setPowerSetting(uint8_t setting);
+        void setVaneSetting(uint8_t setting);
+        void setWideVaneSetting(uint8_t setting);
+        void setAirflowControlSetting(uint8_t setting);
+        void setFanSpeed(uint8_t setting);
 
         void setHeatpumpConnected(bool state);
 
     private:
         void force_low_level_uart_reinit();
         int uart_port_ = -1;
-        const char* lookupByteMapValue(const char* valuesMap[], const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo = "", const char* defaultValue = nullptr);
-        int lookupByteMapValue(const int valuesMap[], const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo = "");
-        int lookupByteMapIndex(const char* valuesMap[], int len, const char* lookupValue, const char* debugInfo = "");
-        int lookupByteMapIndex(const int valuesMap[], int len, int lookupValue, const char* debugInfo = "");
+        uint8_t decodeSettingByte(const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo = "");
+        int lookupByteMapIndex(const char* const valuesMap[], int len, const char* lookupValue, const char* debugInfo = "");
 
-        void writePacket(uint8_t* packet, int length, bool checkIsActive = true);
-        void prepareInfoPacket(uint8_t* packet, int length);
-        void prepareSetPacket(uint8_t* packet, int length);
+        // false if the frame was neither sent nor queued (only 0x41 set frames are queued)
+        bool writePacket(uint8_t* packet, int length, bool checkIsActive = true);
 
         void publishStateToHA(heatpumpSettings& settings);
+
+        // les trames reçues marquent l'entité climate, elle est publiée une fois en fin de cycle
+        bool climateDirty_ = false;
+        void markClimateDirty() { this->climateDirty_ = true; }
+        void flushClimateState();
+        // retour immédiat vers HA (changement utilisateur, retour arrière, déconnexion)
+        void publishClimateNow();
         void publishWantedSettingsStateToHA();
+        void expectSettingsConfirmation();
+        void rollbackUnconfirmedSettings(uint8_t fields);
+        void checkConfirmationDeadlines();
         void publishWantedRunStatesStateToHA();
 
         void heatpumpUpdate(heatpumpSettings& settings);
 
         void statusChanged(heatpumpStatus status);
+        void publishStatusSensors();
+        void publishSensor(PublishedSensor which, sensor::Sensor* sensor, float value);
+        PublishPolicy publishPolicies_[PUBLISHED_SENSOR_COUNT];
+
+#ifdef USE_CN105_HISTORY
+        HistoryRecorder* history_ = nullptr;
+#endif
+#ifdef USE_CN105_ENERGY
+        void setupEnergy();
+        void publishEnergySensors();
+        EnergyIntegrator* energy_ = nullptr;
+        uint32_t energy_save_interval_ms_ = 0;
+        uint32_t energy_publish_interval_ms_ = 0;
+        sensor::Sensor* energySensors_[ENERGY_READING_COUNT] = {};
+#endif
 
         void checkPendingWantedSettings();
         void checkPendingWantedRunStates();
@@ -317,7 +442,7 @@ namespace esphome {
         void checkWideVaneSettings(heatpumpSettings& settings, bool updateCurrentSettings = true);
         //        void checkAirflowControlSettings(heatpumpRunStates& settings, bool updateCurrentSettings = true);
         void updateExtraSelectComponents(heatpumpSettings& settings);
-        void updateTargetTemperaturesFromSettings(float temperature);
+        void updateTargetTemperaturesFromSettings(HalfDegrees temperature);
 
         //void statusChanged();
         void updateAction();
@@ -332,9 +457,9 @@ namespace esphome {
         void debugSettingsAndStatus(const char* settingName, heatpumpSettings settings, heatpumpStatus status);
         void debugClimate(const char* settingName);
 
-#ifndef USE_ESP32
-        void emulateMutex(const char* retryName, std::function<void()>&& f);
-#endif
+        // user setting changes travel from control()/selects to loop() through this mailbox
+        void postStagedDelta();
+        void mergeSettingsMailbox();
 
 
 
@@ -346,29 +471,58 @@ namespace esphome {
         bool processSwingChange(const esphome::climate::ClimateCall& call);
         void finalizeControlIfUpdated(bool updated);
         // Temperature handling helpers (dual setpoint variants)
-        void handleDualSetpointBoth(float low, float high);
-        void handleDualSetpointLowOnly(float low);
-        void handleDualSetpointHighOnly(float high);
-        void handleSingleTargetInAutoOrDry(float requested);
+        void handleDualSetpointBoth(HalfDegrees low, HalfDegrees high);
+        void handleDualSetpointLowOnly(HalfDegrees low);
+        void handleDualSetpointHighOnly(HalfDegrees high);
+        void handleSingleTargetInAutoOrDry(HalfDegrees requested);
 
-        void createPacket(uint8_t* packet);
+        void dropUnchangedWantedSettings();
+        bool createPacket(uint8_t* packet);
         void createInfoPacket(uint8_t* packet, uint8_t code);
         heatpumpSettings currentSettings{};
         wantedHeatpumpSettings wantedSettings{};
         heatpumpRunStates currentRunStates{};
         wantedHeatpumpRunStates wantedRunStates{};
         cycleManagement loopCycle{};
+        PacingController pacing_{};
 
         // Orchestrateur des requêtes INFO
         RequestScheduler scheduler_;
         void registerInfoRequests();
+
+        // 0x41 writes awaiting their 0x61 ACK
+        WriteTransactions writeTxns_;
+        // optimistic settings awaiting their readback
+        ConfirmationTracker confirmations_;
+
+        // écrit par les décodeurs de trames uniquement, lu par snapshot()
+        SeqLock<StateSnapshot> snapshot_;
+        template<typename F>
+        void updateSnapshot(F&& update) {
+            this->snapshot_.write([&](StateSnapshot& state) {
+                state.version++;
+                update(state, static_cast<uint32_t>(CUSTOM_MILLIS));
+            });
+        }
+        uint32_t resendPacket(uint8_t* packet, int length);
         void registerHardwareSettingsRequests();
 
-#ifdef USE_ESP32
-        std::mutex wantedSettingsMutex;
-#else
-        volatile bool wantedSettingsMutex = false;
-#endif
+        SettingsDelta stagedDelta_{};               // built by the producer, posted as a whole
+        SettingsDelta lastPostedDelta_{};
+
+        // cn105.apply calls waiting for their readback
+        struct ApplyWaiter {
+            uint32_t id;
+            SettingsDelta expected;
+            uint32_t started_ms;
+            uint32_t deadline_ms;
+            std::function<void(bool)> callback;
+        };
+        std::vector<ApplyWaiter> applyWaiters_;
+        uint32_t lastApplyId_ = 0;
+        void checkApplyWaiters(const heatpumpSettings& settings);
+        void failApplyWaiters(uint8_t lostFields);
+        SettingsMailbox<8> settingsMailbox_;
 
         unsigned long lastResponseMs;
 
@@ -376,6 +530,18 @@ namespace esphome {
         uint32_t remote_temp_timeout_;
         uint32_t debounce_delay_;
 
+        uint32_t burst_duration_ms_ = 15000;
+        uint32_t burst_update_interval_ms_ = 500;
+        uint32_t burst_started_ms_ = 0;
+        bool burst_armed_ = false;
+
+        uint32_t heartbeat_interval_ms_ = 5000;
+        uint8_t heartbeat_max_missed_ = 3;
+        uint8_t heartbeat_missed_ = 0;
+        uint32_t last_heartbeat_ms_ = 0;
+        bool heartbeat_pending_ = false;
+        bool sendHeartbeatIfIdle();
+
         int baud_ = 0;
         int tx_pin_ = -1;
         int rx_pin_ = -1;
@@ -383,7 +549,14 @@ namespace esphome {
 
 
         //HardwareSerial* _HardSerial{ nullptr };
-        unsigned long lastSend;
+        unsigned long lastSend;             // end of transmission of the last frame (may be a few ms ahead)
+
+        // TX: frames are handed to the UART in one write_array(), the end of transmission is computed from the baud rate
+        uint32_t txDoneMs_ = 0;
+        uint32_t txByteTimeUs_ = 11 * 1000000 / 2400;      // 8E1: 11 bits per byte
+        bool txBurstOpen_ = false;                         // a queue drain is spread over several loops
+        uint32_t transmit(uint8_t* packet, int length);
+        bool canTransmit(int length) const;
         unsigned long lastConnectRqTimeMs;
         unsigned long lastReconnectTimeMs;
 
@@ -391,7 +564,7 @@ namespace esphome {
         uint8_t* data;
 
         // initialise to all off, then it will update shortly after connect;
-        heatpumpStatus currentStatus{ 0, 0, false, {TIMER_MODE_MAP[0], 0, 0, 0, 0}, 0, 0, 0, 0 };
+        heatpumpStatus currentStatus{ HalfDegrees(), HalfDegrees(), false, {TIMER_MODE_MAP[0], 0, 0, 0, 0}, 0, 0, 0, 0 };
         heatpumpFunctions functions;
 
         bool tempMode = false;
@@ -422,11 +595,9 @@ namespace esphome {
         uint32_t last_dual_setpoint_change_ms_ = 0;
         char last_dual_setpoint_side_ = 'N'; // 'L' (low), 'H' (high), 'N' (none)
 
-        // Gestion sûre d'un paquet différé à écrire pour éviter la capture d'un buffer de pile
-        void try_write_pending_packet();
-        uint8_t pending_packet_[PACKET_LEN] = {};
-        int pending_packet_len_ = 0;
-        bool pending_check_is_active_ = true;
-        bool has_pending_packet_ = false;
+        // File d'envoi: les écritures partent d'un bloc entre deux cycles, puis un seul temps de repos
+        TxQueue txQueue_{};
+        bool enqueuePacket(uint8_t* packet, int length);
+        void drainTxQueue();
     };
 }
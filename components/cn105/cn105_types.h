@@ -3,6 +3,9 @@
 #include <cmath>
 #include <cstring>
 #include <string>
+#include "temperature.h"
+
+using esphome::HalfDegrees;
 
 #define MAX_DATA_BYTES     64         
 #define MAX_DELAY_RESPONSE_FACTOR 10  
@@ -21,12 +24,50 @@ static const char* LOG_TEMP_SENSOR_TAG = "TEMP_SENSOR";
 static const char* LOG_DUAL_SP_TAG = "DUAL_SP"; 
 static const char* LOG_FUNCTIONS_TAG = "FUNCTIONS"; 
 static const char* LOG_HARDWARE_SELECT_TAG = "HardwareSelect";
+static const char* LOG_PACING_TAG = "PACING";
+static const char* LOG_WRITE_TXN_TAG = "WRITE_TXN";
+static const char* LOG_CONFIRM_TAG = "CONFIRM";
+static const char* LOG_HISTORY_TAG = "HISTORY";
+static const char* LOG_ENERGY_TAG = "ENERGY";
 
 static const char* SHEDULER_REMOTE_TEMP_TIMEOUT = "->remote_temp_timeout";
 
-static const int DEFER_SCHEDULE_UPDATE_LOOP_DELAY = 750;
-static const uint32_t RECEIVED_SETPOINT_GRACE_WINDOW_MS = 3000;
+// pacing controller: post-write rest time, learned per unit (see pacing_controller.h)
+static const uint32_t PACING_INITIAL_REST_MS = 1500;         // conservative start, before anything is learned
+static const uint32_t PACING_MIN_REST_MS = 250;
+static const uint32_t PACING_MAX_REST_MS = 3000;
+static const uint32_t PACING_STEP_MS = 50;
+static const uint8_t PACING_SUCCESS_STREAK = 10;             // clean exchanges before trying a shorter rest
+static const uint8_t PACING_FLOOR_PROBE_STREAKS = 30;        // clean streaks at the floor before probing below it
+static const uint32_t PACING_MIN_WRITE_GAP_MS = 300;         // never below the historical write gap (issue #32)
+static const uint32_t PACING_SAVE_INTERVAL_MS = 3600000;     // learned values reach flash at most once an hour
+
+// write transactions: 0x41 writes matched with their 0x61 ACK (see write_transactions.h)
+static const uint32_t WRITE_ACK_TIMEOUT_MS = 1000;           // doubled at each new attempt
+static const uint8_t WRITE_MAX_ATTEMPTS = 3;
+static const size_t WRITE_TXN_MAX_IN_FLIGHT = 8;
+static const int WRITE_TXN_TYPE_COUNT = 5;                    // 0x01, 0x07, 0x08, 0x1F, 0x21
+static const size_t TX_QUEUE_MAX_ENTRIES = 8;
+static const int TX_FIFO_BUDGET_BYTES = 96;                   // below the 128 bytes hardware FIFO: write_array never blocks
+// optimistic publishes: a written setting must be read back before its deadline (see confirmation_tracker.h)
+static const uint32_t CONFIRM_MARGIN_MS = 1000;              // added to one read cycle for the first deadlines
+static const uint32_t CONFIRM_MAX_DEADLINE_MS = 60000;
 static const uint32_t UI_SETPOINT_ANTIREBOUND_MS = 600;
+static const uint8_t SEQLOCK_READ_ATTEMPTS = 16;               // snapshot() gives up after this many torn reads
+static const uint32_t REFRESH_RESPONSE_TIMEOUT_MS = 1500;    // single on-demand request without reply
+static const uint32_t REFRESH_MAX_WAIT_MS = 5000;            // a refresh caller never waits longer than this
+static const uint8_t HEARTBEAT_INFO_CODE = 0x02;              // settings: always supported, one 22 bytes reply
+static const uint32_t HW_SETTINGS_BATCH_WINDOW_MS = 1500;    // hardware select changes within this window share one write
+static const uint32_t HW_SETTINGS_READ_MAX_AGE_MS = 5000;    // older function tables are read again before being modified
+static const uint32_t HISTORY_MINUTE_MS = 60000;
+static const uint8_t HISTORY_MINUTES_PER_QUARTER = 15;
+static const uint16_t HISTORY_MINUTE_SLOTS = 120;            // 2 h of 1 min samples
+static const uint16_t HISTORY_QUARTER_SLOTS = 96;            // 24 h of 15 min samples
+static const uint32_t HISTORY_MAX_RESPONSE_BYTES = 20000;   // /cn105/history is buffered: 2 units at their worst case
+static const uint32_t ENERGY_MAX_SAMPLE_GAP_MS = 300000;     // longer gaps between two samples are not integrated
+static const uint32_t ENERGY_DUTY_WINDOW_MS = 900000;        // compressor duty cycle window
+static const uint16_t ENERGY_COUNTER_MAX_STEP = 500;         // 50 kWh: a bigger counter step is a reset, not consumption
+static const uint32_t ENERGY_MIN_SAVE_WH = 10;               // below this (and one minute of runtime) a save is postponed
 
 static const int PACKET_LEN = 22;
 static const int PACKET_TYPE_DEFAULT = 99;
@@ -59,39 +100,74 @@ static const int RCVD_PKT_FUNCTIONS = 7;
 
 static const int MAX_NON_RESPONSE_REQ = 5;
 
-static const uint8_t CONTROL_PACKET_1[5] = { 0x01,    0x02,  0x04,  0x08, 0x10 };
-static const uint8_t CONTROL_PACKET_2[1] = { 0x01 };
-static const uint8_t RUN_STATE_PACKET_1[5] = { 0x01, 0x04, 0x08, 0x10, 0x20 };
-static const uint8_t RUN_STATE_PACKET_2[5] = { 0x02, 0x04, 0x08, 0x10, 0x20 };
-static const uint8_t POWER[2] = { 0x00, 0x01 };
-static const char* POWER_MAP[2] = { "OFF", "ON" };
-static const uint8_t MODE[5] = { 0x01,   0x02,  0x03, 0x07, 0x08 };
-static const char* MODE_MAP[5] = { "HEAT", "DRY", "COOL", "FAN", "AUTO" };
-static const uint8_t TEMP[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
-static const int TEMP_MAP[16] = { 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16 };
-static const uint8_t FAN[6] = { 0x00,  0x01,   0x02, 0x03, 0x05, 0x06 };
-static const char* FAN_MAP[6] = { "AUTO", "QUIET", "1", "2", "3", "4" };
-static const uint8_t VANE[7] = { 0x00,  0x01, 0x02, 0x03, 0x04, 0x05, 0x07 };
-static const char* VANE_MAP[7] = { "AUTO", "↑↑", "↑", "—", "↓", "↓↓", "SWING" };
-static const uint8_t WIDEVANE[8] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x08, 0x0c, 0x00 };
-static const char* WIDEVANE_MAP[8] = { "←←", "←", "|", "→", "→→", "←→", "SWING", "AIRFLOW CONTROL" };
-static const uint8_t ROOM_TEMP[32] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
-                                  0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f };
-static const int ROOM_TEMP_MAP[32] = { 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,
-                                  26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41 };
+/**
+ * Tables octet <-> libellé. L'état interne ne garde que l'index dans ces tables (enums ci-dessous):
+ * les octets reçus sont décodés par comparaison d'entiers, les libellés ne servent qu'aux entités ESPHome.
+ */
+static constexpr uint8_t POWER[2] = { 0x00, 0x01 };
+static constexpr const char* POWER_MAP[2] = { "OFF", "ON" };
+static constexpr uint8_t MODE[5] = { 0x01,   0x02,  0x03, 0x07, 0x08 };
+static constexpr const char* MODE_MAP[5] = { "HEAT", "DRY", "COOL", "FAN", "AUTO" };
+static constexpr uint8_t FAN[6] = { 0x00,  0x01,   0x02, 0x03, 0x05, 0x06 };
+static constexpr const char* FAN_MAP[6] = { "AUTO", "QUIET", "1", "2", "3", "4" };
+static constexpr uint8_t VANE[7] = { 0x00,  0x01, 0x02, 0x03, 0x04, 0x05, 0x07 };
+static constexpr const char* VANE_MAP[7] = { "AUTO", "↑↑", "↑", "—", "↓", "↓↓", "SWING" };
+static constexpr uint8_t WIDEVANE[8] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x08, 0x0c, 0x00 };
+static constexpr const char* WIDEVANE_MAP[8] = { "←←", "←", "|", "→", "→→", "←→", "SWING", "AIRFLOW CONTROL" };
 static const uint8_t TIMER_MODE[4] = { 0x00,  0x01,  0x02, 0x03 };
 static const char* TIMER_MODE_MAP[4] = { "NONE", "OFF", "ON", "BOTH" };
 
-static const uint8_t AIRFLOW_CONTROL[3] = { 0x00, 0x01, 0x02 };
-static const char* AIRFLOW_CONTROL_MAP[3] = { "EVEN", "INDIRECT", "DIRECT" };
+static constexpr uint8_t AIRFLOW_CONTROL[3] = { 0x00, 0x01, 0x02 };
+static constexpr const char* AIRFLOW_CONTROL_MAP[3] = { "EVEN", "INDIRECT", "DIRECT" };
+
+static constexpr uint8_t STAGE[7] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 };
+static constexpr const char* STAGE_MAP[7] = { "IDLE", "LOW", "GENTLE", "MEDIUM", "MODERATE", "HIGH", "DIFFUSE" };
+
+static constexpr uint8_t SUB_MODE[4] = { 0x00, 0x02, 0x04, 0x08 };
+static constexpr const char* SUB_MODE_MAP[4] = { "NORMAL", "DEFROST", "PREHEAT", "STANDBY" };
+static constexpr uint8_t AUTO_SUB_MODE[4] = { 0x00, 0x01, 0x02, 0x03 };
+static constexpr const char* AUTO_SUB_MODE_MAP[4] = { "AUTO_OFF","AUTO_COOL", "AUTO_HEAT", "AUTO_LEADER" };
 
-static const uint8_t STAGE[7] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 };
-static const char* STAGE_MAP[7] = { "IDLE", "LOW", "GENTLE", "MEDIUM", "MODERATE", "HIGH", "DIFFUSE" };
+// index des tables ci-dessus; SETTING_UNSET = inconnu (current*) ou non demandé (wanted*)
+static constexpr uint8_t SETTING_UNSET = 0xFF;
 
-static const uint8_t SUB_MODE[4] = { 0x00, 0x02, 0x04, 0x08 };
-static const char* SUB_MODE_MAP[4] = { "NORMAL", "DEFROST", "PREHEAT", "STANDBY" };
-static const uint8_t AUTO_SUB_MODE[4] = { 0x00, 0x01, 0x02, 0x03 };
-static const char* AUTO_SUB_MODE_MAP[4] = { "AUTO_OFF","AUTO_COOL", "AUTO_HEAT", "AUTO_LEADER" };
+enum PowerSetting : uint8_t { HP_POWER_OFF = 0, HP_POWER_ON };
+enum ModeSetting : uint8_t { HP_MODE_HEAT = 0, HP_MODE_DRY, HP_MODE_COOL, HP_MODE_FAN, HP_MODE_AUTO };
+enum FanSetting : uint8_t { HP_FAN_AUTO = 0, HP_FAN_QUIET, HP_FAN_1, HP_FAN_2, HP_FAN_3, HP_FAN_4 };
+enum VaneSetting : uint8_t { HP_VANE_AUTO = 0, HP_VANE_1, HP_VANE_2, HP_VANE_3, HP_VANE_4, HP_VANE_5, HP_VANE_SWING };
+enum WideVaneSetting : uint8_t {
+    HP_WIDEVANE_FAR_LEFT = 0, HP_WIDEVANE_LEFT, HP_WIDEVANE_CENTER, HP_WIDEVANE_RIGHT, HP_WIDEVANE_FAR_RIGHT,
+    HP_WIDEVANE_SPLIT, HP_WIDEVANE_SWING, HP_WIDEVANE_AIRFLOW_CONTROL
+};
+enum AirflowControlSetting : uint8_t { HP_AIRFLOW_EVEN = 0, HP_AIRFLOW_INDIRECT, HP_AIRFLOW_DIRECT };
+enum StageSetting : uint8_t { HP_STAGE_IDLE = 0 };
+enum SubModeSetting : uint8_t { HP_SUB_MODE_NORMAL = 0, HP_SUB_MODE_DEFROST, HP_SUB_MODE_PREHEAT, HP_SUB_MODE_STANDBY };
+
+/**
+ * @brief Index d'un octet dans une table (POWER, MODE, FAN...), SETTING_UNSET s'il n'y figure pas
+ */
+template<size_t N>
+constexpr uint8_t settingIndexOf(const uint8_t(&bytes)[N], uint8_t value) {
+    for (size_t i = 0; i < N; i++) {
+        if (bytes[i] == value) return static_cast<uint8_t>(i);
+    }
+    return SETTING_UNSET;
+}
+
+/**
+ * @brief Libellé d'un index pour les entités et les logs, unset si l'index est hors table
+ */
+template<size_t N>
+constexpr const char* settingLabel(const char* const (&labels)[N], uint8_t index, const char* unset = nullptr) {
+    return index < N ? labels[index] : unset;
+}
+
+static_assert(settingIndexOf(WIDEVANE, 0x0c) == HP_WIDEVANE_SWING, "WIDEVANE table out of sync with WideVaneSetting");
+static_assert(settingIndexOf(VANE, 0x07) == HP_VANE_SWING, "VANE table out of sync with VaneSetting");
+static_assert(settingIndexOf(SUB_MODE, 0x02) == HP_SUB_MODE_DEFROST, "SUB_MODE table out of sync with SubModeSetting");
+static_assert(settingIndexOf(SUB_MODE, 0x04) == HP_SUB_MODE_PREHEAT, "SUB_MODE table out of sync with SubModeSetting");
+static_assert(settingIndexOf(FAN, 0x06) == HP_FAN_4, "FAN table out of sync with FanSetting");
+static_assert(settingIndexOf(MODE, 0x08) == HP_MODE_AUTO, "MODE table out of sync with ModeSetting");
 
 static const int TIMER_INCREMENT_MINUTES = 10;
 
@@ -104,30 +180,46 @@ const uint8_t ESPMHP_MIN_TEMPERATURE = 16;
 const uint8_t ESPMHP_MAX_TEMPERATURE = 26;
 const float ESPMHP_TEMPERATURE_STEP = 0.5;
 
+/**
+ * Capacités de l'unité telles que configurées (supports: du YAML), figées dans setup()
+ * Le code interne teste ce masque: traits() copie les ensembles de modes de ClimateTraits à chaque appel
+ */
+enum Capability : uint16_t {
+    CAP_DUAL_SETPOINT = 1 << 0,
+    CAP_MODE_HEAT = 1 << 1,
+    CAP_MODE_COOL = 1 << 2,
+    CAP_MODE_DRY = 1 << 3,
+    CAP_MODE_FAN_ONLY = 1 << 4,
+    CAP_MODE_AUTO = 1 << 5,
+    CAP_SWING_VERTICAL = 1 << 6,
+    CAP_SWING_HORIZONTAL = 1 << 7,
+    CAP_FAHRENHEIT = 1 << 8,
+};
+
 struct heatpumpSettings {
-    const char* power;
-    const char* mode;
-    float temperature;
-    float dual_low_target;
-    float dual_high_target;
-    const char* fan;
-    const char* vane;
-    const char* wideVane;
+    uint8_t power = SETTING_UNSET;              // PowerSetting
+    uint8_t mode = SETTING_UNSET;               // ModeSetting
+    HalfDegrees temperature;
+    HalfDegrees dual_low_target;
+    HalfDegrees dual_high_target;
+    uint8_t fan = SETTING_UNSET;                // FanSetting
+    uint8_t vane = SETTING_UNSET;               // VaneSetting
+    uint8_t wideVane = SETTING_UNSET;           // WideVaneSetting
     bool iSee;
     bool connected;
-    const char* stage;
-    const char* sub_mode;
-    const char* auto_sub_mode;
+    uint8_t stage = SETTING_UNSET;              // index STAGE_MAP
+    uint8_t sub_mode = SETTING_UNSET;           // index SUB_MODE_MAP
+    uint8_t auto_sub_mode = SETTING_UNSET;      // index AUTO_SUB_MODE_MAP
 
     void resetSettings() {
-        power = nullptr;
-        mode = nullptr;
-        temperature = -1.0f;
-        dual_low_target = -100.0f;
-        dual_high_target = -100.0f;
-        fan = nullptr;
-        vane = nullptr;
-        wideVane = nullptr;
+        power = SETTING_UNSET;
+        mode = SETTING_UNSET;
+        temperature = HalfDegrees();
+        dual_low_target = HalfDegrees();
+        dual_high_target = HalfDegrees();
+        fan = SETTING_UNSET;
+        vane = SETTING_UNSET;
+        wideVane = SETTING_UNSET;
     }
 
     heatpumpSettings& operator=(const heatpumpSettings& other) {
@@ -222,9 +314,16 @@ struct heatpumpTimers {
     }
 };
 
+// champs de heatpumpStatus portés par l'entité climate qui ont changé entre deux trames, voir heatpumpStatus::changesFrom()
+// (les capteurs de statut ont chacun leur PublishPolicy et n'en ont pas besoin)
+enum StatusChange : uint8_t {
+    STATUS_ROOM_TEMPERATURE = 1 << 0,
+    STATUS_OPERATING = 1 << 1,
+};
+
 struct heatpumpStatus {
-    float roomTemperature;
-    float outsideAirTemperature;
+    HalfDegrees roomTemperature;
+    HalfDegrees outsideAirTemperature;     // non définie si la sonde extérieure ne répond pas
     bool operating;
     heatpumpTimers timers;
     float compressorFrequency;
@@ -233,8 +332,8 @@ struct heatpumpStatus {
     float runtimeHours;
 
     bool operator==(const heatpumpStatus& other) const {
-        return (std::isnan(roomTemperature) ? std::isnan(other.roomTemperature) : roomTemperature == other.roomTemperature) &&
-            (std::isnan(outsideAirTemperature) ? std::isnan(other.outsideAirTemperature) : outsideAirTemperature == other.outsideAirTemperature) &&
+        return roomTemperature == other.roomTemperature &&
+            outsideAirTemperature == other.outsideAirTemperature &&
             operating == other.operating &&
             compressorFrequency == other.compressorFrequency &&
             inputPower == other.inputPower &&
@@ -245,19 +344,29 @@ struct heatpumpStatus {
     bool operator!=(const heatpumpStatus& other) const {
         return !(*this == other);
     }
+
+    /**
+     * @brief Masque de StatusChange des champs de l'entité climate qui diffèrent de other
+     */
+    uint8_t changesFrom(const heatpumpStatus& other) const {
+        uint8_t changes = 0;
+        if (roomTemperature != other.roomTemperature) changes |= STATUS_ROOM_TEMPERATURE;
+        if (operating != other.operating) changes |= STATUS_OPERATING;
+        return changes;
+    }
 };
 
 struct heatpumpRunStates {
     int8_t air_purifier;
     int8_t night_mode;
     int8_t circulator;
-    const char* airflow_control;
+    uint8_t airflow_control = SETTING_UNSET;    // AirflowControlSetting
 
     void resetSettings() {
         air_purifier = -1;
         night_mode = -1;
         circulator = -1;
-        airflow_control = nullptr;
+        airflow_control = SETTING_UNSET;
     }
 
     heatpumpRunStates& operator=(const heatpumpRunStates& other) {
@@ -25,9 +25,23 @@ void CN105Climate::setup() {
     this->nbCycles_ = 0;
     this->nbHeatpumpConnections_ = 0;
 
+    // the generated code has configured the traits by now
+    this->snapshotCapabilities();
+
     // Register info requests here to ensure all dependencies (like hardware_settings) are ready
     this->registerInfoRequests();
 
+#ifdef USE_CN105_WEB
+    CN105WebHandler::register_instance(this);
+#endif
+
+    // learned inter-frame pacing survives reboots
+    this->pacing_.init(fnv1_hash("cn105_pacing") ^ this->get_object_id_hash());
+
+#ifdef USE_CN105_ENERGY
+    this->setupEnergy();
+#endif
+
     ESP_LOGI(TAG, "tx_pin: %d rx_pin: %d", this->tx_pin_, this->rx_pin_);
     //ESP_LOGI(TAG, "remote_temp_timeout is set to %lu", this->remote_temp_timeout_);
     log_info_uint32(TAG, "remote_temp_timeout is set to ", this->remote_temp_timeout_);
@@ -45,6 +59,21 @@ void CN105Climate::setup() {
  * This function is called repeatedly in the main program loop.
  */
 void CN105Climate::loop() {
+    this->mergeSettingsMailbox();                                           // user changes posted by control() and the selects
+    if (!this->loopCycle.isCycleRunning()) {
+        this->flushClimateState();                                          // replies to an on-demand request or a heartbeat
+    }
+    this->checkConfirmationDeadlines();                                     // optimistic values not read back in time
+    this->pacing_.loop(CUSTOM_MILLIS);                                      // learned rest time to flash, throttled
+#ifdef USE_CN105_HISTORY
+    if (this->history_ != nullptr) {
+        this->history_->loop(CUSTOM_MILLIS);                                // closes the elapsed history minutes
+    }
+#endif
+    this->scheduler_.loop();                                                // expires stale refresh requests
+    this->writeTxns_.loop(!this->loopCycle.isCycleRunning() && !this->scheduler_.has_single_shot_in_flight() &&
+        this->getTxRemainingMs() == 0);
+
     if (!this->processInput()) {                                            // if we don't get any input: no read op
         if ((this->wantedSettings.hasChanged) && (!this->loopCycle.isCycleRunning())) {
             this->checkPendingWantedSettings();
@@ -52,9 +81,18 @@ void CN105Climate::loop() {
             this->checkPendingWantedRunStates();
         } else {
             if (this->loopCycle.isCycleRunning()) {                         // if we are  running an update cycle
-                this->loopCycle.checkTimeout(this->update_interval_);
+                if (this->loopCycle.checkTimeout(this->update_interval_)) {
+                    this->reportLinkError("cycle timeout");
+                }
+            } else if (this->scheduler_.has_single_shot_in_flight()) {
+                // an on-demand request is waiting for its reply, the bus is ours until then
             } else { // we are not running a cycle
-                if (this->loopCycle.hasUpdateIntervalPassed(this->get_update_interval())) {
+                if (!this->txQueue_.empty()) {
+                    this->drainTxQueue();                                   // writes go out before any poll
+                } else if (this->isHeatpumpConnected_ && !this->loopCycle.isResting() &&
+                    (this->sendHeartbeatIfIdle() || this->scheduler_.service_refreshes())) {
+                    // an on-demand refresh went out instead of a full cycle
+                } else if (this->loopCycle.hasUpdateIntervalPassed(this->getEffectiveUpdateInterval())) {
                     this->buildAndSendRequestsInfoPackets();            // initiate an update cycle with this->cycleStarted();
                 }
             }
@@ -63,6 +101,93 @@ void CN105Climate::loop() {
 }
 
 uint32_t CN105Climate::get_update_interval() const { return this->update_interval_; }
+
+/**
+ * Read-through refresh: calls back immediately if the data group behind `code` is younger than max_age_ms,
+ * otherwise joins (or queues) a single on-demand request for that code.
+ */
+void CN105Climate::refresh(uint8_t code, uint32_t max_age_ms, std::function<void(bool)>&& callback) {
+    this->scheduler_.request_refresh(code, max_age_ms, std::move(callback));
+}
+
+uint32_t CN105Climate::get_data_age(uint8_t code) const {
+    return this->scheduler_.get_response_age(code);
+}
+
+/**
+ * Liveness check independent of update_interval: when nothing has been heard for heartbeat_interval,
+ * a single info request is sent. heartbeat_max_missed unanswered heartbeats in a row mean the link is lost.
+ * With normal polling the heatpump keeps replying and no heartbeat is ever sent.
+ */
+bool CN105Climate::sendHeartbeatIfIdle() {
+    if (this->heartbeat_interval_ms_ == 0 || this->heartbeat_pending_) {
+        return false;
+    }
+    uint32_t now = CUSTOM_MILLIS;
+    if ((now - this->lastResponseMs) < this->heartbeat_interval_ms_ ||
+        (now - this->last_heartbeat_ms_) < this->heartbeat_interval_ms_) {
+        return false;
+    }
+
+    this->last_heartbeat_ms_ = now;
+    this->heartbeat_pending_ = true;
+    ESP_LOGV(LOG_CYCLE_TAG, "Bus idle, sending heartbeat 0x%02X", HEARTBEAT_INFO_CODE);
+
+    this->scheduler_.request_refresh(HEARTBEAT_INFO_CODE, 0, [this](bool answered) {
+        this->heartbeat_pending_ = false;
+        if (answered) {
+            this->heartbeat_missed_ = 0;
+            return;
+        }
+        this->heartbeat_missed_++;
+        ESP_LOGW(LOG_CYCLE_TAG, "Heartbeat missed (%d/%d)", this->heartbeat_missed_, this->heartbeat_max_missed_);
+        if (this->heartbeat_missed_ >= this->heartbeat_max_missed_) {
+            ESP_LOGW(TAG, "Heatpump did not answer %d heartbeats, reconnecting UART", this->heartbeat_missed_);
+            this->heartbeat_missed_ = 0;
+            this->reconnectUART();
+        }
+        });
+    return this->scheduler_.service_refreshes();
+}
+
+/**
+ * Arms (or re-arms) the burst window: the unit is physically changing right after a user command
+ * (fan ramping, vanes moving, stage shifting) so we poll the burst-relevant codes faster for a while.
+ */
+void CN105Climate::armBurstMode(const char* reason) {
+    if (this->burst_duration_ms_ == 0) {
+        return;
+    }
+    ESP_LOGD(LOG_CYCLE_TAG, "Burst polling armed by %s", reason);
+    this->burst_started_ms_ = CUSTOM_MILLIS;
+    this->burst_armed_ = true;
+}
+
+bool CN105Climate::isBurstModeActive() {
+    if (this->burst_armed_ && (CUSTOM_MILLIS - this->burst_started_ms_) >= this->burst_duration_ms_) {
+        ESP_LOGD(LOG_CYCLE_TAG, "Burst polling window elapsed, back to normal schedule");
+        this->burst_armed_ = false;
+    }
+    return this->burst_armed_;
+}
+
+/**
+ * During the first half of the burst window cycles run at burst_update_interval,
+ * then the interval decays linearly back to update_interval at the end of the window.
+ */
+uint32_t CN105Climate::getEffectiveUpdateInterval() {
+    if (!this->isBurstModeActive() || this->burst_update_interval_ms_ >= this->update_interval_) {
+        return this->update_interval_;
+    }
+    uint32_t elapsed = CUSTOM_MILLIS - this->burst_started_ms_;
+    uint32_t half = this->burst_duration_ms_ / 2;
+    if (elapsed <= half) {
+        return this->burst_update_interval_ms_;
+    }
+    uint32_t span = this->update_interval_ - this->burst_update_interval_ms_;
+    uint32_t decay = this->burst_duration_ms_ - half;
+    return this->burst_update_interval_ms_ + static_cast<uint32_t>((static_cast<uint64_t>(span) * (elapsed - half)) / decay);
+}
 void CN105Climate::set_update_interval(uint32_t update_interval) {
     //ESP_LOGD(TAG, "Setting update interval to %lu", update_interval);
     log_debug_uint32(TAG, "Setting update interval to ", update_interval);
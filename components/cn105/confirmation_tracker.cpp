@@ -0,0 +1,119 @@
+#include "confirmation_tracker.h"
+#include "Globals.h"
+
+using namespace esphome;
+
+const char* ConfirmationTracker::field_name(ConfirmField field) {
+    switch (field) {
+    case CONFIRM_POWER: return "power";
+    case CONFIRM_MODE: return "mode";
+    case CONFIRM_TEMPERATURE: return "temperature";
+    case CONFIRM_FAN: return "fan";
+    case CONFIRM_VANE: return "vane";
+    case CONFIRM_WIDEVANE: return "wideVane";
+    default: return "unknown";
+    }
+}
+
+void ConfirmationTracker::arm(ConfirmField field, uint32_t now, uint32_t floor_ms) {
+    Pending& p = this->pending_[field];
+    // twice the measured latency leaves room for one lost read, never less than one read cycle
+    uint32_t timeout_ms = this->stats_[field].avg_latency_ms * 2;
+    if (timeout_ms < floor_ms) timeout_ms = floor_ms;
+    if (timeout_ms > CONFIRM_MAX_DEADLINE_MS) timeout_ms = CONFIRM_MAX_DEADLINE_MS;
+    p.active = true;
+    p.sent_ms = now;
+    p.deadline_ms = now + timeout_ms;
+    ESP_LOGV(LOG_CONFIRM_TAG, "%s awaiting confirmation within %u ms", field_name(field), (unsigned) timeout_ms);
+}
+
+void ConfirmationTracker::expect(ConfirmField field, uint8_t value, uint32_t now, uint32_t floor_ms) {
+    this->pending_[field].value = value;
+    this->arm(field, now, floor_ms);
+}
+
+void ConfirmationTracker::expect_temperature(HalfDegrees value, uint32_t now, uint32_t floor_ms) {
+    this->pending_[CONFIRM_TEMPERATURE].temperature = value;
+    this->arm(CONFIRM_TEMPERATURE, now, floor_ms);
+}
+
+void ConfirmationTracker::confirm(ConfirmField field, uint32_t now) {
+    Pending& p = this->pending_[field];
+    Stats& s = this->stats_[field];
+    uint32_t latency = (int32_t) (now - p.sent_ms) > 0 ? now - p.sent_ms : 0;
+    p.active = false;
+    s.confirmed++;
+    s.last_latency_ms = latency;
+    s.avg_latency_ms = (s.avg_latency_ms == 0) ? latency : (s.avg_latency_ms * 7 + latency) / 8;
+    if (latency > s.max_latency_ms) s.max_latency_ms = latency;
+    ESP_LOGD(LOG_CONFIRM_TAG, "%s confirmed in %u ms (avg %u ms, max %u ms)", field_name(field), (unsigned) latency,
+        (unsigned) s.avg_latency_ms, (unsigned) s.max_latency_ms);
+}
+
+bool ConfirmationTracker::hold(ConfirmField field, uint8_t received, uint32_t now) {
+    Pending& p = this->pending_[field];
+    if (!p.active) return false;
+    if ((received != SETTING_UNSET) && (received == p.value)) {
+        this->confirm(field, now);
+        return false;
+    }
+    ESP_LOGD(LOG_CONFIRM_TAG, "%s read back as index %d while %d is pending: kept", field_name(field), received, p.value);
+    return true;
+}
+
+bool ConfirmationTracker::hold_temperature(HalfDegrees received, uint32_t now) {
+    Pending& p = this->pending_[CONFIRM_TEMPERATURE];
+    if (!p.active) return false;
+    if (received.is_set() && (received == p.temperature)) {
+        this->confirm(CONFIRM_TEMPERATURE, now);
+        return false;
+    }
+    ESP_LOGD(LOG_CONFIRM_TAG, "temperature read back as %.1f while %.1f is pending: kept", received.celsius(),
+        p.temperature.celsius());
+    return true;
+}
+
+uint8_t ConfirmationTracker::expire(uint32_t now) {
+    uint8_t expired = 0;
+    for (uint8_t i = 0; i < CONFIRM_FIELD_COUNT; i++) {
+        Pending& p = this->pending_[i];
+        if (p.active && (int32_t) (now - p.deadline_ms) >= 0) {
+            expired |= (1 << i);
+        }
+    }
+    this->roll_back(expired);
+    return expired;
+}
+
+uint8_t ConfirmationTracker::abandon(uint8_t fields) {
+    uint8_t abandoned = 0;
+    for (uint8_t i = 0; i < CONFIRM_FIELD_COUNT; i++) {
+        if ((fields & (1 << i)) && this->pending_[i].active) abandoned |= (1 << i);
+    }
+    this->roll_back(abandoned);
+    return abandoned;
+}
+
+void ConfirmationTracker::roll_back(uint8_t fields) {
+    for (uint8_t i = 0; i < CONFIRM_FIELD_COUNT; i++) {
+        if ((fields & (1 << i)) && this->pending_[i].active) {
+            this->pending_[i].active = false;
+            this->stats_[i].rolled_back++;
+            ESP_LOGW(LOG_CONFIRM_TAG, "%s not confirmed by the heatpump, rolling back (%u so far)",
+                field_name(static_cast<ConfirmField>(i)), (unsigned) this->stats_[i].rolled_back);
+        }
+    }
+}
+
+bool ConfirmationTracker::any_pending() const {
+    for (const auto& p : this->pending_) {
+        if (p.active) return true;
+    }
+    return false;
+}
+
+void ConfirmationTracker::clear() {
+    for (auto& p : this->pending_) {
+        p.active = false;
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include "cn105_types.h"
+
+namespace esphome {
+
+    enum ConfirmField : uint8_t {
+        CONFIRM_POWER = 0,
+        CONFIRM_MODE,
+        CONFIRM_TEMPERATURE,
+        CONFIRM_FAN,
+        CONFIRM_VANE,
+        CONFIRM_WIDEVANE,
+        CONFIRM_FIELD_COUNT
+    };
+
+    /**
+     * @class ConfirmationTracker
+     * @brief Suivi champ par champ des réglages publiés de façon optimiste vers HA.
+     *
+     * Un réglage écrit est "en attente" jusqu'à ce qu'une lecture des settings (0x02) rapporte la même valeur.
+     * Tant qu'il est en attente, une lecture différente est considérée comme antérieure à l'écriture et
+     * n'écrase pas l'affichage. Passé le délai, l'affichage revient à la valeur de l'unité.
+     * Le délai suit la latence de confirmation mesurée, jamais moins d'un cycle de lecture.
+     */
+    class ConfirmationTracker {
+    public:
+        struct Stats {
+            uint32_t confirmed = 0;
+            uint32_t rolled_back = 0;
+            uint32_t last_latency_ms = 0;
+            uint32_t avg_latency_ms = 0;    // moyenne glissante (1/8)
+            uint32_t max_latency_ms = 0;
+        };
+
+        static const char* field_name(ConfirmField field);
+
+        /**
+         * @brief Une valeur vient d'être écrite et publiée: elle attend sa relecture
+         * @param floor_ms Délai minimal, le temps d'un cycle de lecture complet
+         */
+        void expect(ConfirmField field, uint8_t value, uint32_t now, uint32_t floor_ms);
+        void expect_temperature(HalfDegrees value, uint32_t now, uint32_t floor_ms);
+
+        /**
+         * @brief Compare une valeur relue à la valeur attendue
+         * @return true si le champ est toujours en attente: la valeur relue ne doit pas être publiée
+         */
+        bool hold(ConfirmField field, uint8_t received, uint32_t now);
+        bool hold_temperature(HalfDegrees received, uint32_t now);
+
+        /**
+         * @brief Champs dont le délai est dépassé, retirés du suivi
+         * @return masque de bits (1 << ConfirmField)
+         */
+        uint8_t expire(uint32_t now);
+
+        /**
+         * @brief Abandonne les champs en attente d'une écriture perdue, comptés comme annulés
+         * @param fields masque de bits (1 << ConfirmField) des champs de la trame perdue
+         * @return masque des champs qui étaient effectivement en attente
+         */
+        uint8_t abandon(uint8_t fields);
+
+        bool is_pending(ConfirmField field) const { return this->pending_[field].active; }
+        bool any_pending() const;
+        uint8_t expected_value(ConfirmField field) const { return this->pending_[field].value; }
+        HalfDegrees expected_temperature() const { return this->pending_[CONFIRM_TEMPERATURE].temperature; }
+
+        const Stats& get_stats(ConfirmField field) const { return this->stats_[field]; }
+
+        void clear();
+
+    private:
+        struct Pending {
+            bool active = false;
+            uint8_t value = SETTING_UNSET;    // index dans la table du champ
+            HalfDegrees temperature;
+            uint32_t sent_ms = 0;
+            uint32_t deadline_ms = 0;
+        };
+
+        void arm(ConfirmField field, uint32_t now, uint32_t floor_ms);
+        void confirm(ConfirmField field, uint32_t now);
+        void roll_back(uint8_t fields);
+
+        Pending pending_[CONFIRM_FIELD_COUNT];
+        Stats stats_[CONFIRM_FIELD_COUNT];
+    };
+
+}
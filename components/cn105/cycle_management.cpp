@@ -4,11 +4,13 @@
 
 using namespace esphome;
 
-void cycleManagement::checkTimeout(unsigned int update_interval) {
+bool cycleManagement::checkTimeout(unsigned int update_interval) {
     if (doesCycleTimeOut(update_interval)) {                          // does it last too long ?                    
         ESP_LOGW(TAG, "Cycle timeout, reseting cycle...");
         cycleEnded(true);
+        return true;
     }
+    return false;
 }
 
 
@@ -16,18 +18,18 @@ bool cycleManagement::isCycleRunning() {
     return cycleRunning;
 }
 
+// true while the post-write rest time set by deferCycle() is not over
+bool cycleManagement::isResting() {
+    return CUSTOM_MILLIS < lastCompleteCycleMs;
+}
+
 void cycleManagement::init() {
     cycleRunning = false;
     lastCompleteCycleMs = CUSTOM_MILLIS;
 }
 
-void cycleManagement::deferCycle() {
-
-#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG
-    uint32_t delay = DEFER_SCHEDULE_UPDATE_LOOP_DELAY * 2;
-#else
-    uint32_t delay = DEFER_SCHEDULE_UPDATE_LOOP_DELAY;
-#endif
+// delay is the rest time given by the pacing controller
+void cycleManagement::deferCycle(uint32_t delay) {
 
     //ESP_LOGI(LOG_CYCLE_TAG, "Defering cycle trigger of %lu ms", delay);
     log_info_uint32(LOG_CYCLE_TAG, "Defering cycle trigger of  ", delay, " ms");
@@ -42,6 +44,12 @@ void cycleManagement::cycleStarted() {
 }
 
 void cycleManagement::cycleEnded(bool timedOut) {
+    if (cycleRunning) {
+        lastDurationMs = CUSTOM_MILLIS - lastCycleStartMs;
+        durationSumMs += lastDurationMs;
+        endedCycles++;
+        if (timedOut) timedOutCycles++;
+    }
     cycleRunning = false;
 
     if (lastCompleteCycleMs < CUSTOM_MILLIS) {    // we check this because of defering mecanism
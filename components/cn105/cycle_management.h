@@ -1,18 +1,27 @@
 #pragma once
 
+#include <cstdint>
+
 struct cycleManagement {
 
     bool cycleRunning = false;
     unsigned long lastCycleStartMs = 0;
     unsigned long lastCompleteCycleMs = 0;
 
+    // counters since boot, exported on /cn105/metrics
+    uint32_t endedCycles = 0;
+    uint32_t timedOutCycles = 0;
+    uint32_t lastDurationMs = 0;
+    uint64_t durationSumMs = 0;
+
     void init();
     void cycleStarted();
     void cycleEnded(bool timedOut = false);
     bool hasUpdateIntervalPassed(unsigned int update_interval);
     bool doesCycleTimeOut(unsigned int update_interval);
     bool isCycleRunning();
-    void deferCycle();
-    void checkTimeout(unsigned int update_interval);
+    bool isResting();
+    void deferCycle(uint32_t delay);
+    bool checkTimeout(unsigned int update_interval);
 
 };
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "energy_integrator.h"
+#include "Globals.h"
+
+using namespace esphome;
+
+static const uint64_t MJ_PER_WH = 3600000ULL;
+static const uint32_t MIN_SAVE_RUNTIME_S = 60;
+
+void EnergyIntegrator::init(uint32_t pref_hash, uint32_t save_interval_ms) {
+    // en flash: les cumuls doivent survivre à une coupure de courant, pas seulement à un reboot
+    this->pref_ = global_preferences->make_preference<SavedEnergy>(pref_hash, true);
+    this->pref_ready_ = true;
+    this->save_interval_ms_ = save_interval_ms;
+
+    SavedEnergy saved{};
+    if (this->pref_.load(&saved)) {
+        this->totals_ = saved;
+        this->saved_ = saved;
+        ESP_LOGI(LOG_ENERGY_TAG, "Restored %.3f kWh integrated, %.1f kWh counter, %.1f h compressor",
+            this->get(ENERGY_INTEGRATED), this->get(ENERGY_COUNTER), this->get(ENERGY_COMPRESSOR_RUNTIME));
+    } else {
+        ESP_LOGI(LOG_ENERGY_TAG, "No saved energy totals, starting from zero");
+    }
+}
+
+void EnergyIntegrator::on_status(float input_power, float compressor_frequency, uint16_t counter_tenths, uint32_t now) {
+    // compteur de l'unité: 16 bits en 0.1 kWh, il reboucle à 6553.5 kWh
+    if (this->totals_.has_last_raw) {
+        uint16_t step = static_cast<uint16_t>(counter_tenths - this->totals_.last_raw_tenths);
+        if (step <= ENERGY_COUNTER_MAX_STEP) {
+            this->totals_.counter_tenths += step;
+        } else {
+            ESP_LOGW(LOG_ENERGY_TAG, "Energy counter jumped from %u to %u, resynchronizing",
+                (unsigned) this->totals_.last_raw_tenths, (unsigned) counter_tenths);
+        }
+    }
+    this->totals_.last_raw_tenths = counter_tenths;
+    this->totals_.has_last_raw = 1;
+
+    bool running = !std::isnan(compressor_frequency) && compressor_frequency > 0.0f;
+    if (this->has_status_) {
+        uint32_t elapsed = now - this->last_status_ms_;
+        if (elapsed <= ENERGY_MAX_SAMPLE_GAP_MS) {
+            if (!std::isnan(this->last_power_) && !std::isnan(input_power)) {
+                // trapèze: W x ms = mJ
+                this->totals_.integrated_mj += static_cast<uint64_t>((this->last_power_ + input_power) * 0.5f * elapsed);
+            }
+            if (this->last_running_) {
+                this->compressor_ms_ += elapsed;
+                this->window_running_ms_ += elapsed;
+            }
+            this->totals_.compressor_s += this->compressor_ms_ / 1000;
+            this->compressor_ms_ %= 1000;
+
+            this->window_ms_ += elapsed;
+            if (this->window_ms_ >= ENERGY_DUTY_WINDOW_MS) {
+                this->duty_cycle_ = 100.0f * this->window_running_ms_ / this->window_ms_;
+                this->window_ms_ = 0;
+                this->window_running_ms_ = 0;
+            }
+        } else {
+            ESP_LOGD(LOG_ENERGY_TAG, "No status for %u s, gap not integrated", (unsigned) (elapsed / 1000));
+        }
+    }
+    this->has_status_ = true;
+    this->last_power_ = (!std::isnan(input_power) && input_power >= 0.0f) ? input_power : NAN;
+    this->last_running_ = running;
+    this->last_status_ms_ = now;
+}
+
+void EnergyIntegrator::on_sub_mode(uint8_t sub_mode, uint32_t now) {
+    if (this->has_sub_mode_) {
+        uint32_t elapsed = now - this->last_sub_mode_ms_;
+        if (elapsed <= ENERGY_MAX_SAMPLE_GAP_MS) {
+            if (this->last_sub_mode_ == HP_SUB_MODE_DEFROST) {
+                this->defrost_ms_ += elapsed;
+            } else if (this->last_sub_mode_ == HP_SUB_MODE_PREHEAT) {
+                this->preheat_ms_ += elapsed;
+            }
+            this->totals_.defrost_s += this->defrost_ms_ / 1000;
+            this->defrost_ms_ %= 1000;
+            this->totals_.preheat_s += this->preheat_ms_ / 1000;
+            this->preheat_ms_ %= 1000;
+        }
+    }
+    this->has_sub_mode_ = true;
+    this->last_sub_mode_ = sub_mode;
+    this->last_sub_mode_ms_ = now;
+}
+
+bool EnergyIntegrator::significant_change_() const {
+    return this->totals_.integrated_mj >= this->saved_.integrated_mj + ENERGY_MIN_SAVE_WH * MJ_PER_WH ||
+        this->totals_.counter_tenths != this->saved_.counter_tenths ||
+        this->totals_.compressor_s >= this->saved_.compressor_s + MIN_SAVE_RUNTIME_S ||
+        this->totals_.defrost_s >= this->saved_.defrost_s + MIN_SAVE_RUNTIME_S ||
+        this->totals_.preheat_s >= this->saved_.preheat_s + MIN_SAVE_RUNTIME_S;
+}
+
+void EnergyIntegrator::loop(uint32_t now) {
+    if (!this->pref_ready_ || (now - this->last_save_ms_) < this->save_interval_ms_) {
+        return;
+    }
+    // l'intervalle repart même sans écriture: pas de sauvegarde à chaque loop() une fois l'intervalle écoulé
+    this->last_save_ms_ = now;
+    if (this->significant_change_()) {
+        this->save();
+    }
+}
+
+void EnergyIntegrator::save() {
+    if (!this->pref_ready_) {
+        return;
+    }
+    if (this->totals_.integrated_mj == this->saved_.integrated_mj &&
+        this->totals_.counter_tenths == this->saved_.counter_tenths &&
+        this->totals_.compressor_s == this->saved_.compressor_s &&
+        this->totals_.defrost_s == this->saved_.defrost_s &&
+        this->totals_.preheat_s == this->saved_.preheat_s &&
+        this->totals_.last_raw_tenths == this->saved_.last_raw_tenths &&
+        this->totals_.has_last_raw == this->saved_.has_last_raw) {
+        return;
+    }
+    if (this->pref_.save(&this->totals_)) {
+        this->saved_ = this->totals_;
+        ESP_LOGD(LOG_ENERGY_TAG, "Energy totals saved");
+    } else {
+        ESP_LOGW(LOG_ENERGY_TAG, "Could not save energy totals");
+    }
+}
+
+float EnergyIntegrator::get(EnergyReading reading) const {
+    switch (reading) {
+    case ENERGY_INTEGRATED:
+        return static_cast<float>(static_cast<double>(this->totals_.integrated_mj) / (MJ_PER_WH * 1000.0));
+    case ENERGY_COUNTER:
+        return this->totals_.counter_tenths / 10.0f;
+    case ENERGY_COMPRESSOR_RUNTIME:
+        return this->totals_.compressor_s / 3600.0f;
+    case ENERGY_COMPRESSOR_DUTY_CYCLE:
+        return this->duty_cycle_;
+    case ENERGY_DEFROST_TIME:
+        return this->totals_.defrost_s / 3600.0f;
+    case ENERGY_PREHEAT_TIME:
+        return this->totals_.preheat_s / 3600.0f;
+    default:
+        return NAN;
+    }
+}
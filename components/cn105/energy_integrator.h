@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "cn105_types.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+
+    /**
+     * Valeurs publiées par l'intégrateur d'énergie
+     */
+    enum EnergyReading : uint8_t {
+        ENERGY_INTEGRATED = 0,          // kWh, intégration trapèze de la puissance
+        ENERGY_COUNTER,                 // kWh, compteur 0x06 de l'unité déroulé au-delà de 6553.5
+        ENERGY_COMPRESSOR_RUNTIME,      // h
+        ENERGY_COMPRESSOR_DUTY_CYCLE,   // %, sur la dernière fenêtre ENERGY_DUTY_WINDOW_MS
+        ENERGY_DEFROST_TIME,            // h
+        ENERGY_PREHEAT_TIME,            // h
+        ENERGY_READING_COUNT
+    };
+
+    /**
+     * @class EnergyIntegrator
+     * @brief Cumuls d'énergie et de temps calculés sur l'ESP à chaque trame, persistés en flash
+     *
+     * La puissance de chaque trame 0x06 est intégrée par trapèzes avec la précédente, le compresseur compte
+     * comme en marche entre deux trames si la fréquence de la première était non nulle, et le sub_mode des
+     * trames 0x09 donne le temps de dégivrage / préchauffage. Un écart de plus de ENERGY_MAX_SAMPLE_GAP_MS
+     * entre deux trames (unité déconnectée) n'est pas compté.
+     * Les cumuls sont sauvés au plus une fois par save_interval, et seulement s'ils ont assez bougé.
+     */
+    class EnergyIntegrator {
+    public:
+        void init(uint32_t pref_hash, uint32_t save_interval_ms);
+
+        /// trame 0x06: puissance (W), fréquence compresseur (Hz), compteur brut (0.1 kWh)
+        void on_status(float input_power, float compressor_frequency, uint16_t counter_tenths, uint32_t now);
+        /// trame 0x09: index SUB_MODE_MAP
+        void on_sub_mode(uint8_t sub_mode, uint32_t now);
+
+        /// sauve si l'intervalle est écoulé et que les cumuls ont assez changé
+        void loop(uint32_t now);
+        /// sauve tout de suite si quelque chose a changé (redémarrage propre)
+        void save();
+
+        float get(EnergyReading reading) const;
+
+    private:
+        struct SavedEnergy {
+            uint64_t integrated_mj;     // W x ms
+            uint32_t counter_tenths;    // 0.1 kWh, déroulé
+            uint32_t compressor_s;
+            uint32_t defrost_s;
+            uint32_t preheat_s;
+            uint16_t last_raw_tenths;
+            uint8_t has_last_raw;
+        };
+
+        bool significant_change_() const;
+
+        SavedEnergy totals_{};
+        SavedEnergy saved_{};           // dernière valeur écrite en flash
+        ESPPreferenceObject pref_;
+        bool pref_ready_ = false;
+        uint32_t save_interval_ms_ = 0;
+        uint32_t last_save_ms_ = 0;
+
+        // trame 0x06 précédente
+        bool has_status_ = false;
+        float last_power_ = 0.0f;
+        bool last_running_ = false;
+        uint32_t last_status_ms_ = 0;
+        uint32_t compressor_ms_ = 0;    // reste en dessous d'une seconde
+
+        // trame 0x09 précédente
+        bool has_sub_mode_ = false;
+        uint8_t last_sub_mode_ = SETTING_UNSET;
+        uint32_t last_sub_mode_ms_ = 0;
+        uint32_t defrost_ms_ = 0;
+        uint32_t preheat_ms_ = 0;
+
+        // fenêtre du taux de marche
+        uint32_t window_ms_ = 0;
+        uint32_t window_running_ms_ = 0;
+        float duty_cycle_ = NAN;
+    };
+
+}
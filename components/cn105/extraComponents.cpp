@@ -28,10 +28,14 @@ void CN105Climate::set_vertical_vane_select(
 
         ESP_LOGD("EVT", "vane.control() -> Demande un chgt de réglage de la vane: %s", setting);
 
-        this->setVaneSetting(setting);
-        this->wantedSettings.hasChanged = true;
-        this->wantedSettings.hasBeenSent = false;
-        this->wantedSettings.lastChange = CUSTOM_MILLIS;
+        int vane = lookupByteMapIndex(VANE_MAP, 7, setting, "vane select");
+        if (vane < 0) {
+            ESP_LOGW("EVT", "vane.control() -> unknown setting %s ignored", setting);
+            return;
+        }
+        this->stagedDelta_ = SettingsDelta{};
+        this->setVaneSetting(vane);
+        this->postStagedDelta();
         });
 
 }
@@ -59,10 +63,14 @@ void CN105Climate::set_horizontal_vane_select(
   this->horizontal_vane_select_->setCallbackFunction([this](const char* setting) {
     ESP_LOGD("EVT", "wideVane.control() -> Demande un chgt de réglage de la wideVane: %s", setting);
 
-    this->setWideVaneSetting(setting);
-    this->wantedSettings.hasChanged = true;
-    this->wantedSettings.hasBeenSent = false;
-    this->wantedSettings.lastChange = CUSTOM_MILLIS;
+    int wideVane = lookupByteMapIndex(WIDEVANE_MAP, 8, setting, "wideVane select");
+    if (wideVane < 0) {
+      ESP_LOGW("EVT", "wideVane.control() -> unknown setting %s ignored", setting);
+      return;
+    }
+    this->stagedDelta_ = SettingsDelta{};
+    this->setWideVaneSetting(wideVane);
+    this->postStagedDelta();
   });
 }
 
@@ -76,15 +84,20 @@ void CN105Climate::set_airflow_control_select(
         });
 
     this->airflow_control_select_->setCallbackFunction([this](const char* setting) {
-        if (strcmp(this->currentSettings.wideVane, lookupByteMapValue(WIDEVANE_MAP, WIDEVANE, 8, 0x80 & 0x0F)) == 0) {
+        if (this->currentSettings.wideVane == HP_WIDEVANE_AIRFLOW_CONTROL) {
             ESP_LOGD("EVT", "airFlow -> Request for change of airflow control setting: %s", setting);
 
-            this->setAirflowControlSetting(setting);
+            int airflow = lookupByteMapIndex(AIRFLOW_CONTROL_MAP, 3, setting, "airflow control select");
+            if (airflow < 0) {
+                ESP_LOGW("EVT", "airFlow -> unknown setting %s ignored", setting);
+                return;
+            }
+            this->setAirflowControlSetting(airflow);
             this->wantedRunStates.hasChanged = true;
             this->wantedRunStates.hasBeenSent = false;
             this->wantedRunStates.lastChange = CUSTOM_MILLIS;
         } else {
-            this->airflow_control_select_->publish_state(this->currentRunStates.airflow_control);
+            this->airflow_control_select_->publish_state(settingLabel(AIRFLOW_CONTROL_MAP, this->currentRunStates.airflow_control, AIRFLOW_CONTROL_MAP[0]));
         }
         });
 }
@@ -114,6 +127,74 @@ void CN105Climate::set_outside_air_temperature_sensor(
     this->outside_air_temperature_sensor_ = outside_air_temperature_sensor;
 }
 
+#ifdef USE_CN105_HISTORY
+void CN105Climate::enable_history() {
+    if (this->history_ == nullptr) {
+        this->history_ = new HistoryRecorder();  // NOLINT: lives as long as the component
+    }
+}
+
+void CN105Climate::dumpHistory(const std::function<void(const char*)>& write) const {
+    if (this->history_ != nullptr) {
+        this->history_->dump(write, CUSTOM_MILLIS);
+    }
+}
+#endif
+
+#ifdef USE_CN105_ENERGY
+void CN105Climate::enable_energy(uint32_t save_interval_ms, uint32_t publish_interval_ms) {
+    if (this->energy_ == nullptr) {
+        this->energy_ = new EnergyIntegrator();  // NOLINT: lives as long as the component
+    }
+    this->energy_save_interval_ms_ = save_interval_ms;
+    this->energy_publish_interval_ms_ = publish_interval_ms;
+}
+
+void CN105Climate::set_energy_sensor(EnergyReading reading, sensor::Sensor* sensor) {
+    this->energySensors_[reading] = sensor;
+}
+
+float CN105Climate::get_energy_reading(EnergyReading reading) const {
+    return this->energy_ != nullptr ? this->energy_->get(reading) : NAN;
+}
+
+/**
+ * Restores the saved totals and publishes them every publish_interval. The integrator itself decides
+ * whether the save_interval tick is worth a flash write.
+ */
+void CN105Climate::setupEnergy() {
+    if (this->energy_ == nullptr) {
+        return;
+    }
+    this->energy_->init(fnv1_hash("cn105_energy") ^ this->get_object_id_hash(), this->energy_save_interval_ms_);
+    this->publishEnergySensors();
+    this->set_interval("energy_publish", this->energy_publish_interval_ms_, [this]() {
+        this->publishEnergySensors();
+        this->energy_->loop(CUSTOM_MILLIS);
+    });
+}
+
+void CN105Climate::publishEnergySensors() {
+    for (uint8_t i = 0; i < ENERGY_READING_COUNT; i++) {
+        float value = this->energy_->get(static_cast<EnergyReading>(i));
+        if (this->energySensors_[i] != nullptr && !std::isnan(value)) {
+            this->energySensors_[i]->publish_state(value);
+        }
+    }
+}
+
+// reboot propre (OTA, bouton restart): rien de ce qui a été intégré depuis la dernière sauvegarde n'est perdu
+void CN105Climate::on_safe_shutdown() {
+    if (this->energy_ != nullptr) {
+        this->energy_->save();
+    }
+}
+#endif
+
+void CN105Climate::set_publish_policy(PublishedSensor sensor, float deadband, uint32_t min_interval_ms, uint32_t max_interval_ms) {
+    this->publishPolicies_[sensor].configure(deadband, min_interval_ms, max_interval_ms);
+}
+
 void CN105Climate::set_isee_sensor(esphome::binary_sensor::BinarySensor* iSee_sensor) {
     this->iSee_sensor_ = iSee_sensor;
 }
@@ -233,10 +314,7 @@ void CN105Climate::add_hardware_setting(HardwareSettingSelect* setting) {
 
         // Optimistic update done in component
 
-        // Update internal structure
-        this->functions.setValue(setting->get_code(), int_value);
-
-        // Trigger write to device
-        this->setFunctions(this->functions);
+        // collected with the other changes of the window, written by commitHardwareSettingsBatch()
+        this->stageHardwareSetting(setting->get_code(), int_value);
         });
 }
@@ -10,13 +10,7 @@ void CN105Climate::getFunctions() {
 
     functions.clear();
 
-    uint8_t packet1[PACKET_LEN] = {};
-
-    prepareInfoPacket(packet1, PACKET_LEN);
-    packet1[5] = FUNCTIONS_GET_PART1;
-    packet1[21] = checkSum(packet1, 21);
-
-    writePacket(packet1, PACKET_LEN);
+    this->buildAndSendInfoPacket(FUNCTIONS_GET_PART1);
 
     // Read command will issue part 2.
 }
@@ -24,13 +18,7 @@ void CN105Climate::getFunctions() {
 void CN105Climate::getFunctionsPart2() {
     ESP_LOGV(TAG, "getting the list of functions part 2...");
 
-    uint8_t packet2[PACKET_LEN] = {};
-
-    prepareInfoPacket(packet2, PACKET_LEN);
-    packet2[5] = FUNCTIONS_GET_PART2;
-    packet2[21] = checkSum(packet2, 21);
-
-    writePacket(packet2, PACKET_LEN);
+    this->buildAndSendInfoPacket(FUNCTIONS_GET_PART2);
 }
 
 void CN105Climate::functionsArrived() {
@@ -42,20 +30,16 @@ void CN105Climate::functionsArrived() {
     size_t remaining = sizeof(states);
     char* pos = states;
 
-    heatpumpFunctionCodes codes = functions.getAllCodes();
-    for (int i = 0; i < MAX_FUNCTION_CODE_COUNT; ++i) {
-        if (codes.valid[i]) {
-            int code = codes.code[i];
-            int value = functions.getValue(code);
-            if (value > 0) {  // only values 1, 2, 3 are valid -- 0 values mean something the device does not support
-                int written = snprintf(pos, remaining, "%i: %i ", code, value);
-                if (written < 0 || static_cast<size_t>(written) >= remaining) {
-                    // Buffer full or error
-                    break;
-                }
-                pos += written;
-                remaining -= written;
+    for (int code = FUNCTION_CODE_MIN; code <= FUNCTION_CODE_MAX; ++code) {
+        int value = functions.getValue(code);
+        if (value > 0) {  // only values 1, 2, 3 are valid -- 0 values mean something the device does not support
+            int written = snprintf(pos, remaining, "%i: %i ", code, value);
+            if (written < 0 || static_cast<size_t>(written) >= remaining) {
+                // Buffer full or error
+                break;
             }
+            pos += written;
+            remaining -= written;
         }
     }
 
@@ -66,6 +50,9 @@ void CN105Climate::functionsArrived() {
 
     // Update Hardware Settings Selects
     for (auto* setting : this->hardware_settings_) {
+        if (this->isHardwareSettingStaged(setting->get_code())) {
+            continue;   // keeps the value chosen by the user until the batch is written
+        }
         int val = functions.getValue(setting->get_code());
         if (val > 0) {
             setting->update_state_from_value(val);
@@ -76,54 +63,144 @@ void CN105Climate::functionsArrived() {
 }
 
 bool CN105Climate::setFunctions(heatpumpFunctions const& functions) {
+    return this->writeFunctionParts(functions, true, true);
+}
+
+bool CN105Climate::writeFunctionParts(heatpumpFunctions const& functions, bool part1, bool part2) {
     if (!functions.isValid()) {
         return false;
     }
 
-    uint8_t packet1[PACKET_LEN] = {};
-    uint8_t packet2[PACKET_LEN] = {};
+    uint8_t packet[PACKET_LEN];
+    uint8_t data[PACKET_DATA_LEN] = {};
 
-    prepareSetPacket(packet1, PACKET_LEN);
-    packet1[5] = FUNCTIONS_SET_PART1;
+    // sanity checks on data byte 15 and on zero bytes were REMOVED for Bug #485 - newer units use these bytes
 
-    prepareSetPacket(packet2, PACKET_LEN);
-    packet2[5] = FUNCTIONS_SET_PART2;
+    if (part1) {
+        functions.getData1(data);
+        PacketEncoder(packet, MSG_SET_FUNCTIONS_1).set_data(data, PACKET_DATA_OFFSET, PACKET_DATA_LEN);
+        ESP_LOGD(TAG, "sending a setFunctions packet part 1");
+        if (!this->enqueuePacket(packet, PACKET_LEN)) {
+            return false;
+        }
+    }
+    if (part2) {
+        functions.getData2(data);
+        PacketEncoder(packet, MSG_SET_FUNCTIONS_2).set_data(data, PACKET_DATA_OFFSET, PACKET_DATA_LEN);
+        ESP_LOGD(TAG, "sending a setFunctions packet part 2");
+        if (!this->enqueuePacket(packet, PACKET_LEN)) {
+            return false;
+        }
+    }
 
-    functions.getData1(&packet1[6]);
-    functions.getData2(&packet2[6]);
+    return true;
+}
 
-    // sanity check, we expect data byte 15 (index 20) to be 0
-    // REMOVED for Bug #485 - newer units use these bytes
-    // if (packet1[20] != 0 || packet2[20] != 0)
-    //    return false;
+bool CN105Climate::isHardwareSettingStaged(int code) const {
+    for (const auto& staged : this->hwSettingsStaged_) {
+        if (staged.first == code) return true;
+    }
+    return false;
+}
 
-    // make sure all the other data bytes are set
-    // REMOVED for Bug #485
-    /* for (int i = 6; i < 20; ++i) {
-        if (packet1[i] == 0 || packet2[i] == 0)
-            return false;
-    } */
-
-    packet1[21] = checkSum(packet1, 21);
-    packet2[21] = checkSum(packet2, 21);
-    /*
-        while (!canSend(false)) {
-            //esphome::CUSTOM_DELAY(10);
-            CUSTOM_DELAY(10);
-        }*/
-    ESP_LOGD(TAG, "sending a setFunctions packet part 1");
-    writePacket(packet1, PACKET_LEN);
-    //readPacket();
-
-    /*while (!canSend(false)) {
-        //esphome::CUSTOM_DELAY(10);
-        CUSTOM_DELAY(10);
-    }*/
-    ESP_LOGD(TAG, "sending a setFunctions packet part 2");
-    writePacket(packet2, PACKET_LEN);
-    //readPacket();
+void CN105Climate::stageHardwareSetting(int code, int value) {
+    bool replaced = false;
+    for (auto& staged : this->hwSettingsStaged_) {
+        if (staged.first == code) {
+            staged.second = value;
+            replaced = true;
+        }
+    }
+    if (!replaced) {
+        this->hwSettingsStaged_.emplace_back(code, value);
+    }
+    ESP_LOGD(LOG_FUNCTIONS_TAG, "Code %d -> %d staged (%d pending)", code, value, (int) this->hwSettingsStaged_.size());
+    // each change restarts the window: a burst of select changes ends up in one write
+    this->set_timeout("hw_settings_batch", HW_SETTINGS_BATCH_WINDOW_MS, [this]() { this->commitHardwareSettingsBatch(); });
+}
 
-    return true;
+/**
+ * Read: both function tables are refreshed unless they were read within HW_SETTINGS_READ_MAX_AGE_MS,
+ * the staged values are then applied on what the unit really holds
+ */
+void CN105Climate::commitHardwareSettingsBatch() {
+    if (this->hwSettingsStaged_.empty()) {
+        return;
+    }
+    if (this->hwSettingsBatchInFlight_) {
+        // one transaction at a time, the new changes go with the next one
+        this->set_timeout("hw_settings_batch", HW_SETTINGS_BATCH_WINDOW_MS, [this]() { this->commitHardwareSettingsBatch(); });
+        return;
+    }
+    this->hwSettingsBatchInFlight_ = true;
+    ESP_LOGI(LOG_FUNCTIONS_TAG, "Applying %d hardware setting change(s)", (int) this->hwSettingsStaged_.size());
+
+    this->refresh(FUNCTIONS_GET_PART1, HW_SETTINGS_READ_MAX_AGE_MS, [this](bool fresh1) {
+        this->refresh(FUNCTIONS_GET_PART2, HW_SETTINGS_READ_MAX_AGE_MS, [this, fresh1](bool fresh2) {
+            this->writeHardwareSettingsBatch(fresh1 && fresh2);
+            });
+        });
+}
+
+/**
+ * Modify + write: only the packet(s) whose half changed are sent, then read back right away
+ */
+void CN105Climate::writeHardwareSettingsBatch(bool fresh) {
+    if (!fresh || !this->functions.isValid()) {
+        ESP_LOGW(LOG_FUNCTIONS_TAG, "Function tables could not be read, %d hardware setting change(s) dropped",
+            (int) this->hwSettingsStaged_.size());
+        this->hwSettingsStaged_.clear();
+        this->hwSettingsBatchInFlight_ = false;
+        if (this->functions.isValid()) {
+            this->functionsArrived();       // selects back to the unit's values
+        }
+        return;
+    }
+
+    heatpumpFunctions target = this->functions;
+    for (const auto& staged : this->hwSettingsStaged_) {
+        if (!target.setValue(staged.first, staged.second)) {
+            ESP_LOGW(LOG_FUNCTIONS_TAG, "Code %d not reported by the unit, value %d not written", staged.first, staged.second);
+        }
+    }
+    this->hwSettingsStaged_.clear();
+
+    bool part1 = !target.sameData1(this->functions);
+    bool part2 = !target.sameData2(this->functions);
+    if (!part1 && !part2) {
+        ESP_LOGI(LOG_FUNCTIONS_TAG, "Hardware settings already applied, nothing written");
+        this->hwSettingsBatchInFlight_ = false;
+        this->functionsArrived();
+        return;
+    }
+
+    this->writeFunctionParts(target, part1, part2);
+    this->hwSettingsExpected_ = target;
+
+    // Verify: targeted read of what was just written
+    auto verify = [this](bool fresh) { this->verifyHardwareSettingsBatch(fresh); };
+    if (part1 && part2) {
+        this->refresh(FUNCTIONS_GET_PART1, 0, [this, verify](bool fresh1) {
+            this->refresh(FUNCTIONS_GET_PART2, 0, [verify, fresh1](bool fresh2) { verify(fresh1 && fresh2); });
+            });
+    } else {
+        this->refresh(part1 ? FUNCTIONS_GET_PART1 : FUNCTIONS_GET_PART2, 0, verify);
+    }
+}
+
+void CN105Climate::verifyHardwareSettingsBatch(bool fresh) {
+    this->hwSettingsBatchInFlight_ = false;
+    bool applied = fresh && this->hwSettingsExpected_.sameData1(this->functions) && this->hwSettingsExpected_.sameData2(this->functions);
+    if (applied) {
+        ESP_LOGI(LOG_FUNCTIONS_TAG, "Hardware settings written and verified");
+    } else {
+        ESP_LOGW(LOG_FUNCTIONS_TAG, "Hardware settings not confirmed by the verification read (%s)", fresh ? "values differ" : "no reply");
+    }
+    this->functionsArrived();           // selects and functions sensor show what the unit reports
+
+    if (!this->hwSettingsStaged_.empty()) {
+        this->set_timeout("hw_settings_batch", HW_SETTINGS_BATCH_WINDOW_MS, [this]() { this->commitHardwareSettingsBatch(); });
+    }
 }
 
 
@@ -138,11 +215,23 @@ bool heatpumpFunctions::isValid() const {
 void heatpumpFunctions::setData1(uint8_t* data) {
     memcpy(raw, data, 15);
     _isValid1 = true;
+    buildIndex();
 }
 
 void heatpumpFunctions::setData2(uint8_t* data) {
     memcpy(raw + 15, data, 15);
     _isValid2 = true;
+    buildIndex();
+}
+
+void heatpumpFunctions::buildIndex() {
+    memset(slot, -1, sizeof(slot));
+    for (int i = 0; i < MAX_FUNCTION_CODE_COUNT; ++i) {
+        int code = getCode(raw[i]);
+        if (code >= FUNCTION_CODE_MIN && code <= FUNCTION_CODE_MAX && slot[code - FUNCTION_CODE_MIN] < 0) {
+            slot[code - FUNCTION_CODE_MIN] = static_cast<int8_t>(i);      // first occurrence wins, as the former linear scan
+        }
+    }
 }
 
 void heatpumpFunctions::getData1(uint8_t* data) const {
@@ -153,8 +242,17 @@ void heatpumpFunctions::getData2(uint8_t* data) const {
     memcpy(data, raw + 15, 15);
 }
 
+bool heatpumpFunctions::sameData1(const heatpumpFunctions& other) const {
+    return memcmp(raw, other.raw, 15) == 0;
+}
+
+bool heatpumpFunctions::sameData2(const heatpumpFunctions& other) const {
+    return memcmp(raw + 15, other.raw + 15, 15) == 0;
+}
+
 void heatpumpFunctions::clear() {
     memset(raw, 0, sizeof(raw));
+    memset(slot, -1, sizeof(slot));
     _isValid1 = false;
     _isValid2 = false;
 }
@@ -167,51 +265,34 @@ int heatpumpFunctions::getValue(uint8_t b) {
     return b & 3;
 }
 
-int heatpumpFunctions::getValue(int code) {
-    if (code > 128 || code < 101)
+int heatpumpFunctions::getValue(int code) const {
+    if (code > FUNCTION_CODE_MAX || code < FUNCTION_CODE_MIN)
         return 0;
 
-    for (int i = 0; i < MAX_FUNCTION_CODE_COUNT; ++i) {
-        if (getCode(raw[i]) == code)
-            return getValue(raw[i]);
-    }
-
-    return 0;
+    int i = slot[code - FUNCTION_CODE_MIN];
+    return (i < 0) ? 0 : getValue(raw[i]);
 }
 
 bool heatpumpFunctions::setValue(int code, int value) {
-    if (code > 128 || code < 101)
+    if (code > FUNCTION_CODE_MAX || code < FUNCTION_CODE_MIN)
         return false;
 
     if (value < 1 || value > 3)
         return false;
 
-    for (int i = 0; i < MAX_FUNCTION_CODE_COUNT; ++i) {
-        if (getCode(raw[i]) == code) {
-            raw[i] = ((code - 100) << 2) + value;
-            return true;
-        }
-    }
-
-    return false;
-}
-
-heatpumpFunctionCodes heatpumpFunctions::getAllCodes() {
-    heatpumpFunctionCodes result;
-    for (int i = 0; i < MAX_FUNCTION_CODE_COUNT; ++i) {
-        int code = getCode(raw[i]);
-        result.code[i] = code;
-        result.valid[i] = (code >= 101 && code <= 128);
-    }
+    int i = slot[code - FUNCTION_CODE_MIN];
+    if (i < 0)
+        return false;
 
-    return result;
+    raw[i] = ((code - 100) << 2) + value;      // same code, the index stays valid
+    return true;
 }
 
-bool heatpumpFunctions::operator==(const heatpumpFunctions& rhs) {
-    return this->isValid() == rhs.isValid() && memcmp(this->raw, rhs.raw, MAX_FUNCTION_CODE_COUNT * sizeof(int)) == 0;
+bool heatpumpFunctions::operator==(const heatpumpFunctions& rhs) const {
+    return this->isValid() == rhs.isValid() && memcmp(this->raw, rhs.raw, sizeof(this->raw)) == 0;
 }
 
-bool heatpumpFunctions::operator!=(const heatpumpFunctions& rhs) {
+bool heatpumpFunctions::operator!=(const heatpumpFunctions& rhs) const {
     return !(*this == rhs);
 }
 //#endregion heatpump_functions
@@ -4,11 +4,8 @@
 
 
 #define MAX_FUNCTION_CODE_COUNT 30
-
-struct heatpumpFunctionCodes {
-    bool valid[MAX_FUNCTION_CODE_COUNT];
-    int code[MAX_FUNCTION_CODE_COUNT];
-};
+#define FUNCTION_CODE_MIN 101
+#define FUNCTION_CODE_MAX 128
 
 
 
@@ -16,11 +13,14 @@ struct heatpumpFunctionCodes {
 class heatpumpFunctions {
 private:
     uint8_t raw[MAX_FUNCTION_CODE_COUNT];
+    // code -> index in raw, -1 if the unit did not report the code; rebuilt by setData1()/setData2()
+    int8_t slot[FUNCTION_CODE_MAX - FUNCTION_CODE_MIN + 1];
     bool _isValid1;
     bool _isValid2;
 
-    int getCode(uint8_t b);
-    int getValue(uint8_t b);
+    static int getCode(uint8_t b);
+    static int getValue(uint8_t b);
+    void buildIndex();
 
 public:
     heatpumpFunctions();
@@ -32,14 +32,16 @@ public:
     void setData2(uint8_t* data);
     void getData1(uint8_t* data) const;
     void getData2(uint8_t* data) const;
+    // true if the 15 bytes half (packet 0x1F/0x20 or 0x21/0x22) is identical
+    bool sameData1(const heatpumpFunctions& other) const;
+    bool sameData2(const heatpumpFunctions& other) const;
 
     void clear();
 
-    int getValue(int code);
+    // codes are FUNCTION_CODE_MIN..FUNCTION_CODE_MAX, getValue() returns 0 for a code the unit did not report
+    int getValue(int code) const;
     bool setValue(int code, int value);
 
-    heatpumpFunctionCodes getAllCodes();
-
-    bool operator==(const heatpumpFunctions& rhs);
-    bool operator!=(const heatpumpFunctions& rhs);
+    bool operator==(const heatpumpFunctions& rhs) const;
+    bool operator!=(const heatpumpFunctions& rhs) const;
 };
@@ -0,0 +1,176 @@
+#include "history.h"
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+using namespace esphome;
+
+void HistoryRecorder::Accumulator::add(const HistorySample& sample) {
+    if (sample.roomHalves != HistorySample::UNKNOWN_TEMPERATURE) {
+        this->roomSum += sample.roomHalves;
+        this->roomCount++;
+    }
+    if (sample.outsideHalves != HistorySample::UNKNOWN_TEMPERATURE) {
+        this->outsideSum += sample.outsideHalves;
+        this->outsideCount++;
+    }
+    if (sample.inputPowerW != HistorySample::UNKNOWN_POWER) {
+        this->powerSum += sample.inputPowerW;
+        this->powerCount++;
+    }
+    if (sample.compressorHz != HistorySample::UNKNOWN_FREQUENCY) {
+        this->frequencySum += sample.compressorHz;
+        this->frequencyCount++;
+    }
+    if (sample.stage != SETTING_UNSET) {
+        this->stage = sample.stage;
+    }
+}
+
+HistorySample HistoryRecorder::Accumulator::average() const {
+    HistorySample sample;
+    if (this->roomCount > 0) {
+        sample.roomHalves = static_cast<int16_t>(lroundf(static_cast<float>(this->roomSum) / this->roomCount));
+    }
+    if (this->outsideCount > 0) {
+        sample.outsideHalves = static_cast<int16_t>(lroundf(static_cast<float>(this->outsideSum) / this->outsideCount));
+    }
+    if (this->powerCount > 0) {
+        sample.inputPowerW = static_cast<uint16_t>((this->powerSum + this->powerCount / 2) / this->powerCount);
+    }
+    if (this->frequencyCount > 0) {
+        sample.compressorHz = static_cast<uint8_t>((this->frequencySum + this->frequencyCount / 2) / this->frequencyCount);
+    }
+    sample.stage = this->stage;
+    return sample;
+}
+
+void HistoryRecorder::record_status(HalfDegrees room, HalfDegrees outside, float input_power, float compressor_frequency, uint32_t now) {
+    this->loop(now);
+    if (!this->started_) {
+        this->start_(now);
+    }
+    HistorySample sample;
+    if (room.is_set()) {
+        sample.roomHalves = room.halves();
+    }
+    if (outside.is_set()) {
+        sample.outsideHalves = outside.halves();
+    }
+    if (!std::isnan(input_power) && input_power >= 0.0f && input_power < HistorySample::UNKNOWN_POWER) {
+        sample.inputPowerW = static_cast<uint16_t>(input_power);
+    }
+    if (!std::isnan(compressor_frequency) && compressor_frequency >= 0.0f && compressor_frequency < HistorySample::UNKNOWN_FREQUENCY) {
+        sample.compressorHz = static_cast<uint8_t>(compressor_frequency);
+    }
+    this->minute_.add(sample);
+}
+
+void HistoryRecorder::record_stage(uint8_t stage, uint32_t now) {
+    this->loop(now);
+    if (!this->started_) {
+        this->start_(now);
+    }
+    if (stage != SETTING_UNSET) {
+        this->minute_.stage = stage;
+    }
+}
+
+void HistoryRecorder::start_(uint32_t now) {
+    this->started_ = true;
+    this->minute_start_ms_ = now;
+    this->tiers_.write([now](Tiers& tiers) { tiers.minuteStartMs = now; });
+}
+
+void HistoryRecorder::loop(uint32_t now) {
+    if (!this->started_) {
+        return;
+    }
+    // loop() is never blocked for long: at most one minute closes per call in practice
+    uint16_t closed = 0;
+    while ((now - this->minute_start_ms_) >= HISTORY_MINUTE_MS) {
+        if (++closed > HISTORY_QUARTER_SLOTS * HISTORY_MINUTES_PER_QUARTER) {
+            this->minute_start_ms_ = now;   // both tiers are already full of unknown points
+            this->tiers_.write([now](Tiers& tiers) { tiers.minuteStartMs = now; });
+            break;
+        }
+        this->close_minute_();
+    }
+}
+
+void HistoryRecorder::close_minute_() {
+    HistorySample sample = this->minute_.average();
+    this->quarter_.add(sample);
+    this->minute_ = Accumulator();
+    this->minute_start_ms_ += HISTORY_MINUTE_MS;
+
+    bool quarter_closed = ++this->minutes_in_quarter_ >= HISTORY_MINUTES_PER_QUARTER;
+    HistorySample quarter;
+    if (quarter_closed) {
+        quarter = this->quarter_.average();
+        this->quarter_ = Accumulator();
+        this->minutes_in_quarter_ = 0;
+    }
+
+    this->tiers_.write([&](Tiers& tiers) {
+        tiers.minutes.push(sample);
+        if (quarter_closed) {
+            tiers.quarters.push(quarter);
+        }
+        tiers.minuteStartMs = this->minute_start_ms_;
+        tiers.minutesInQuarter = this->minutes_in_quarter_;
+        });
+}
+
+void HistoryRecorder::dump(const std::function<void(const char*)>& write, uint32_t now) const {
+    // ~1.7 kB: on the heap, the web server task has a small stack (SeqLock::read copies in place)
+    std::unique_ptr<Tiers> tiers(new Tiers());
+    if (!this->tiers_.read(*tiers)) {
+        write("null");
+        return;
+    }
+    uint32_t minute_age_s = (now - tiers->minuteStartMs) / 1000;
+    uint32_t quarter_age_s = minute_age_s + tiers->minutesInQuarter * (HISTORY_MINUTE_MS / 1000);
+
+    const Tiers& copy = *tiers;
+    write("{\"tiers\":[");
+    dump_tier_(write, HISTORY_MINUTE_MS / 1000, minute_age_s, copy.minutes.size(),
+        [&copy](uint16_t index) -> const HistorySample& { return copy.minutes.at(index); });
+    write(",");
+    dump_tier_(write, HISTORY_MINUTES_PER_QUARTER * HISTORY_MINUTE_MS / 1000, quarter_age_s, copy.quarters.size(),
+        [&copy](uint16_t index) -> const HistorySample& { return copy.quarters.at(index); });
+    write("]}");
+}
+
+void HistoryRecorder::dump_tier_(const std::function<void(const char*)>& write, uint32_t period_s, uint32_t newest_age_s,
+    uint16_t count, const std::function<const HistorySample& (uint16_t)>& at) {
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "{\"period_s\":%u,\"newest_age_s\":%u,", (unsigned) period_s, (unsigned) newest_age_s);
+    write(buffer);
+    write("\"fields\":[\"room_c\",\"outside_c\",\"input_power_w\",\"compressor_hz\",\"stage\"],\"samples\":[");
+
+    for (uint16_t i = 0; i < count; i++) {
+        const HistorySample& sample = at(i);
+        char room[8] = "null";
+        char outside[8] = "null";
+        char power[8] = "null";
+        char frequency[8] = "null";
+        if (sample.roomHalves != HistorySample::UNKNOWN_TEMPERATURE) {
+            snprintf(room, sizeof(room), "%.1f", sample.roomHalves * 0.5f);
+        }
+        if (sample.outsideHalves != HistorySample::UNKNOWN_TEMPERATURE) {
+            snprintf(outside, sizeof(outside), "%.1f", sample.outsideHalves * 0.5f);
+        }
+        if (sample.inputPowerW != HistorySample::UNKNOWN_POWER) {
+            snprintf(power, sizeof(power), "%u", (unsigned) sample.inputPowerW);
+        }
+        if (sample.compressorHz != HistorySample::UNKNOWN_FREQUENCY) {
+            snprintf(frequency, sizeof(frequency), "%u", (unsigned) sample.compressorHz);
+        }
+        const char* stage = settingLabel(STAGE_MAP, sample.stage, nullptr);
+        snprintf(buffer, sizeof(buffer), "%s[%s,%s,%s,%s,%s%s%s]", i == 0 ? "" : ",", room, outside, power, frequency,
+            stage != nullptr ? "\"" : "", stage != nullptr ? stage : "null", stage != nullptr ? "\"" : "");
+        write(buffer);
+    }
+    write("]}");
+}
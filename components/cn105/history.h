@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include "cn105_types.h"
+#include "state_snapshot.h"
+
+namespace esphome {
+
+    /**
+     * @brief Un point d'historique, en entiers (8 octets)
+     *
+     * Pas d'horodatage: la position dans le tier et l'âge du point le plus récent suffisent.
+     */
+    struct HistorySample {
+        static constexpr int16_t UNKNOWN_TEMPERATURE = INT16_MIN;
+        static constexpr uint16_t UNKNOWN_POWER = 0xFFFF;
+        static constexpr uint8_t UNKNOWN_FREQUENCY = 0xFF;
+
+        int16_t roomHalves = UNKNOWN_TEMPERATURE;       // demi-degrés Celsius (valeur de l'unité)
+        int16_t outsideHalves = UNKNOWN_TEMPERATURE;
+        uint16_t inputPowerW = UNKNOWN_POWER;
+        uint8_t compressorHz = UNKNOWN_FREQUENCY;
+        uint8_t stage = SETTING_UNSET;                  // index STAGE_MAP
+    };
+    static_assert(sizeof(HistorySample) == 8, "HistorySample must stay compact");
+
+    template<uint16_t N>
+    class HistoryRing {
+    public:
+        void push(const HistorySample& sample) {
+            this->slots_[this->head_] = sample;
+            this->head_ = (this->head_ + 1) % N;
+            if (this->count_ < N) {
+                this->count_++;
+            }
+        }
+        uint16_t size() const { return this->count_; }
+        // 0 = le plus ancien
+        const HistorySample& at(uint16_t index) const { return this->slots_[(this->head_ + N - this->count_ + index) % N]; }
+
+    private:
+        HistorySample slots_[N];
+        uint16_t head_ = 0;
+        uint16_t count_ = 0;
+    };
+
+    /**
+     * @class HistoryRecorder
+     * @brief Historique embarqué: moyennes par minute (2 h) et par quart d'heure (24 h)
+     *
+     * Les trames 0x03 / 0x06 / 0x09 alimentent la minute en cours. Chaque minute close part dans le tier 1 min
+     * et s'ajoute au quart d'heure en cours. Une minute sans trame (unité déconnectée) donne un point inconnu,
+     * la cadence des tiers reste fixe. Le stage retenu est le dernier reçu dans la période.
+     *
+     * Les tiers sont écrits depuis loop() et lus par le serveur web, qui peut tourner dans une autre tâche (ESP32):
+     * ils sont publiés sous SeqLock et dump() travaille sur une copie cohérente.
+     */
+    class HistoryRecorder {
+    public:
+        void record_status(HalfDegrees room, HalfDegrees outside, float input_power, float compressor_frequency, uint32_t now);
+        void record_stage(uint8_t stage, uint32_t now);
+
+        /// ferme les minutes écoulées, à appeler depuis loop()
+        void loop(uint32_t now);
+
+        /// JSON des deux tiers, du plus ancien au plus récent, écrit par morceaux; "null" si aucune copie cohérente
+        void dump(const std::function<void(const char*)>& write, uint32_t now) const;
+
+        /// taille maximale du JSON de dump(), pour borner la réponse HTTP
+        static constexpr size_t DUMP_MAX_BYTES = 2 * 160 + (HISTORY_MINUTE_SLOTS + HISTORY_QUARTER_SLOTS) * 44 + 16;
+
+    private:
+        struct Accumulator {
+            int32_t roomSum = 0;
+            int32_t outsideSum = 0;
+            uint32_t powerSum = 0;
+            uint32_t frequencySum = 0;
+            uint16_t roomCount = 0;
+            uint16_t outsideCount = 0;
+            uint16_t powerCount = 0;
+            uint16_t frequencyCount = 0;
+            uint8_t stage = SETTING_UNSET;
+
+            void add(const HistorySample& sample);
+            HistorySample average() const;
+        };
+
+        // état lu par dump(), copié d'un bloc
+        struct Tiers {
+            uint32_t minuteStartMs = 0;
+            uint8_t minutesInQuarter = 0;
+            HistoryRing<HISTORY_MINUTE_SLOTS> minutes;
+            HistoryRing<HISTORY_QUARTER_SLOTS> quarters;
+        };
+
+        void start_(uint32_t now);
+        void close_minute_();
+        static void dump_tier_(const std::function<void(const char*)>& write, uint32_t period_s, uint32_t newest_age_s,
+            uint16_t count, const std::function<const HistorySample& (uint16_t)>& at);
+
+        bool started_ = false;
+        uint32_t minute_start_ms_ = 0;
+        uint8_t minutes_in_quarter_ = 0;
+        Accumulator minute_;
+        Accumulator quarter_;
+        SeqLock<Tiers> tiers_;
+    };
+
+}
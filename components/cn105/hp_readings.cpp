@@ -116,6 +116,7 @@ bool CN105Climate::processInput(void) {
         processed = true;
         uint8_t inputData;
         if (this->get_hw_serial_()->read_byte(&inputData)) {
+            this->linkStats_.rxBytes++;
             parse(inputData);
         }
 
@@ -134,9 +135,14 @@ void CN105Climate::processDataPacket() {
     if (this->checkSum()) {
         // checkPoint of a heatpump response
         this->lastResponseMs = CUSTOM_MILLIS;    //esphome::CUSTOM_MILLIS;
+        this->heartbeat_missed_ = 0;                // any reply breaks a run of missed heartbeats
+        this->linkStats_.rxFrames++;
 
         // processing the specific command
         processCommand();
+    } else {
+        this->linkStats_.checksumErrors++;
+        this->reportLinkError("checksum error");
     }
 }
 
@@ -163,35 +169,55 @@ void CN105Climate::getPowerFromResponsePacket() {
     ESP_LOGD("Decoder", "[0x09 is sub modes]");
 
     heatpumpSettings receivedSettings{};
-    receivedSettings.stage = lookupByteMapValue(STAGE_MAP, STAGE, 7, data[4], "current stage for delivery");
-    receivedSettings.sub_mode = lookupByteMapValue(SUB_MODE_MAP, SUB_MODE, 4, data[3], "submode");
-    receivedSettings.auto_sub_mode = lookupByteMapValue(AUTO_SUB_MODE_MAP, AUTO_SUB_MODE, 4, data[5], "auto mode sub mode");
-
-    ESP_LOGD("Decoder", "[Stage : %s]", receivedSettings.stage);
-    ESP_LOGD("Decoder", "[Sub Mode  : %s]", receivedSettings.sub_mode);
-    ESP_LOGD("Decoder", "[Auto Mode Sub Mode  : %s]", receivedSettings.auto_sub_mode);
+    receivedSettings.stage = decodeSettingByte(STAGE, 7, data[4], "current stage for delivery");
+    receivedSettings.sub_mode = decodeSettingByte(SUB_MODE, 4, data[3], "submode");
+    receivedSettings.auto_sub_mode = decodeSettingByte(AUTO_SUB_MODE, 4, data[5], "auto mode sub mode");
+
+    ESP_LOGD("Decoder", "[Stage : %s]", STAGE_MAP[receivedSettings.stage]);
+    ESP_LOGD("Decoder", "[Sub Mode  : %s]", SUB_MODE_MAP[receivedSettings.sub_mode]);
+    ESP_LOGD("Decoder", "[Auto Mode Sub Mode  : %s]", AUTO_SUB_MODE_MAP[receivedSettings.auto_sub_mode]);
+
+    this->updateSnapshot([&](StateSnapshot& state, uint32_t now) {
+        state.settings.stage = receivedSettings.stage;
+        state.settings.sub_mode = receivedSettings.sub_mode;
+        state.settings.auto_sub_mode = receivedSettings.auto_sub_mode;
+        state.touch(SNAPSHOT_STAGE, now);
+        state.touch(SNAPSHOT_SUB_MODE, now);
+        state.touch(SNAPSHOT_AUTO_SUB_MODE, now);
+    });
+
+#ifdef USE_CN105_HISTORY
+    if (this->history_ != nullptr) {
+        this->history_->record_stage(receivedSettings.stage, CUSTOM_MILLIS);
+    }
+#endif
+#ifdef USE_CN105_ENERGY
+    if (this->energy_ != nullptr) {
+        this->energy_->on_sub_mode(receivedSettings.sub_mode, CUSTOM_MILLIS);
+    }
+#endif
 
     //this->heatpumpUpdate(receivedSettings);
     if (this->stage_sensor_ != nullptr) {
-        if (!this->currentSettings.stage || strcmp(receivedSettings.stage, this->currentSettings.stage) != 0) {
+        if (receivedSettings.stage != this->currentSettings.stage) {
             this->currentSettings.stage = receivedSettings.stage;
-            this->stage_sensor_->publish_state(receivedSettings.stage);
+            this->stage_sensor_->publish_state(STAGE_MAP[receivedSettings.stage]);
 
             // If using stage as operating fallback, update action immediately when stage changes
-            // and publish to Home Assistant
-            if (this->use_stage_for_operating_status_) {
+            // and publish to Home Assistant at the end of the cycle
+            if (this->useStageForOperatingStatus()) {
                 this->updateAction();
-                this->publish_state();
+                this->markClimateDirty();
             }
         }
     }
-    if (this->Sub_mode_sensor_ != nullptr && (!this->currentSettings.sub_mode || strcmp(receivedSettings.sub_mode, this->currentSettings.sub_mode) != 0)) {
+    if (this->Sub_mode_sensor_ != nullptr && (receivedSettings.sub_mode != this->currentSettings.sub_mode)) {
         this->currentSettings.sub_mode = receivedSettings.sub_mode;
-        this->Sub_mode_sensor_->publish_state(receivedSettings.sub_mode);
+        this->Sub_mode_sensor_->publish_state(SUB_MODE_MAP[receivedSettings.sub_mode]);
     }
-    if (this->Auto_sub_mode_sensor_ != nullptr && (!this->currentSettings.auto_sub_mode || strcmp(receivedSettings.auto_sub_mode, this->currentSettings.auto_sub_mode) != 0)) {
+    if (this->Auto_sub_mode_sensor_ != nullptr && (receivedSettings.auto_sub_mode != this->currentSettings.auto_sub_mode)) {
         this->currentSettings.auto_sub_mode = receivedSettings.auto_sub_mode;
-        this->Auto_sub_mode_sensor_->publish_state(receivedSettings.auto_sub_mode);
+        this->Auto_sub_mode_sensor_->publish_state(AUTO_SUB_MODE_MAP[receivedSettings.auto_sub_mode]);
     }
 }
 
@@ -201,42 +227,45 @@ void CN105Climate::getSettingsFromResponsePacket() {
     ESP_LOGD("Decoder", "[0x02 is settings]");
 
     receivedSettings.connected = true;
-    receivedSettings.power = lookupByteMapValue(POWER_MAP, POWER, 2, data[3], "power reading");
+    receivedSettings.power = decodeSettingByte(POWER, 2, data[3], "power reading");
     receivedSettings.iSee = data[4] > 0x08 ? true : false;
-    receivedSettings.mode = lookupByteMapValue(MODE_MAP, MODE, 5, receivedSettings.iSee ? (data[4] - 0x08) : data[4], "mode reading");
+    receivedSettings.mode = decodeSettingByte(MODE, 5, receivedSettings.iSee ? (data[4] - 0x08) : data[4], "mode reading");
 
-    ESP_LOGD("Decoder", "[Power : %s]", receivedSettings.power);
+    ESP_LOGD("Decoder", "[Power : %s]", POWER_MAP[receivedSettings.power]);
     ESP_LOGD("Decoder", "[iSee  : %d]", receivedSettings.iSee);
-    ESP_LOGD("Decoder", "[Mode  : %s]", receivedSettings.mode);
+    ESP_LOGD("Decoder", "[Mode  : %s]", MODE_MAP[receivedSettings.mode]);
 
     if (data[11] != 0x00) {
-        int temp = data[11];
-        temp -= 128;
-        receivedSettings.temperature = (float)temp / 2;
+        receivedSettings.temperature = HalfDegrees::from_half_byte(data[11]);
         this->tempMode = true;
     } else {
-        receivedSettings.temperature = lookupByteMapValue(TEMP_MAP, TEMP, 16, data[5], "temperature reading");
+        receivedSettings.temperature = temperature_codec::decode_setpoint_code(data[5]);
+        if (!receivedSettings.temperature.is_set()) {
+            ESP_LOGW("lookup", "temperature reading caution: value %d not found, returning value at index 0", data[5]);
+            receivedSettings.temperature = temperature_codec::decode_setpoint_code(0x00);
+        }
     }
 
-    ESP_LOGD("Decoder", "[Temp °C: %f]", receivedSettings.temperature);
+    ESP_LOGD("Decoder", "[Temp °C: %.1f]", receivedSettings.temperature.celsius());
 
-    receivedSettings.fan = lookupByteMapValue(FAN_MAP, FAN, 6, data[6], "fan reading");
-    ESP_LOGD("Decoder", "[Fan: %s]", receivedSettings.fan);
+    receivedSettings.fan = decodeSettingByte(FAN, 6, data[6], "fan reading");
+    ESP_LOGD("Decoder", "[Fan: %s]", FAN_MAP[receivedSettings.fan]);
 
-    receivedSettings.vane = lookupByteMapValue(VANE_MAP, VANE, 7, data[7], "vane reading");
-    ESP_LOGD("Decoder", "[Vane: %s]", receivedSettings.vane);
+    receivedSettings.vane = decodeSettingByte(VANE, 7, data[7], "vane reading");
+    ESP_LOGD("Decoder", "[Vane: %s]", VANE_MAP[receivedSettings.vane]);
 
     // --- START OF MODIFIED SECTION - Reverted widevane section back to more or less original state
-    if ((data[10] != 0) && (this->traits_.supports_swing_mode(climate::CLIMATE_SWING_HORIZONTAL))) {    // wideVane is not always supported
-        receivedSettings.wideVane = lookupByteMapValue(WIDEVANE_MAP, WIDEVANE, 8, data[10] & 0x0F, "wideVane reading");
+    if ((data[10] != 0) && (this->hasCapability(CAP_SWING_HORIZONTAL))) {    // wideVane is not always supported
+        receivedSettings.wideVane = decodeSettingByte(WIDEVANE, 8, data[10] & 0x0F, "wideVane reading");
         this->wideVaneAdj = (data[10] & 0xF0) == 0x80 ? true : false;
-        ESP_LOGD("Decoder", "[wideVane: %s (adj:%d)]", receivedSettings.wideVane, this->wideVaneAdj);
+        ESP_LOGD("Decoder", "[wideVane: %s (adj:%d)]", WIDEVANE_MAP[receivedSettings.wideVane], this->wideVaneAdj);
     } else {
         ESP_LOGD("Decoder", "widevane is not supported");
     }
     // --- END OF MODIFIED SECTION ---
 
-    if (this->iSee_sensor_ != nullptr) {
+    if ((this->iSee_sensor_ != nullptr) &&
+        (!this->iSee_sensor_->has_state() || (this->iSee_sensor_->state != receivedSettings.iSee))) {
         this->iSee_sensor_->publish_state(receivedSettings.iSee);
     }
 
@@ -244,26 +273,53 @@ void CN105Climate::getSettingsFromResponsePacket() {
     if (this->airflow_control_select_ != nullptr) {
         if (data[10] == 0x80) {
             if (receivedSettings.iSee) {
-                receivedRunStates.airflow_control = lookupByteMapValue(AIRFLOW_CONTROL_MAP, AIRFLOW_CONTROL, 3, data[14], "airflow control reading");
+                receivedRunStates.airflow_control = decodeSettingByte(AIRFLOW_CONTROL, 3, data[14], "airflow control reading");
             } else {
                 // For some reason data[10] is 0x80, but the i-See sensor is not active. 
                 // Some units let us do this, but the real mode is unknown (might be powersave) and the i-See sensor does not get activated.
                 //receivedRunStates.airflow_control = "N/A";
                 ESP_LOGD("Decoder", "i-See sensor not present/active.");
-                receivedRunStates.airflow_control = AIRFLOW_CONTROL_MAP[0];
+                receivedRunStates.airflow_control = HP_AIRFLOW_EVEN;
             }
         } else {
-            receivedRunStates.airflow_control = AIRFLOW_CONTROL_MAP[0];
+            receivedRunStates.airflow_control = HP_AIRFLOW_EVEN;
         }
-        if (!this->currentRunStates.airflow_control || strcmp(receivedRunStates.airflow_control, this->currentRunStates.airflow_control) != 0) {
+        if (receivedRunStates.airflow_control != this->currentRunStates.airflow_control) {
             this->currentRunStates.airflow_control = receivedRunStates.airflow_control;
-            this->airflow_control_select_->publish_state(receivedRunStates.airflow_control);
+            this->airflow_control_select_->publish_state(AIRFLOW_CONTROL_MAP[receivedRunStates.airflow_control]);
         }
     }
 
     // --- AIRFLOW CONTROL END
 
+    bool wideVaneDecoded = receivedSettings.wideVane != SETTING_UNSET;
+    bool airflowDecoded = receivedRunStates.airflow_control != SETTING_UNSET;
+    this->updateSnapshot([&](StateSnapshot& state, uint32_t now) {
+        state.settings.power = receivedSettings.power;
+        state.settings.mode = receivedSettings.mode;
+        state.settings.temperature = receivedSettings.temperature;
+        state.settings.fan = receivedSettings.fan;
+        state.settings.vane = receivedSettings.vane;
+        state.settings.iSee = receivedSettings.iSee;
+        state.settings.connected = true;
+        state.touch(SNAPSHOT_POWER, now);
+        state.touch(SNAPSHOT_MODE, now);
+        state.touch(SNAPSHOT_TARGET_TEMPERATURE, now);
+        state.touch(SNAPSHOT_FAN, now);
+        state.touch(SNAPSHOT_VANE, now);
+        state.touch(SNAPSHOT_ISEE, now);
+        if (wideVaneDecoded) {
+            state.settings.wideVane = receivedSettings.wideVane;
+            state.touch(SNAPSHOT_WIDEVANE, now);
+        }
+        if (airflowDecoded) {
+            state.runStates.airflow_control = receivedRunStates.airflow_control;
+            state.touch(SNAPSHOT_AIRFLOW_CONTROL, now);
+        }
+    });
+
     this->heatpumpUpdate(receivedSettings);
+    this->checkApplyWaiters(receivedSettings);
 }
 
 void CN105Climate::getRoomTemperatureFromResponsePacket() {
@@ -281,31 +337,37 @@ void CN105Climate::getRoomTemperatureFromResponsePacket() {
     // RM = indoor unit operating time in minutes
 
     if (data[5] > 1) {
-        receivedStatus.outsideAirTemperature = (data[5] - 128) / 2.0f;
+        receivedStatus.outsideAirTemperature = HalfDegrees::from_half_byte(data[5]);
     } else {
-        receivedStatus.outsideAirTemperature = NAN;
+        receivedStatus.outsideAirTemperature = HalfDegrees();
     }
 
     if (data[6] != 0x00) {
-        int temp = data[6];
-        temp -= 128;
-        receivedStatus.roomTemperature = temp / 2.0f;
-        ESP_LOGD(LOG_TEMP_SENSOR_TAG, "data[6]  --> [Room °C: %f]", receivedStatus.roomTemperature);
+        receivedStatus.roomTemperature = HalfDegrees::from_half_byte(data[6]);
+        ESP_LOGD(LOG_TEMP_SENSOR_TAG, "data[6]  --> [Room °C: %.1f]", receivedStatus.roomTemperature.celsius());
     } else {
-        receivedStatus.roomTemperature = lookupByteMapValue(ROOM_TEMP_MAP, ROOM_TEMP, 32, data[3]);
-        ESP_LOGD(LOG_TEMP_SENSOR_TAG, "data[3] map --> [Room °C : %f]", receivedStatus.roomTemperature);
+        receivedStatus.roomTemperature = temperature_codec::decode_room_code(data[3]);
+        ESP_LOGD(LOG_TEMP_SENSOR_TAG, "data[3] map --> [Room °C : %.1f]", receivedStatus.roomTemperature.celsius());
     }
 
     receivedStatus.runtimeHours = float((data[11] << 16) | (data[12] << 8) | data[13]) / 60;
 
-    ESP_LOGD("Decoder", "[Room °C: %f]", receivedStatus.roomTemperature);
-    ESP_LOGD("Decoder", "[OAT  °C: %f]", receivedStatus.outsideAirTemperature);
+    ESP_LOGD("Decoder", "[Room °C: %.1f]", receivedStatus.roomTemperature.celsius());
+    ESP_LOGD("Decoder", "[OAT  °C: %.1f]", receivedStatus.outsideAirTemperature.celsius());
 
     // no change with this packet to currentStatus for operating and compressorFrequency
     receivedStatus.operating = currentStatus.operating;
     receivedStatus.compressorFrequency = currentStatus.compressorFrequency;
     receivedStatus.inputPower = currentStatus.inputPower;
     receivedStatus.kWh = currentStatus.kWh;
+    this->updateSnapshot([&](StateSnapshot& state, uint32_t now) {
+        state.status.roomTemperature = receivedStatus.roomTemperature;
+        state.status.outsideAirTemperature = receivedStatus.outsideAirTemperature;
+        state.status.runtimeHours = receivedStatus.runtimeHours;
+        state.touch(SNAPSHOT_ROOM_TEMPERATURE, now);
+        state.touch(SNAPSHOT_OUTSIDE_TEMPERATURE, now);
+        state.touch(SNAPSHOT_RUNTIME_HOURS, now);
+    });
     this->statusChanged(receivedStatus);
 }
 
@@ -336,7 +398,25 @@ void CN105Climate::getOperatingAndCompressorFreqFromResponsePacket() {
     receivedStatus.roomTemperature = currentStatus.roomTemperature;
     receivedStatus.outsideAirTemperature = currentStatus.outsideAirTemperature;
     receivedStatus.runtimeHours = currentStatus.runtimeHours;
+    this->updateSnapshot([&](StateSnapshot& state, uint32_t now) {
+        state.status.operating = receivedStatus.operating;
+        state.status.compressorFrequency = receivedStatus.compressorFrequency;
+        state.status.inputPower = receivedStatus.inputPower;
+        state.status.kWh = receivedStatus.kWh;
+        state.touch(SNAPSHOT_OPERATING, now);
+        state.touch(SNAPSHOT_COMPRESSOR_FREQUENCY, now);
+        state.touch(SNAPSHOT_INPUT_POWER, now);
+        state.touch(SNAPSHOT_KWH, now);
+    });
     this->statusChanged(receivedStatus);
+
+#ifdef USE_CN105_ENERGY
+    if (this->energy_ != nullptr) {
+        // raw counter: the integrator unwraps it past 6553.5 kWh
+        this->energy_->on_status(receivedStatus.inputPower, receivedStatus.compressorFrequency,
+            static_cast<uint16_t>((data[7] << 8) | data[8]), CUSTOM_MILLIS);
+    }
+#endif
 }
 
 void CN105Climate::getHVACOptionsFromResponsePacket() {
@@ -373,6 +453,29 @@ void CN105Climate::getHVACOptionsFromResponsePacket() {
             this->circulator_switch_->publish_state(receivedRunStates.circulator);
         }
     }
+
+    this->updateSnapshot([&](StateSnapshot& state, uint32_t now) {
+        if (this->air_purifier_switch_ != nullptr) {
+            state.runStates.air_purifier = receivedRunStates.air_purifier;
+            state.touch(SNAPSHOT_AIR_PURIFIER, now);
+        }
+        if (this->night_mode_switch_ != nullptr) {
+            state.runStates.night_mode = receivedRunStates.night_mode;
+            state.touch(SNAPSHOT_NIGHT_MODE, now);
+        }
+        if (this->circulator_switch_ != nullptr) {
+            state.runStates.circulator = receivedRunStates.circulator;
+            state.touch(SNAPSHOT_CIRCULATOR, now);
+        }
+    });
+}
+
+void CN105Climate::reportLinkError(const char* reason) {
+    this->linkStats_.linkErrors++;
+    if (!this->isHeatpumpConnected_) {
+        return;     // a dead link says nothing about pacing
+    }
+    this->pacing_.on_failure(reason);       // only counts right after a write (see PacingController::arm)
 }
 
 void CN105Climate::terminateCycle() {
@@ -384,12 +487,11 @@ void CN105Climate::terminateCycle() {
     }
 
     this->loopCycle.cycleEnded();
+    this->pacing_.on_success();             // the first cycle after a write's rest time, if one is armed
 
-    if (this->hp_uptime_connection_sensor_ != nullptr) {
-        // if the uptime connection sensor is configured
-        // we trigger  manual update at the end of a cycle.
-        this->hp_uptime_connection_sensor_->update();
-    }
+    // one climate publish for everything the cycle's replies changed
+    // (the uptime connection sensor publishes on its own update_interval)
+    this->flushClimateState();
 
     this->nbCompleteCycles_++;
 }
@@ -448,6 +550,7 @@ void CN105Climate::getDataFromResponsePacket() {
 
     default:
         ESP_LOGW("Decoder", "packet type [%02X] <-- unknown and unexpected", data[0]);
+        this->linkStats_.unknownPackets++;
         //this->last_received_packet_sensor->publish_state("0x62-> ?? : Data -> Unknown");
         break;
     }
@@ -456,8 +559,8 @@ void CN105Climate::getDataFromResponsePacket() {
 
 void CN105Climate::updateSuccess() {
     ESP_LOGD(LOG_ACK, "Last heatpump data update successful!");
-    // nothing can be done here because we have no mean to know wether it is an external temp ack
-    // or a wantedSettings update ack
+    // ACKs carry no id but come in order: the oldest pending write is the acknowledged one
+    this->writeTxns_.acknowledge();
 }
 
 void CN105Climate::processCommand() {
@@ -472,6 +575,7 @@ void CN105Climate::processCommand() {
         break;
     case 0x7a:
         ESP_LOGI(TAG, "--> Heatpump did reply: connection success! <--");
+        this->linkStats_.handshakes++;
         //this->isHeatpumpConnected_ = true;
         this->setHeatpumpConnected(true);
         // let's say that the last complete cycle was over now
@@ -480,94 +584,169 @@ void CN105Climate::processCommand() {
         this->currentRunStates.resetSettings();
         break;
     default:
+        this->linkStats_.unknownPackets++;
         break;
     }
 }
 
 
 void CN105Climate::statusChanged(heatpumpStatus status) {
-
-    if (status != currentStatus) {
+    // only the room temperature and the operating flag are part of the climate entity
+    uint8_t changes = status.changesFrom(this->currentStatus);
+    if (changes != 0) {
         this->debugStatus("received", status);
         this->debugStatus("current", currentStatus);
+    }
 
+    // the sensors below filter their own updates (PublishPolicy)
+    this->currentStatus.operating = status.operating;
+    this->currentStatus.compressorFrequency = status.compressorFrequency;
+    this->currentStatus.inputPower = status.inputPower;
+    this->currentStatus.kWh = status.kWh;
+    this->currentStatus.runtimeHours = status.runtimeHours;
+    this->currentStatus.roomTemperature = status.roomTemperature;
+    this->currentStatus.outsideAirTemperature = status.outsideAirTemperature;
 
-        this->currentStatus.operating = status.operating;
-        this->currentStatus.compressorFrequency = status.compressorFrequency;
-        this->currentStatus.inputPower = status.inputPower;
-        this->currentStatus.kWh = status.kWh;
-        this->currentStatus.runtimeHours = status.runtimeHours;
-        this->currentStatus.roomTemperature = status.roomTemperature;
-        this->currentStatus.outsideAirTemperature = status.outsideAirTemperature;
+    if (changes != 0) {
         this->setCurrentTemperature(this->currentStatus.roomTemperature);
-
         this->updateAction();       // update action info on HA climate component
-        this->publish_state();
-
-        if (this->compressor_frequency_sensor_ != nullptr) {
-            this->compressor_frequency_sensor_->publish_state(currentStatus.compressorFrequency);
-        }
+        this->markClimateDirty();
+    }
 
-        if (this->input_power_sensor_ != nullptr) {
-            this->input_power_sensor_->publish_state(currentStatus.inputPower);
-        }
+    // offered on every status frame, even unchanged: max_publish_interval needs it
+    this->publishStatusSensors();
 
-        if (this->kwh_sensor_ != nullptr) {
-            this->kwh_sensor_->publish_state(currentStatus.kWh);
-        }
+#ifdef USE_CN105_HISTORY
+    if (this->history_ != nullptr) {
+        this->history_->record_status(this->currentStatus.roomTemperature, this->currentStatus.outsideAirTemperature,
+            this->currentStatus.inputPower, this->currentStatus.compressorFrequency, CUSTOM_MILLIS);
+    }
+#endif
+}
 
-        if (this->runtime_hours_sensor_ != nullptr) {
-            this->runtime_hours_sensor_->publish_state(currentStatus.runtimeHours);
-        }
+void CN105Climate::publishStatusSensors() {
+    this->publishSensor(PUBLISHED_COMPRESSOR_FREQUENCY, this->compressor_frequency_sensor_, currentStatus.compressorFrequency);
+    this->publishSensor(PUBLISHED_INPUT_POWER, this->input_power_sensor_, currentStatus.inputPower);
+    this->publishSensor(PUBLISHED_KWH, this->kwh_sensor_, currentStatus.kWh);
+    this->publishSensor(PUBLISHED_RUNTIME_HOURS, this->runtime_hours_sensor_, currentStatus.runtimeHours);
+    this->publishSensor(PUBLISHED_OUTSIDE_TEMPERATURE, this->outside_air_temperature_sensor_,
+        this->fahrenheitSupport_.normalizeHeatpumpTemperatureToUiTemperature(currentStatus.outsideAirTemperature));
+}
 
-        if (this->outside_air_temperature_sensor_ != nullptr) {
-            this->outside_air_temperature_sensor_->publish_state(this->fahrenheitSupport_.normalizeHeatpumpTemperatureToUiTemperature(currentStatus.outsideAirTemperature));
-        }
-    } // else no change
+/**
+ * Each sensor goes out only when its PublishPolicy agrees: by default when its own value changed,
+ * with deadband / min_publish_interval / max_publish_interval from the YAML otherwise
+ */
+void CN105Climate::publishSensor(PublishedSensor which, sensor::Sensor* sensor, float value) {
+    if (sensor == nullptr) {
+        return;
+    }
+    if (this->publishPolicies_[which].offer(value, CUSTOM_MILLIS)) {
+        sensor->publish_state(value);
+    }
 }
 
 
 void CN105Climate::publishStateToHA(heatpumpSettings& settings) {
+    uint32_t now = CUSTOM_MILLIS;
 
-    if ((this->wantedSettings.mode == nullptr) && (this->wantedSettings.power == nullptr)) {        // to prevent overwriting a user demand
+    // a written field keeps its optimistic value until the readback confirms it (or its deadline rolls it back)
+    bool holdPower = this->confirmations_.hold(CONFIRM_POWER, settings.power, now);
+    bool holdMode = this->confirmations_.hold(CONFIRM_MODE, settings.mode, now);
+    if ((this->wantedSettings.mode == SETTING_UNSET) && (this->wantedSettings.power == SETTING_UNSET) && !holdPower && !holdMode) {        // to prevent overwriting a user demand
         checkPowerAndModeSettings(settings);
     }
 
     this->updateAction();       // update action info on HA climate component
 
-    if (this->wantedSettings.fan == nullptr) {  // to prevent overwriting a user demand
+    if ((this->wantedSettings.fan == SETTING_UNSET) && !this->confirmations_.hold(CONFIRM_FAN, settings.fan, now)) {  // to prevent overwriting a user demand
         checkFanSettings(settings);
     }
 
-    if (this->wantedSettings.vane == nullptr) { // to prevent overwriting a user demand
+    if ((this->wantedSettings.vane == SETTING_UNSET) && !this->confirmations_.hold(CONFIRM_VANE, settings.vane, now)) { // to prevent overwriting a user demand
         checkVaneSettings(settings);
     }
 
-    if (this->wantedSettings.wideVane == nullptr) { // to prevent overwriting a user demand
+    if ((this->wantedSettings.wideVane == SETTING_UNSET) && !this->confirmations_.hold(CONFIRM_WIDEVANE, settings.wideVane, now)) { // to prevent overwriting a user demand
         checkWideVaneSettings(settings);
     }
 
     // HA Temp
-    // Ignorer temporairement une consigne entrante si une consigne utilisateur est en cours
-    bool hasPendingUserTemp = (this->wantedSettings.temperature != -1.0f) && (this->wantedSettings.hasChanged) && (!this->wantedSettings.hasBeenSent);
-    uint32_t graceWindowMs = this->get_update_interval() + DEFER_SCHEDULE_UPDATE_LOOP_DELAY;
-    bool graceAfterSend = (this->wantedSettings.hasBeenSent) && ((CUSTOM_MILLIS - this->wantedSettings.lastChange) < graceWindowMs);
-    if (!hasPendingUserTemp && !graceAfterSend) {
-        if (this->wantedSettings.temperature == -1) { // to prevent overwriting a user demand
-            this->updateTargetTemperaturesFromSettings(settings.temperature);
-            this->currentSettings.temperature = settings.temperature;
-        }
+    // une consigne utilisateur pas encore envoyée ou pas encore relue n'est pas écrasée
+    bool holdTemp = this->confirmations_.hold_temperature(settings.temperature, now);
+    if (!this->wantedSettings.temperature.is_set() && !holdTemp) {
+        this->updateTargetTemperaturesFromSettings(settings.temperature);
+        this->currentSettings.temperature = settings.temperature;
     } else {
-        ESP_LOGD(LOG_SETTINGS_TAG, "Ignoring incoming setpoint due to pending user change or grace window");
+        ESP_LOGD(LOG_SETTINGS_TAG, "Ignoring incoming setpoint: user change pending or not confirmed yet");
     }
 
     this->currentSettings.iSee = settings.iSee;
 
     this->currentSettings.connected = true;
 
-    // publish to HA
+    // published to HA at the end of the cycle
+    this->markClimateDirty();
+}
+
+void CN105Climate::flushClimateState() {
+    if (this->climateDirty_) {
+        this->publishClimateNow();
+    }
+}
+
+void CN105Climate::publishClimateNow() {
+    this->climateDirty_ = false;
     this->publish_state();
+}
+
+/**
+ * Optimistic values that were not confirmed in time: HA goes back to what the heatpump reports
+ * fields is a mask of (1 << ConfirmField)
+ */
+void CN105Climate::rollbackUnconfirmedSettings(uint8_t fields) {
+    if (fields == 0) {
+        return;
+    }
+    // the check*Settings() helpers publish what differs from currentSettings: give them the shown (optimistic)
+    // value as "current" and the device value as "received", they restore currentSettings on the way
+    heatpumpSettings device = this->currentSettings;
+    bool powerOrMode = false;
+    if ((fields & (1 << CONFIRM_POWER)) && (device.power != SETTING_UNSET)) {
+        this->currentSettings.power = this->confirmations_.expected_value(CONFIRM_POWER);
+        powerOrMode = true;
+    }
+    if ((fields & (1 << CONFIRM_MODE)) && (device.mode != SETTING_UNSET)) {
+        this->currentSettings.mode = this->confirmations_.expected_value(CONFIRM_MODE);
+        powerOrMode = true;
+    }
+    if (powerOrMode) {
+        this->checkPowerAndModeSettings(device);
+        this->updateAction();
+    }
+    if ((fields & (1 << CONFIRM_FAN)) && (device.fan != SETTING_UNSET)) {
+        this->currentSettings.fan = this->confirmations_.expected_value(CONFIRM_FAN);
+        this->checkFanSettings(device);
+    }
+    if ((fields & (1 << CONFIRM_VANE)) && (device.vane != SETTING_UNSET)) {
+        this->currentSettings.vane = this->confirmations_.expected_value(CONFIRM_VANE);
+        this->checkVaneSettings(device);
+    }
+    if ((fields & (1 << CONFIRM_WIDEVANE)) && (device.wideVane != SETTING_UNSET)) {
+        this->currentSettings.wideVane = this->confirmations_.expected_value(CONFIRM_WIDEVANE);
+        this->checkWideVaneSettings(device);
+    }
+    if ((fields & (1 << CONFIRM_TEMPERATURE)) && device.temperature.is_set()) {
+        this->updateTargetTemperaturesFromSettings(device.temperature);
+    }
+    this->publishClimateNow();
+}
 
+void CN105Climate::checkConfirmationDeadlines() {
+    this->rollbackUnconfirmedSettings(this->confirmations_.expire(CUSTOM_MILLIS));
+    if (!this->applyWaiters_.empty()) {
+        this->failApplyWaiters(0);
+    }
 }
 
 
@@ -598,14 +777,14 @@ void CN105Climate::checkVaneSettings(heatpumpSettings& settings, bool updateCurr
             currentSettings.vane = settings.vane;
         }
 
-        if (strcmp(settings.vane, "SWING") == 0) {
-            if ((currentSettings.wideVane != nullptr) && (strcmp(currentSettings.wideVane, "SWING") == 0)) {
+        if (settings.vane == HP_VANE_SWING) {
+            if (currentSettings.wideVane == HP_WIDEVANE_SWING) {
                 this->swing_mode = climate::CLIMATE_SWING_BOTH;
             } else {
                 this->swing_mode = climate::CLIMATE_SWING_VERTICAL;
             }
         } else {
-            if ((currentSettings.wideVane != nullptr) && (strcmp(currentSettings.wideVane, "SWING") == 0)) {
+            if (currentSettings.wideVane == HP_WIDEVANE_SWING) {
                 this->swing_mode = climate::CLIMATE_SWING_HORIZONTAL;
             } else {
                 this->swing_mode = climate::CLIMATE_SWING_OFF;
@@ -621,8 +800,8 @@ void CN105Climate::checkVaneSettings(heatpumpSettings& settings, bool updateCurr
 void CN105Climate::checkWideVaneSettings(heatpumpSettings& settings, bool updateCurrentSettings) {
 
     /* ******** HANDLE MITSUBISHI VANE CHANGES ********
-     * VANE_MAP[7]        = {"AUTO", "1", "2", "3", "4", "5", "SWING"};
-     * WIDEVANE_MAP[8]   = { "<<", "<",  "|",  ">",  ">>", "<>", "SWING", "AIRFLOW CONTROL" }
+     * VaneSetting       = { AUTO, 1, 2, 3, 4, 5, SWING }
+     * WideVaneSetting   = { <<, <, |, >, >>, <>, SWING, AIRFLOW CONTROL }
      */
 
     if (this->hasChanged(currentSettings.wideVane, settings.wideVane, "wideVane")) {    // widevane setting change ?
@@ -634,14 +813,14 @@ void CN105Climate::checkWideVaneSettings(heatpumpSettings& settings, bool update
             currentSettings.wideVane = settings.wideVane;
         }
 
-        if (strcmp(settings.wideVane, "SWING") == 0) {
-            if ((currentSettings.vane != nullptr) && (strcmp(currentSettings.vane, "SWING") == 0)) {
+        if (settings.wideVane == HP_WIDEVANE_SWING) {
+            if (currentSettings.vane == HP_VANE_SWING) {
                 this->swing_mode = climate::CLIMATE_SWING_BOTH;
             } else {
                 this->swing_mode = climate::CLIMATE_SWING_HORIZONTAL;
             }
         } else {
-            if ((currentSettings.vane != nullptr) && (strcmp(currentSettings.vane, "SWING") == 0)) {
+            if (currentSettings.vane == HP_VANE_SWING) {
                 this->swing_mode = climate::CLIMATE_SWING_VERTICAL;
             } else {
                 this->swing_mode = climate::CLIMATE_SWING_OFF;
@@ -659,15 +838,17 @@ void CN105Climate::checkWideVaneSettings(heatpumpSettings& settings, bool update
 }
 void CN105Climate::updateExtraSelectComponents(heatpumpSettings& settings) {
     if (this->vertical_vane_select_ != nullptr) {
-        if (this->hasChanged(this->vertical_vane_select_->state.c_str(), settings.vane, "select vane")) {
+        const char* vane = settingLabel(VANE_MAP, settings.vane);
+        if (this->hasChanged(this->vertical_vane_select_->state.c_str(), vane, "select vane")) {
             ESP_LOGI(TAG, "vane setting (extra select component) changed");
-            this->vertical_vane_select_->publish_state(settings.vane);
+            this->vertical_vane_select_->publish_state(vane);
         }
     }
     if (this->horizontal_vane_select_ != nullptr) {
-        if (this->hasChanged(this->horizontal_vane_select_->state.c_str(), settings.wideVane, "select wideVane")) {
+        const char* wideVane = settingLabel(WIDEVANE_MAP, settings.wideVane);
+        if (this->hasChanged(this->horizontal_vane_select_->state.c_str(), wideVane, "select wideVane")) {
             ESP_LOGI(TAG, "widevane setting (extra select component) changed");
-            this->horizontal_vane_select_->publish_state(settings.wideVane);
+            this->horizontal_vane_select_->publish_state(wideVane);
         }
     }
 }
@@ -675,9 +856,9 @@ void CN105Climate::checkFanSettings(heatpumpSettings& settings, bool updateCurre
     /*
          * ******* HANDLE FAN CHANGES ********
          *
-         * const char* FAN_MAP[6]         = {"AUTO", "QUIET", "1", "2", "3", "4"};
+         * FanSetting = { AUTO, QUIET, 1, 2, 3, 4 }
          */
-         // currentSettings.fan== NULL is true when it is the first time we get en answer from hp
+         // currentSettings.fan == SETTING_UNSET is true when it is the first time we get en answer from hp
 
     if (this->hasChanged(currentSettings.fan, settings.fan, "fan")) { // fan setting change ?
         ESP_LOGI(TAG, "fan setting changed");
@@ -685,18 +866,26 @@ void CN105Climate::checkFanSettings(heatpumpSettings& settings, bool updateCurre
             currentSettings.fan = settings.fan;
         }
 
-        if (strcmp(settings.fan, "QUIET") == 0) {
+        switch (settings.fan) {
+        case HP_FAN_QUIET:
             this->fan_mode = climate::CLIMATE_FAN_QUIET;
-        } else if (strcmp(settings.fan, "1") == 0) {
+            break;
+        case HP_FAN_1:
             this->fan_mode = climate::CLIMATE_FAN_LOW;
-        } else if (strcmp(settings.fan, "2") == 0) {
+            break;
+        case HP_FAN_2:
             this->fan_mode = climate::CLIMATE_FAN_MEDIUM;
-        } else if (strcmp(settings.fan, "3") == 0) {
+            break;
+        case HP_FAN_3:
             this->fan_mode = climate::CLIMATE_FAN_MIDDLE;
-        } else if (strcmp(settings.fan, "4") == 0) {
+            break;
+        case HP_FAN_4:
             this->fan_mode = climate::CLIMATE_FAN_HIGH;
-        } else { //case "AUTO" or default:
+            break;
+        case HP_FAN_AUTO:
+        default:
             this->fan_mode = climate::CLIMATE_FAN_AUTO;
+            break;
         }
         if (this->fan_mode.has_value()) {
             ESP_LOGD(TAG, "Fan mode is: %i", static_cast<int>(this->fan_mode.value()));
@@ -708,7 +897,7 @@ void CN105Climate::checkFanSettings(heatpumpSettings& settings, bool updateCurre
 
 
 void CN105Climate::checkPowerAndModeSettings(heatpumpSettings& settings, bool updateCurrentSettings) {
-    // currentSettings.power== NULL is true when it is the first time we get en answer from hp
+    // currentSettings.power == SETTING_UNSET is true when it is the first time we get en answer from hp
     if (this->hasChanged(currentSettings.power, settings.power, "power") ||
         this->hasChanged(currentSettings.mode, settings.mode, "mode")) {           // mode or power change ?
 
@@ -717,27 +906,30 @@ void CN105Climate::checkPowerAndModeSettings(heatpumpSettings& settings, bool up
             currentSettings.power = settings.power;
             currentSettings.mode = settings.mode;
         }
-        if (strcmp(settings.power, "ON") == 0) {
-            if (strcmp(settings.mode, "HEAT") == 0) {
+        if (settings.power == HP_POWER_ON) {
+            switch (settings.mode) {
+            case HP_MODE_HEAT:
                 this->mode = climate::CLIMATE_MODE_HEAT;
-            } else if (strcmp(settings.mode, "DRY") == 0) {
+                break;
+            case HP_MODE_DRY:
                 this->mode = climate::CLIMATE_MODE_DRY;
-            } else if (strcmp(settings.mode, "COOL") == 0) {
+                break;
+            case HP_MODE_COOL:
                 this->mode = climate::CLIMATE_MODE_COOL;
-                /*if (cool_setpoint != currentSettings.temperature) {
-                    cool_setpoint = currentSettings.temperature;
-                    save(currentSettings.temperature, cool_storage);
-                }*/
-            } else if (strcmp(settings.mode, "FAN") == 0) {
+                break;
+            case HP_MODE_FAN:
                 this->mode = climate::CLIMATE_MODE_FAN_ONLY;
-            } else if (strcmp(settings.mode, "AUTO") == 0) {
+                break;
+            case HP_MODE_AUTO:
                 this->mode = climate::CLIMATE_MODE_AUTO;
-            } else {
+                break;
+            default:
                 ESP_LOGW(
                     TAG,
-                    "Unknown climate mode value %s received from HeatPump",
+                    "Unknown climate mode value %d received from HeatPump",
                     settings.mode
                 );
+                break;
             }
         } else {
             this->mode = climate::CLIMATE_MODE_OFF;
@@ -2,16 +2,12 @@
 
 using namespace esphome;
 
-uint8_t CN105Climate::checkSum(uint8_t bytes[], int len) {
-    uint8_t sum = 0;
-    for (int i = 0; i < len; i++) {
-        sum += bytes[i];
-    }
-    return (0xfc - sum) & 0xff;
-}
-
-
 void CN105Climate::sendFirstConnectionPacket() {
+    if (this->isUARTConnected_ && !this->canTransmit(CONNECT_LEN)) {
+        // never queued: retried here once the FIFO has drained
+        this->set_timeout("connect_retry", this->getTxRemainingMs() + 1, [this]() { this->sendFirstConnectionPacket(); });
+        return;
+    }
     if (this->isUARTConnected_) {
         this->lastReconnectTimeMs = CUSTOM_MILLIS;          // marker to prevent to many reconnections
         this->setHeatpumpConnected(false);
@@ -22,7 +18,6 @@ void CN105Climate::sendFirstConnectionPacket() {
 
         this->writePacket(packet, CONNECT_LEN, false);      // checkIsActive=false because it's the first packet and we don't have any reply yet
 
-        this->lastSend = CUSTOM_MILLIS;
         this->lastConnectRqTimeMs = CUSTOM_MILLIS;
         this->nbHeatpumpConnections_++;
 
@@ -57,94 +52,159 @@ void CN105Climate::sendFirstConnectionPacket() {
 //     this->publish_state();
 // }
 
-void CN105Climate::prepareInfoPacket(uint8_t* packet, int length) {
-    ESP_LOGV(TAG, "preparing info packet...");
+/**
+ * Only 0x41 set frames are queued when they cannot go out now: drainTxQueue() sends them between cycles.
+ * Info polls and the connect frame are time-bound to their caller (scheduler timeout, handshake check),
+ * so they are retried at their call site instead.
+ */
+bool CN105Climate::writePacket(uint8_t* packet, int length, bool checkIsActive) {
+    bool isSetFrame = length > 5 && packet[1] == 0x41;
 
-    memset(packet, 0, length * sizeof(uint8_t));
+    if ((this->isUARTConnected_) &&
+        (this->isHeatpumpConnectionActive() || (!checkIsActive))) {
 
-    for (int i = 0; i < INFOHEADER_LEN && i < length; i++) {
-        packet[i] = INFOHEADER[i];
-    }
-}
+        if (!this->canTransmit(length)) {
+            // never wait for room in the FIFO from the main loop
+            if (isSetFrame) {
+                ESP_LOGD(TAG, "TX FIFO busy, queueing packet");
+                return this->txQueue_.push(packet, length);
+            }
+            ESP_LOGW(TAG, "TX FIFO busy, packet 0x%02X not sent", packet[1]);
+            return false;
+        }
+
+        ESP_LOGD(TAG, "writing packet...");
+        this->hpPacketDebug(packet, length, "WRITE");
+
+        uint32_t txDone = this->transmit(packet, length);
 
-void CN105Climate::prepareSetPacket(uint8_t* packet, int length) {
-    ESP_LOGV(TAG, "preparing Set packet...");
-    memset(packet, 0, length * sizeof(uint8_t));
+        if (WriteTransactions::is_transactional(packet, length)) {
+            this->writeTxns_.track(packet, length, txDone);     // the unit will answer with a 0x61 ACK
+        }
+        return true;
 
-    for (int i = 0; i < HEADER_LEN && i < length; i++) {
-        packet[i] = HEADER[i];
     }
+    ESP_LOGW(TAG, "could not write as asked, because UART is not connected");
+    this->reconnectUART();
+    if (checkIsActive && isSetFrame) {
+        // the connection packet is resent by the reconnection itself, polls restart with the next cycle
+        ESP_LOGW(TAG, "delaying packet writing because we need to reconnect first...");
+        return this->txQueue_.push(packet, length);
+    }
+    return false;
 }
 
-void CN105Climate::writePacket(uint8_t* packet, int length, bool checkIsActive) {
+/**
+ * Hands a whole frame to the UART at once and computes when its last byte will have left the FIFO.
+ * lastSend is that instant: pacing, RTT and timeouts count from the real end of transmission.
+ */
+uint32_t CN105Climate::transmit(uint8_t* packet, int length) {
+    this->get_hw_serial_()->write_array(packet, static_cast<size_t>(length));
+    this->linkStats_.txBytes += length;
+
+    uint32_t now = CUSTOM_MILLIS;
+    uint32_t start = (this->getTxRemainingMs() > 0) ? this->txDoneMs_ : now;     // behind bytes still in the FIFO
+    this->txDoneMs_ = start + (static_cast<uint32_t>(length) * this->txByteTimeUs_ + 999) / 1000;
+    if (this->txDoneMs_ == 0) this->txDoneMs_ = 1;     // 0 means "not written" for the transaction layer
+
+    // Prevent sending wantedSettings too soon after writing for example the remote temperature update packet
+    this->lastSend = this->txDoneMs_;
+    return this->txDoneMs_;
+}
 
-    if ((this->isUARTConnected_) &&
-        (this->isHeatpumpConnectionActive() || (!checkIsActive))) {
+uint32_t CN105Climate::getTxRemainingMs() const {
+    int32_t remaining = static_cast<int32_t>(this->txDoneMs_ - CUSTOM_MILLIS);
+    return remaining > 0 ? static_cast<uint32_t>(remaining) : 0;
+}
 
-        ESP_LOGD(TAG, "writing packet...");
-        this->hpPacketDebug(packet, length, "WRITE");
+bool CN105Climate::canTransmit(int length) const {
+    uint32_t pendingBytes = (this->getTxRemainingMs() * 1000 + this->txByteTimeUs_ - 1) / this->txByteTimeUs_;
+    return static_cast<int>(pendingBytes) + length <= TX_FIFO_BUDGET_BYTES;
+}
 
-        for (int i = 0; i < length; i++) {
-            this->get_hw_serial_()->write_byte((uint8_t)packet[i]);
-        }
+/**
+ * Queues a packet for the next bus window. A newer packet of the same type replaces (and merges into)
+ * an unsent older one, so a burst of automations does not pile up writes.
+ * Returns false when the queue rejected it: the caller must not wait for its effect.
+ */
+bool CN105Climate::enqueuePacket(uint8_t* packet, int length) {
+    return this->txQueue_.push(packet, length);
+}
 
-        // Prevent sending wantedSettings too soon after writing for example the remote temperature update packet
-        this->lastSend = CUSTOM_MILLIS;
+/**
+ * Sends every queued packet back-to-back, highest priority first, then gives the unit a single rest period.
+ * Called between cycles only: a cycle never starts while writes are queued.
+ */
+void CN105Climate::drainTxQueue() {
+    if (!this->isUARTConnected_ || !this->isHeatpumpConnected_ || !this->isHeatpumpConnectionActive()) {
+        this->reconnectIfConnectionLost();
+        return;
+    }
+    if (!this->txBurstOpen_ &&
+        (this->getTxRemainingMs() > 0 || CUSTOM_MILLIS - this->lastSend <= this->pacing_.get_write_gap())) {
+        return;                 // we don't want to send too many packets
+    }
 
-    } else {
-        ESP_LOGW(TAG, "could not write as asked, because UART is not connected");
-        this->reconnectUART();
-        ESP_LOGW(TAG, "delaying packet writing because we need to reconnect first...");
-        if (length > PACKET_LEN) {
-            ESP_LOGE(TAG, "Packet length %d exceeds PACKET_LEN %d, dropping.", length, PACKET_LEN);
-            return;
+    // back-to-back, as long as the FIFO has room; the rest goes out in the next loops
+    bool wroteSettings = false;
+    const TxQueue::Entry* next;
+    while ((next = this->txQueue_.front()) != nullptr && this->canTransmit(next->length)) {
+        TxQueue::Entry entry;
+        this->txQueue_.pop(entry);
+        if (!this->writePacket(entry.packet, entry.length)) {
+            ESP_LOGW(TAG, "queued packet 0x%02X/0x%02X could not be written, dropped", entry.packet[1], entry.packet[5]);
+            continue;
         }
-        memcpy(this->pending_packet_, packet, static_cast<size_t>(length));
-        this->pending_packet_len_ = length;
-        this->pending_check_is_active_ = checkIsActive;
-        this->has_pending_packet_ = true;
-        this->set_timeout("write", 4000, [this]() { this->try_write_pending_packet(); });
+        wroteSettings |= (entry.priority != TX_PRIORITY_INFO);
+    }
+    this->txBurstOpen_ = !this->txQueue_.empty();
+
+    if (wroteSettings) {
+        // as we've just sent packets to the heatpump, we let it time for process
+        // this might not be necessary but, we give it a try because of issue #32
+        // https://github.com/echavet/MitsubishiCN105ESPHome/issues/32
+        this->loopCycle.deferCycle(this->pacing_.get_rest_time() + this->getTxRemainingMs());
+        this->pacing_.arm();
     }
 }
 
-void CN105Climate::try_write_pending_packet() {
-    if (!this->has_pending_packet_) return;
-    if (!this->isUARTConnected_) {
-        this->reconnectUART();
-        this->set_timeout("write", 2000, [this]() { this->try_write_pending_packet(); });
-        return;
+// retry of an unacknowledged write: same bytes, not tracked again. Returns the end of transmission, 0 if not written
+uint32_t CN105Climate::resendPacket(uint8_t* packet, int length) {
+    if (!this->isUARTConnected_ || !this->isHeatpumpConnectionActive() || !this->canTransmit(length)) {
+        return 0;
     }
-    this->writePacket(this->pending_packet_, this->pending_packet_len_, this->pending_check_is_active_);
-    this->has_pending_packet_ = false;
+    this->hpPacketDebug(packet, length, "WRITE_RETRY");
+    return this->transmit(packet, length);
 }
 
-const char* CN105Climate::getModeSetting() {
-    if (this->wantedSettings.mode) {
+
+uint8_t CN105Climate::getModeSetting() {
+    if (this->wantedSettings.mode != SETTING_UNSET) {
         return this->wantedSettings.mode;
     } else {
         return this->currentSettings.mode;
     }
 }
 
-const char* CN105Climate::getPowerSetting() {
-    if (this->wantedSettings.power) {
+uint8_t CN105Climate::getPowerSetting() {
+    if (this->wantedSettings.power != SETTING_UNSET) {
         return this->wantedSettings.power;
     } else {
         return this->currentSettings.power;
     }
 }
 
-const char* CN105Climate::getVaneSetting() {
-    if (this->wantedSettings.vane) {
+uint8_t CN105Climate::getVaneSetting() {
+    if (this->wantedSettings.vane != SETTING_UNSET) {
         return this->wantedSettings.vane;
     } else {
         return this->currentSettings.vane;
     }
 }
 
-const char* CN105Climate::getWideVaneSetting() {
-    if (this->wantedSettings.wideVane) {
-        if (strcmp(this->wantedSettings.wideVane, lookupByteMapValue(WIDEVANE_MAP, WIDEVANE, 8, 0x80 & 0x0F)) == 0 && !this->currentSettings.iSee) {
+uint8_t CN105Climate::getWideVaneSetting() {
+    if (this->wantedSettings.wideVane != SETTING_UNSET) {
+        if ((this->wantedSettings.wideVane == HP_WIDEVANE_AIRFLOW_CONTROL) && !this->currentSettings.iSee) {
             this->wantedSettings.wideVane = this->currentSettings.wideVane;
         }
         return this->wantedSettings.wideVane;
@@ -153,23 +213,23 @@ const char* CN105Climate::getWideVaneSetting() {
     }
 }
 
-const char* CN105Climate::getFanSpeedSetting() {
-    if (this->wantedSettings.fan) {
+uint8_t CN105Climate::getFanSpeedSetting() {
+    if (this->wantedSettings.fan != SETTING_UNSET) {
         return this->wantedSettings.fan;
     } else {
         return this->currentSettings.fan;
     }
 }
 
-float CN105Climate::getTemperatureSetting() {
-    if (this->wantedSettings.temperature != -1.0) {
+HalfDegrees CN105Climate::getTemperatureSetting() {
+    if (this->wantedSettings.temperature.is_set()) {
         return this->wantedSettings.temperature;
     } else {
         return this->currentSettings.temperature;
     }
 }
-const char* CN105Climate::getAirflowControlSetting() {
-    if (this->wantedRunStates.airflow_control) {
+uint8_t CN105Climate::getAirflowControlSetting() {
+    if (this->wantedRunStates.airflow_control != SETTING_UNSET) {
         return this->wantedRunStates.airflow_control;
     } else {
         return this->currentRunStates.airflow_control;
@@ -198,84 +258,151 @@ bool CN105Climate::getCirculatorRunState() {
 }
 
 
-void CN105Climate::createPacket(uint8_t* packet) {
-    prepareSetPacket(packet, PACKET_LEN);
+// a wanted field is only written if it differs from the last state confirmed by the heatpump
+static bool settingDiffers(uint8_t wanted, uint8_t current) {
+    return (current == SETTING_UNSET) || (wanted != current);
+}
+
+/**
+ * Clears the wanted settings that equal currentSettings.
+ * UIs often resend the whole state: re-applying an unchanged mode, fan or vane makes some units beep
+ * and re-home their vanes, so unchanged fields are not written.
+ */
+void CN105Climate::dropUnchangedWantedSettings() {
+    ESP_LOGD(TAG, "checking differences bw asked settings and current ones...");
+    // a field with a write still awaiting its readback is always written: the unit may not hold currentSettings any more
+
+    if ((this->wantedSettings.power != SETTING_UNSET) && !this->confirmations_.is_pending(CONFIRM_POWER) &&
+        !settingDiffers(this->wantedSettings.power, this->currentSettings.power)) {
+        ESP_LOGV(TAG, "power unchanged (%s), not written", POWER_MAP[this->wantedSettings.power]);
+        this->wantedSettings.power = SETTING_UNSET;
+    }
+    if ((this->wantedSettings.mode != SETTING_UNSET) && !this->confirmations_.is_pending(CONFIRM_MODE) &&
+        !settingDiffers(this->wantedSettings.mode, this->currentSettings.mode)) {
+        ESP_LOGV(TAG, "mode unchanged (%s), not written", MODE_MAP[this->wantedSettings.mode]);
+        this->wantedSettings.mode = SETTING_UNSET;
+    }
+    if (this->wantedSettings.temperature.is_set() && !this->confirmations_.is_pending(CONFIRM_TEMPERATURE) &&
+        (this->wantedSettings.temperature == this->currentSettings.temperature)) {
+        ESP_LOGV(TAG, "temperature unchanged (%.1f), not written", this->wantedSettings.temperature.celsius());
+        this->wantedSettings.temperature = HalfDegrees();
+    }
+    if ((this->wantedSettings.fan != SETTING_UNSET) && !this->confirmations_.is_pending(CONFIRM_FAN) &&
+        !settingDiffers(this->wantedSettings.fan, this->currentSettings.fan)) {
+        ESP_LOGV(TAG, "fan unchanged (%s), not written", FAN_MAP[this->wantedSettings.fan]);
+        this->wantedSettings.fan = SETTING_UNSET;
+    }
+    if ((this->wantedSettings.vane != SETTING_UNSET) && !this->confirmations_.is_pending(CONFIRM_VANE) &&
+        !settingDiffers(this->wantedSettings.vane, this->currentSettings.vane)) {
+        ESP_LOGV(TAG, "vane unchanged (%s), not written", VANE_MAP[this->wantedSettings.vane]);
+        this->wantedSettings.vane = SETTING_UNSET;
+    }
+    if ((this->wantedSettings.wideVane != SETTING_UNSET) && !this->confirmations_.is_pending(CONFIRM_WIDEVANE) &&
+        !settingDiffers(this->wantedSettings.wideVane, this->currentSettings.wideVane)) {
+        ESP_LOGV(TAG, "wideVane unchanged (%s), not written", WIDEVANE_MAP[this->wantedSettings.wideVane]);
+        this->wantedSettings.wideVane = SETTING_UNSET;
+    }
+}
+
+/**
+ * Encodes every wanted setting that is set.
+ * @return false if none is (no write needed)
+ */
+bool CN105Climate::createPacket(uint8_t* packet) {
+    PacketEncoder encoder(packet, MSG_SET_SETTINGS);
 
-    //ESP_LOGD(TAG, "checking differences bw asked settings and current ones...");
     ESP_LOGD(TAG, "building packet for writing...");
 
-    if (this->wantedSettings.power != nullptr) {
-        ESP_LOGD(TAG, "power -> %s", getPowerSetting());
-        int idx = lookupByteMapIndex(POWER_MAP, 2, getPowerSetting(), "power (write)");
-        if (idx >= 0) { packet[8] = POWER[idx]; packet[6] += CONTROL_PACKET_1[0]; } else { ESP_LOGW(TAG, "Ignoring invalid power setting while building packet"); }
+    if (this->wantedSettings.power != SETTING_UNSET) {
+        uint8_t idx = getPowerSetting();
+        ESP_LOGD(TAG, "power -> %s", settingLabel(POWER_MAP, idx, "?"));
+        if (idx < sizeof(POWER)) { encoder.set(FIELD_POWER, POWER[idx]); } else { ESP_LOGW(TAG, "Ignoring invalid power setting while building packet"); }
     }
 
-    if (this->wantedSettings.mode != nullptr) {
-        ESP_LOGD(TAG, "heatpump mode -> %s", getModeSetting());
-        int idx = lookupByteMapIndex(MODE_MAP, 5, getModeSetting(), "mode (write)");
-        if (idx >= 0) { packet[9] = MODE[idx]; packet[6] += CONTROL_PACKET_1[1]; } else { ESP_LOGW(TAG, "Ignoring invalid mode setting while building packet"); }
+    if (this->wantedSettings.mode != SETTING_UNSET) {
+        uint8_t idx = getModeSetting();
+        ESP_LOGD(TAG, "heatpump mode -> %s", settingLabel(MODE_MAP, idx, "?"));
+        if (idx < sizeof(MODE)) { encoder.set(FIELD_MODE, MODE[idx]); } else { ESP_LOGW(TAG, "Ignoring invalid mode setting while building packet"); }
     }
 
-    if (wantedSettings.temperature != -1) {
+    if (wantedSettings.temperature.is_set()) {
         if (!tempMode) {
-            ESP_LOGD(TAG, "temperature (tempmode is false) -> %f", getTemperatureSetting());
-            int idx = lookupByteMapIndex(TEMP_MAP, 16, getTemperatureSetting(), "temperature (write)");
-            if (idx >= 0) { packet[10] = TEMP[idx]; packet[6] += CONTROL_PACKET_1[2]; } else { ESP_LOGW(TAG, "Ignoring invalid temperature setting while building packet"); }
+            ESP_LOGD(TAG, "temperature (tempmode is false) -> %.1f", getTemperatureSetting().celsius());
+            uint8_t code = temperature_codec::encode_setpoint_code(getTemperatureSetting());
+            if (code != 0xFF) { encoder.set(FIELD_TEMPERATURE, code); } else { ESP_LOGW(TAG, "Ignoring invalid temperature setting while building packet"); }
         } else {
-            ESP_LOGD(TAG, "temperature (tempmode is true) -> %f", getTemperatureSetting());
-            float temp = (getTemperatureSetting() * 2) + 128;
-            packet[19] = (int)temp;
-            packet[6] += CONTROL_PACKET_1[2];
+            ESP_LOGD(TAG, "temperature (tempmode is true) -> %.1f", getTemperatureSetting().celsius());
+            encoder.set(FIELD_TEMPERATURE_HALF, getTemperatureSetting().half_byte());
         }
     }
 
-    if (this->wantedSettings.fan != nullptr) {
-        ESP_LOGD(TAG, "heatpump fan -> %s", getFanSpeedSetting());
-        int idx = lookupByteMapIndex(FAN_MAP, 6, getFanSpeedSetting(), "fan (write)");
-        if (idx >= 0) { packet[11] = FAN[idx]; packet[6] += CONTROL_PACKET_1[3]; } else { ESP_LOGW(TAG, "Ignoring invalid fan setting while building packet"); }
+    if (this->wantedSettings.fan != SETTING_UNSET) {
+        uint8_t idx = getFanSpeedSetting();
+        ESP_LOGD(TAG, "heatpump fan -> %s", settingLabel(FAN_MAP, idx, "?"));
+        if (idx < sizeof(FAN)) { encoder.set(FIELD_FAN, FAN[idx]); } else { ESP_LOGW(TAG, "Ignoring invalid fan setting while building packet"); }
     }
 
-    if (this->wantedSettings.vane != nullptr) {
-        ESP_LOGD(TAG, "heatpump vane -> %s", getVaneSetting());
-        int idx = lookupByteMapIndex(VANE_MAP, 7, getVaneSetting(), "vane (write)");
-        if (idx >= 0) { packet[12] = VANE[idx]; packet[6] += CONTROL_PACKET_1[4]; } else { ESP_LOGW(TAG, "Ignoring invalid vane setting while building packet"); }
+    if (this->wantedSettings.vane != SETTING_UNSET) {
+        uint8_t idx = getVaneSetting();
+        ESP_LOGD(TAG, "heatpump vane -> %s", settingLabel(VANE_MAP, idx, "?"));
+        if (idx < sizeof(VANE)) { encoder.set(FIELD_VANE, VANE[idx]); } else { ESP_LOGW(TAG, "Ignoring invalid vane setting while building packet"); }
     }
 
-    if (this->wantedSettings.wideVane != nullptr) {
-        ESP_LOGD(TAG, "heatpump widevane -> %s", getWideVaneSetting());
-        int idx = lookupByteMapIndex(WIDEVANE_MAP, 8, getWideVaneSetting(), "wideVane (write)");
-        if (idx >= 0) { packet[18] = WIDEVANE[idx] | (this->wideVaneAdj ? 0x80 : 0x00); packet[7] += CONTROL_PACKET_2[0]; } else { ESP_LOGW(TAG, "Ignoring invalid wideVane setting while building packet"); }
+    if (this->wantedSettings.wideVane != SETTING_UNSET) {
+        uint8_t idx = getWideVaneSetting();
+        ESP_LOGD(TAG, "heatpump widevane -> %s", settingLabel(WIDEVANE_MAP, idx, "?"));
+        if (idx < sizeof(WIDEVANE)) { encoder.set(FIELD_WIDEVANE, WIDEVANE[idx] | (this->wideVaneAdj ? 0x80 : 0x00)); } else { ESP_LOGW(TAG, "Ignoring invalid wideVane setting while building packet"); }
     }
-
-
-    // add the checksum
-    uint8_t chkSum = checkSum(packet, 21);
-    packet[21] = chkSum;
-    //ESP_LOGD(TAG, "debug before write packet:");
-    //this->hpPacketDebug(packet, 22, "WRITE");
+    // the checksum is kept up to date by the encoder
+    return (packet[FIELD_POWER.flag_byte] != 0) || (packet[FIELD_WIDEVANE.flag_byte] != 0);
 }
 
 
 
-
+/**
+ * Every field of the queued write is published right away and awaits its readback
+ * The deadline never goes below one read cycle, the tracker stretches it to the measured latency
+*/
+void CN105Climate::expectSettingsConfirmation() {
+    uint32_t now = CUSTOM_MILLIS;
+    uint32_t floorMs = this->getEffectiveUpdateInterval() + this->pacing_.get_rest_time() + CONFIRM_MARGIN_MS;
+    if (this->wantedSettings.power != SETTING_UNSET) {
+        this->confirmations_.expect(CONFIRM_POWER, this->wantedSettings.power, now, floorMs);
+    }
+    if (this->wantedSettings.mode != SETTING_UNSET) {
+        this->confirmations_.expect(CONFIRM_MODE, this->wantedSettings.mode, now, floorMs);
+    }
+    if (this->wantedSettings.temperature.is_set()) {
+        this->confirmations_.expect_temperature(this->wantedSettings.temperature, now, floorMs);
+    }
+    if (this->wantedSettings.fan != SETTING_UNSET) {
+        this->confirmations_.expect(CONFIRM_FAN, this->wantedSettings.fan, now, floorMs);
+    }
+    if (this->wantedSettings.vane != SETTING_UNSET) {
+        this->confirmations_.expect(CONFIRM_VANE, this->wantedSettings.vane, now, floorMs);
+    }
+    if (this->wantedSettings.wideVane != SETTING_UNSET) {
+        this->confirmations_.expect(CONFIRM_WIDEVANE, this->wantedSettings.wideVane, now, floorMs);
+    }
+}
 
 void CN105Climate::publishWantedSettingsStateToHA() {
 
-    if ((this->wantedSettings.mode != nullptr) || (this->wantedSettings.power != nullptr)) {
+    if ((this->wantedSettings.mode != SETTING_UNSET) || (this->wantedSettings.power != SETTING_UNSET)) {
         checkPowerAndModeSettings(this->wantedSettings, false);
         this->updateAction();       // update action info on HA climate component
     }
 
-    if (this->wantedSettings.fan != nullptr) {
+    if (this->wantedSettings.fan != SETTING_UNSET) {
         checkFanSettings(this->wantedSettings, false);
     }
 
 
-    if ((this->wantedSettings.vane != nullptr) || (this->wantedSettings.wideVane != nullptr)) {
-        if (this->wantedSettings.vane == nullptr) { // to prevent a nullpointer error
+    if ((this->wantedSettings.vane != SETTING_UNSET) || (this->wantedSettings.wideVane != SETTING_UNSET)) {
+        if (this->wantedSettings.vane == SETTING_UNSET) { // the swing mode needs both vanes
             this->wantedSettings.vane = this->currentSettings.vane;
         }
-        if (this->wantedSettings.wideVane == nullptr) { // to prevent a nullpointer error
+        if (this->wantedSettings.wideVane == SETTING_UNSET) { // the swing mode needs both vanes
             this->wantedSettings.wideVane = this->currentSettings.wideVane;
         }
 
@@ -286,18 +413,16 @@ void CN105Climate::publishWantedSettingsStateToHA() {
     this->updateTargetTemperaturesFromSettings(this->getTemperatureSetting());
 
     // publish to HA
-    this->publish_state();
+    this->publishClimateNow();
 
 }
 
 void CN105Climate::publishWantedRunStatesStateToHA() {
-    if (this->wantedRunStates.airflow_control != nullptr) {
-        if (this->wantedRunStates.airflow_control == nullptr) {
-            this->wantedRunStates.airflow_control = this->currentRunStates.airflow_control;
-        }
-        if (this->hasChanged(this->airflow_control_select_->state.c_str(), this->wantedRunStates.airflow_control, "select airflow control")) {
+    if (this->wantedRunStates.airflow_control != SETTING_UNSET) {
+        const char* airflowControl = settingLabel(AIRFLOW_CONTROL_MAP, this->wantedRunStates.airflow_control);
+        if (this->hasChanged(this->airflow_control_select_->state.c_str(), airflowControl, "select airflow control")) {
             ESP_LOGI(TAG, "airflow control setting changed");
-            this->airflow_control_select_->publish_state(wantedRunStates.airflow_control);
+            this->airflow_control_select_->publish_state(airflowControl);
         }
     }
     if (this->wantedRunStates.air_purifier > -1) {
@@ -332,24 +457,29 @@ void CN105Climate::publishWantedRunStatesStateToHA() {
 
 void CN105Climate::sendWantedSettingsDelegate() {
     this->wantedSettings.hasBeenSent = true;
-    this->lastSend = CUSTOM_MILLIS;
     ESP_LOGI(TAG, "sending wantedSettings..");
     this->debugSettings("wantedSettings", wantedSettings);
-    // and then we send the update packet
+    // and then we queue the update packet, it leaves with the next bus window
     uint8_t packet[PACKET_LEN] = {};
-    this->createPacket(packet);
-    this->writePacket(packet, PACKET_LEN);
-    this->hpPacketDebug(packet, 22, "WRITE_SETTINGS");
+    this->dropUnchangedWantedSettings();
+    if (this->createPacket(packet)) {
+        this->hpPacketDebug(packet, 22, "WRITE_SETTINGS");
+        if (this->enqueuePacket(packet, PACKET_LEN)) {
+            // control() and the vane selects end up here: watch the unit closely while it applies the change
+            this->armBurstMode("settings write");
+            this->expectSettingsConfirmation();
+        } else {
+            ESP_LOGW(TAG, "settings write not queued, the next readback restores the heatpump state");
+        }
+    } else {
+        this->nbSkippedSettingsWrites_++;
+        ESP_LOGI(TAG, "wantedSettings match the heatpump state, write skipped (%lu so far)", this->nbSkippedSettingsWrites_);
+    }
 
     this->publishWantedSettingsStateToHA();
 
-    // as soon as the packet is sent, we reset the settings
+    // as soon as the packet is queued, we reset the settings
     this->wantedSettings.resetSettings();
-
-    // as we've just sent a packet to the heatpump, we let it time for process
-    // this might not be necessary but, we give it a try because of issue #32
-    // https://github.com/echavet/MitsubishiCN105ESPHome/issues/32
-    this->loopCycle.deferCycle();
 }
 
 /**
@@ -359,21 +489,9 @@ void CN105Climate::sendWantedSettingsDelegate() {
 */
 void CN105Climate::sendWantedSettings() {
     if (this->isHeatpumpConnectionActive() && this->isUARTConnected_) {
-        if (CUSTOM_MILLIS - this->lastSend > 300) {        // we don't want to send too many packets
-
-            //this->cycleEnded();   // only if we let the cycle be interrupted to send wented settings
-
-#ifdef USE_ESP32
-            std::lock_guard<std::mutex> guard(wantedSettingsMutex);
-            this->sendWantedSettingsDelegate();
-#else
-            this->emulateMutex("WRITE_SETTINGS", std::bind(&CN105Climate::sendWantedSettingsDelegate, this));
-
-#endif
-
-        } else {
-            ESP_LOGD(TAG, "will sendWantedSettings later because we've sent one too recently...");
-        }
+        // the write gap is enforced when the TX queue is drained
+        // wantedSettings is only touched from loop(): user changes are merged from the mailbox beforehand
+        this->sendWantedSettingsDelegate();
     } else {
         this->reconnectIfConnectionLost();
     }
@@ -397,6 +515,11 @@ void CN105Climate::buildAndSendRequestPacket(int packetType) {
 }
 
 void CN105Climate::buildAndSendInfoPacket(uint8_t code) {
+    if (this->isUARTConnected_ && this->isHeatpumpConnectionActive() && !this->canTransmit(PACKET_LEN)) {
+        // the scheduler is waiting for this reply: send it as soon as the FIFO has drained
+        this->set_timeout("info_retry", this->getTxRemainingMs() + 1, [this, code]() { this->buildAndSendInfoPacket(code); });
+        return;
+    }
     uint8_t packet[PACKET_LEN] = {};
     createInfoPacket(packet, code);
     this->writePacket(packet, PACKET_LEN);
@@ -410,6 +533,7 @@ void CN105Climate::buildAndSendRequestsInfoPackets() {
         ESP_LOGV("CONTROL_WANTED_SETTINGS", "hasChanged is %s", wantedSettings.hasChanged ? "true" : "false");
         this->loopCycle.cycleStarted();
         this->nbCycles_++;
+        this->scheduler_.set_burst_only(this->isBurstModeActive());
         // Envoie la première requête activable (la liste est enregistrée une fois au constructeur)
         this->scheduler_.send_next_after(0x00); // 0x00 -> start, pick first eligible
     } else {
@@ -423,22 +547,8 @@ void CN105Climate::buildAndSendRequestsInfoPackets() {
 
 void CN105Climate::createInfoPacket(uint8_t* packet, uint8_t code) {
     ESP_LOGD(TAG, "creating Info packet");
-    // add the header to the packet
-    for (int i = 0; i < INFOHEADER_LEN; i++) {
-        packet[i] = INFOHEADER[i];
-    }
-
-    // directly set requested info code (0x02, 0x03, 0x06, 0x09, 0x42, ...)
-    packet[5] = code;
-
-    // pad the packet out
-    for (int i = 0; i < 15; i++) {
-        packet[i + 6] = 0x00;
-    }
-
-    // add the checksum
-    uint8_t chkSum = checkSum(packet, 21);
-    packet[21] = chkSum;
+    // requested info code (0x02, 0x03, 0x06, 0x09, 0x42, ...) goes in the type byte, no data
+    PacketEncoder encoder(packet, msg_info(code));
 }
 
 
@@ -446,70 +556,62 @@ void CN105Climate::sendRemoteTemperature() {
 
     this->shouldSendExternalTemperature_ = false;
 
-    uint8_t packet[PACKET_LEN] = {};
-
-    prepareSetPacket(packet, PACKET_LEN);
+    uint8_t packet[PACKET_LEN];
+    PacketEncoder encoder(packet, MSG_SET_REMOTE_TEMP);
 
-    packet[5] = 0x07;
-    if (this->remoteTemperature_ > 0) {
-        packet[6] = 0x01;
-        float temp = round(this->remoteTemperature_ * 2);
-        packet[7] = static_cast<uint8_t>(temp - 16);
-        packet[8] = static_cast<uint8_t>(temp + 128);
+    if (this->remoteTemperature_ > HalfDegrees::from_halves(0)) {
+        int16_t halves = this->remoteTemperature_.halves();
+        encoder.set(FIELD_REMOTE_TEMP_CONTROL, 0x01)
+            .set(FIELD_REMOTE_TEMP_LEGACY, static_cast<uint8_t>(halves - 16))
+            .set(FIELD_REMOTE_TEMP_HALF, this->remoteTemperature_.half_byte());
     } else {
-        packet[8] = 0x80; //MHK1 send 80, even though it could be 00, since ControlByte is 00
+        encoder.set(FIELD_REMOTE_TEMP_HALF, 0x80); //MHK1 send 80, even though it could be 00, since ControlByte is 00
+    }
+    ESP_LOGD(LOG_REMOTE_TEMP, "Sending remote temperature packet... -> %.1f", this->remoteTemperature_.celsius());
+    if (!this->enqueuePacket(packet, PACKET_LEN)) {
+        this->shouldSendExternalTemperature_ = true;     // tried again at the end of the next cycle
     }
-    // add the checksum
-    uint8_t chkSum = checkSum(packet, 21);
-    packet[21] = chkSum;
-    ESP_LOGD(LOG_REMOTE_TEMP, "Sending remote temperature packet... -> %f", this->remoteTemperature_);
-    writePacket(packet, PACKET_LEN);
 
     // this resets the timeout
     this->pingExternalTemperature();
 }
 
 void CN105Climate::sendWantedRunStates() {
-    uint8_t packet[PACKET_LEN] = {};
-
-    prepareSetPacket(packet, PACKET_LEN);
+    uint8_t packet[PACKET_LEN];
+    PacketEncoder encoder(packet, MSG_SET_RUN_STATES);
 
-    packet[5] = 0x08;
-    if (this->wantedRunStates.airflow_control != nullptr) {
-        ESP_LOGD(TAG, "airflow control -> %s", getAirflowControlSetting());
-        packet[11] = AIRFLOW_CONTROL[lookupByteMapIndex(AIRFLOW_CONTROL_MAP, 3, getAirflowControlSetting(), "run state (write)")];
-        packet[6] += RUN_STATE_PACKET_1[4];
+    if (this->wantedRunStates.airflow_control < sizeof(AIRFLOW_CONTROL)) {
+        ESP_LOGD(TAG, "airflow control -> %s", AIRFLOW_CONTROL_MAP[this->wantedRunStates.airflow_control]);
+        encoder.set(FIELD_AIRFLOW_CONTROL, AIRFLOW_CONTROL[this->wantedRunStates.airflow_control]);
     }
     if (this->wantedRunStates.air_purifier > -1) {
         if (getAirPurifierRunState() != currentRunStates.air_purifier) {
             ESP_LOGI(TAG, "air purifier switch state -> %s", getAirPurifierRunState() ? "ON" : "OFF");
-            packet[17] = getAirPurifierRunState() ? 0x01 : 0x00;
-            packet[7] += RUN_STATE_PACKET_2[1];
+            encoder.set(FIELD_AIR_PURIFIER, getAirPurifierRunState() ? 0x01 : 0x00);
         }
     }
     if (this->wantedRunStates.night_mode > -1) {
         if (getNightModeRunState() != currentRunStates.night_mode) {
             ESP_LOGI(TAG, "night mode switch state -> %s", this->getNightModeRunState() ? "ON" : "OFF");
-            packet[18] = getNightModeRunState() ? 0x01 : 0x00;
-            packet[7] += RUN_STATE_PACKET_2[2];
+            encoder.set(FIELD_NIGHT_MODE, getNightModeRunState() ? 0x01 : 0x00);
         }
     }
     if (this->wantedRunStates.circulator > -1) {
         if (getCirculatorRunState() != currentRunStates.circulator) {
             ESP_LOGI(TAG, "circulator switch state -> %s", getCirculatorRunState() ? "ON" : "OFF");
-            packet[19] = getCirculatorRunState() ? 0x01 : 0x00;
-            packet[7] += RUN_STATE_PACKET_2[3];
+            encoder.set(FIELD_CIRCULATOR, getCirculatorRunState() ? 0x01 : 0x00);
         }
     }
 
-    // Add the checksum
-    uint8_t chkSum = checkSum(packet, 21);
-    packet[21] = chkSum;
     ESP_LOGD(LOG_SET_RUN_STATE, "Sending set run state package (0x08)");
-    writePacket(packet, PACKET_LEN);
+    bool queued = this->enqueuePacket(packet, PACKET_LEN);
 
     this->publishWantedRunStatesStateToHA();
 
+    if (queued) {
+        // HVAC option switches and the airflow control select end up here
+        this->armBurstMode("run states write");
+    }
+
     this->wantedRunStates.resetSettings();
-    this->loopCycle.deferCycle();
 }
@@ -20,9 +20,17 @@ namespace esphome {
         uint32_t soft_timeout_ms;     // optional: skip forward on timeout without blocking cycle
         uint32_t interval_ms;         // Minimum time between requests for this specific code
         uint32_t last_request_time;   // Last time this request was sent (millis)
+        uint32_t last_response_time;  // Last time a response was decoded for this code (millis, 0 = never)
+        bool burst;                   // polled during post-command burst cycles
         std::string timeout_name;     // unique scheduler name for soft-timeout
         const char* log_tag;          // Custom log tag (optional), defaults to LOG_CYCLE_TAG logic
 
+        // counters since boot, exported on /cn105/metrics
+        uint32_t responses = 0;       // decoded responses
+        uint32_t timeouts = 0;        // soft timeouts (cycle) and lost on-demand requests
+        uint32_t last_rtt_ms = 0;     // end of transmission to decoded response
+        uint64_t rtt_sum_ms = 0;      // sum over `responses` RTT samples
+
         // Optional condition to decide whether this request should be sent in this device/config
         std::function<bool(const CN105Climate&)> canSend;
 
@@ -37,7 +45,7 @@ namespace esphome {
             uint32_t soft_timeout_ms = 0,
             uint32_t interval_ms = 0,
             const char* log_tag = nullptr
-        ) : id(id), description(description), code(code), maxFailures(maxFailures), failures(0), disabled(false), awaiting(false), soft_timeout_ms(soft_timeout_ms), interval_ms(interval_ms), last_request_time(0), timeout_name(""), log_tag(log_tag), canSend(nullptr), onResponse(nullptr) {
+        ) : id(id), description(description), code(code), maxFailures(maxFailures), failures(0), disabled(false), awaiting(false), soft_timeout_ms(soft_timeout_ms), interval_ms(interval_ms), last_request_time(0), last_response_time(0), burst(false), timeout_name(""), log_tag(log_tag), canSend(nullptr), onResponse(nullptr) {
             char buf[32];
             std::snprintf(buf, sizeof(buf), "info_timeout_0x%02X", code);
             timeout_name = buf;
@@ -1,80 +1,103 @@
 #pragma once
 
-#include <algorithm>
-#include <vector>
+#include <cmath>
+#include "temperature.h"
+#include "policies.h"
 
 namespace esphome {
-    class FahrenheitSupport {
-        public:
-            void setUseFahrenheitSupportMode(bool value) {
-                use_fahrenheit_support_mode_ = value;
-            }
 
-            float normalizeHeatpumpTemperatureToUiTemperature(const float c) {
-                if (!use_fahrenheit_support_mode_ || c == NAN) {
-                    return c; // If not in Fahrenheit support mode, return the Celsius value as is.
-                }
+    namespace fahrenheit_codec {
+        // Consigne (demi-degrés Celsius) qu'une télécommande Mitsubishi affiche pour chaque °F.
+        // Par exemple 72°F vaut 22.22°C, mais la télécommande envoie 22.5°C.
+        struct FahrenheitStep {
+            uint8_t fahrenheit;
+            uint8_t halves;
+        };
+        inline constexpr FahrenheitStep MITSUBISHI_STEPS[] = {
+            {61, 32}, {62, 33}, {63, 34}, {64, 35}, {65, 36},
+            {66, 37}, {67, 38}, {68, 40}, {69, 42}, {70, 43},
+            {71, 44}, {72, 45}, {73, 46}, {74, 47}, {75, 48},
+            {76, 49}, {77, 50}, {78, 51}, {79, 52}, {80, 53},
+            {81, 54}, {82, 55}, {83, 56}, {84, 57}, {85, 58},
+            {86, 59}, {87, 60}, {88, 61}
+        };
+        inline constexpr int STEP_COUNT = sizeof(MITSUBISHI_STEPS) / sizeof(MITSUBISHI_STEPS[0]);
 
-                auto it = std::upper_bound(
-                    fahrenheitToCelsiusTable.begin(),
-                    fahrenheitToCelsiusTable.end(),
-                    std::make_pair(0.0f, c),
-                    [](const std::pair<float, float>& a, const std::pair<float, float>& b) {
-                        return a.second < b.second;  // compare Celsius
-                    }
-                );
+        inline constexpr bool steps_are_contiguous() {
+            for (int i = 1; i < STEP_COUNT; i++) {
+                if (MITSUBISHI_STEPS[i].fahrenheit != MITSUBISHI_STEPS[0].fahrenheit + i) return false;
+            }
+            return true;
+        }
+        static_assert(steps_are_contiguous(), "MITSUBISHI_STEPS is indexed by fahrenheit - 61");
 
-                if (it == fahrenheitToCelsiusTable.begin() || it == fahrenheitToCelsiusTable.end()) {
-                    return c;
-                }
+        // Pas de tables de 256 entrées (768 octets de RAM sur ESP8266): tout est calculé depuis les 28 pas
 
-                auto prev = it;
-                --prev;
-                float fahrenheitResult = std::abs(prev->second - c) < std::abs(it->second - c) ? prev->first : it->first;
+        // °F -> consigne de l'unité (demi-degrés); hors des pas Mitsubishi, demi-degré le plus proche
+        inline constexpr int16_t ui_fahrenheit_to_halves(int fahrenheit) {
+            int index = fahrenheit - MITSUBISHI_STEPS[0].fahrenheit;
+            if (index >= 0 && index < STEP_COUNT) {
+                return MITSUBISHI_STEPS[index].halves;
+            }
+            int tenths = (fahrenheit - 32) * 10;     // (f - 32) / 1.8 * 2 = (f - 32) * 10 / 9
+            return static_cast<int16_t>(tenths >= 0 ? (tenths + 4) / 9 : -((-tenths + 4) / 9));
+        }
 
-                return (fahrenheitResult - 32.0f) / 1.8f;
+        // consigne de l'unité -> °F que la télécommande afficherait, 0 hors des pas Mitsubishi
+        inline constexpr int heatpump_halves_to_ui_fahrenheit(int halves) {
+            if (halves < MITSUBISHI_STEPS[0].halves || halves > MITSUBISHI_STEPS[STEP_COUNT - 1].halves) {
+                return 0;
             }
+            if (halves == MITSUBISHI_STEPS[STEP_COUNT - 1].halves) {
+                return MITSUBISHI_STEPS[STEP_COUNT - 1].fahrenheit;
+            }
+            // premier pas strictement au-dessus, départagé avec le précédent (égalité -> pas supérieur)
+            int next = 0;
+            while (MITSUBISHI_STEPS[next].halves <= halves) next++;
+            const FahrenheitStep& above = MITSUBISHI_STEPS[next];
+            const FahrenheitStep& below = MITSUBISHI_STEPS[next - 1];
+            return (halves - below.halves) < (above.halves - halves) ? below.fahrenheit : above.fahrenheit;
+        }
 
-            float normalizeUiTemperatureToHeatpumpTemperature(const float c) {
-                if (!use_fahrenheit_support_mode_ || c == NAN) {
-                    return c; // If not in Fahrenheit support mode, return the Celsius value as is.
-                }
+        static_assert(ui_fahrenheit_to_halves(72) == 45, "72°F must map to 22.5°C");
+        static_assert(ui_fahrenheit_to_halves(59) == 30, "59°F must map to 15°C");
+        static_assert(heatpump_halves_to_ui_fahrenheit(39) == 68, "19.5°C must show as 68°F");
+    }
 
+    class FahrenheitSupport {
+        public:
+            void setUseFahrenheitSupportMode(bool value) {
+                use_fahrenheit_support_mode_ = value;
+            }
 
-                float fahrenheitInput = (c * 1.8f) + 32.0f;
+            bool isEnabled() const {
+                return cn105_policy::Units::fahrenheit(use_fahrenheit_support_mode_);
+            }
 
-                // Due to vagaries of floating point math across architectures, we can't
-                // just look up `c` in the map -- we're very unlikely to find a matching
-                // value. Instead, we find the first value greater than `c`, and the
-                // next-lowest value in the map. We return whichever `c` is closer to.
-                auto it = std::upper_bound(fahrenheitToCelsiusTable.begin(), fahrenheitToCelsiusTable.end(), std::make_pair(fahrenheitInput, 0.0f),
-                    [](const std::pair<float, float>& a, const std::pair<float, float>& b) {
-                        return a.first < b.first;
-                    });
-                if (it == fahrenheitToCelsiusTable.begin() || it == fahrenheitToCelsiusTable.end()) {
-                    return c;
+            float normalizeHeatpumpTemperatureToUiTemperature(HalfDegrees c) const {
+                if (!isEnabled() || !c.is_set() || c.halves() < -128 || c.halves() > 127) {
+                    return c.celsius(); // If not in Fahrenheit support mode, return the Celsius value as is.
                 }
+                int fahrenheit = fahrenheit_codec::heatpump_halves_to_ui_fahrenheit(c.halves());
+                if (fahrenheit == 0) {
+                    return c.celsius();     // hors des pas Mitsubishi: valeur Celsius telle quelle
+                }
+                return (fahrenheit - 32.0f) / 1.8f;
+            }
 
-                auto prev = it;
-                --prev;
-
-                return std::abs(prev->first - fahrenheitInput) < std::abs(it->first - fahrenheitInput) ? prev->second : it->second;
+            HalfDegrees normalizeUiTemperatureToHeatpumpTemperature(const float c) const {
+                if (!isEnabled() || std::isnan(c)) {
+                    return HalfDegrees::from_celsius(c); // If not in Fahrenheit support mode, return the Celsius value as is.
+                }
+                // HA sends (°F - 32) / 1.8: the nearest whole °F indexes the table
+                long fahrenheit = lroundf((c * 1.8f) + 32.0f);
+                if (fahrenheit < 0 || fahrenheit > 255) {
+                    return HalfDegrees::from_celsius(c);
+                }
+                return HalfDegrees::from_halves(fahrenheit_codec::ui_fahrenheit_to_halves(static_cast<int>(fahrenheit)));
             }
 
         private:
             bool use_fahrenheit_support_mode_ = false;
-
-            // Given a temperature in Celsius that was converted from Fahrenheit, converts
-            // it to the Celsius value (at half-degree precision) that matches what
-            // Mitsubishi thermostats would have converted the Fahrenheit value to. For
-            // instance, 72°F is 22.22°C, but this class returns 22.5°C.
-            const std::vector<std::pair<float, float>> fahrenheitToCelsiusTable = {
-                {61, 16.0}, {62, 16.5}, {63, 17.0}, {64, 17.5}, {65, 18.0},
-                {66, 18.5}, {67, 19.0}, {68, 20.0}, {69, 21.0}, {70, 21.5},
-                {71, 22.0}, {72, 22.5}, {73, 23.0}, {74, 23.5}, {75, 24.0},
-                {76, 24.5}, {77, 25.0}, {78, 25.5}, {79, 26.0}, {80, 26.5},
-                {81, 27.0}, {82, 27.5}, {83, 28.0}, {84, 28.5}, {85, 29.0},
-                {86, 29.5}, {87, 30.0}, {88, 30.5}
-            };
     };
-}
\ No newline at end of file
+}
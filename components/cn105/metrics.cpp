@@ -0,0 +1,211 @@
+#include "metrics.h"
+
+#ifdef USE_CN105_METRICS
+#include "cn105.h"
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+
+using namespace esphome;
+
+// valeur de label: \ " et fin de ligne doivent être échappés
+static std::string escape_label(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void MetricsExporter::family(const char* name, const char* type, const char* help) {
+    char buffer[192];
+    snprintf(buffer, sizeof(buffer), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    this->write_(buffer);
+}
+
+void MetricsExporter::sample(const char* name, const char* climate, const char* extra_labels, double value) {
+    char buffer[96];
+    this->write_(name);
+    this->write_("{climate=\"");
+    this->write_(climate);
+    this->write_("\"");
+    if (extra_labels != nullptr) {
+        this->write_(",");
+        this->write_(extra_labels);
+    }
+    snprintf(buffer, sizeof(buffer), "} %.3f\n", value);
+    this->write_(buffer);
+}
+
+void MetricsExporter::sample(const char* name, const char* climate, const char* extra_labels, uint64_t value) {
+    char buffer[96];
+    this->write_(name);
+    this->write_("{climate=\"");
+    this->write_(climate);
+    this->write_("\"");
+    if (extra_labels != nullptr) {
+        this->write_(",");
+        this->write_(extra_labels);
+    }
+    snprintf(buffer, sizeof(buffer), "} %" PRIu64 "\n", value);
+    this->write_(buffer);
+}
+
+/**
+ * Counters are since boot: a scrape after a reboot sees them restart from zero, which Prometheus
+ * rate() handles as a counter reset. Durations are exported in seconds, summaries carry _sum and _count only.
+ */
+void MetricsExporter::dump(const std::vector<CN105Climate*>& instances, const std::function<void(const char*)>& write) {
+    MetricsExporter out(write);
+    std::vector<std::string> names;
+    for (CN105Climate* climate : instances) {
+        names.push_back(escape_label(std::string(climate->get_name().c_str())));
+    }
+    auto each = [&](const std::function<void(const CN105Climate&, const char*)>& emit) {
+        for (size_t i = 0; i < instances.size(); i++) {
+            if (instances[i]->hasMetrics()) {
+                emit(*instances[i], names[i].c_str());
+            }
+        }
+    };
+    char labels[64];
+
+    // --- lien ---
+    out.family("cn105_connected", "gauge", "1 while the heat pump answers");
+    each([&](const CN105Climate& c, const char* n) { out.sample("cn105_connected", n, nullptr, (uint64_t) (c.isHeatpumpConnected_ ? 1 : 0)); });
+    out.family("cn105_connection_attempts_total", "counter", "Connection packets sent");
+    each([&](const CN105Climate& c, const char* n) { out.sample("cn105_connection_attempts_total", n, nullptr, (uint64_t) c.nbHeatpumpConnections_); });
+    out.family("cn105_handshakes_total", "counter", "Connection packets answered by the heat pump");
+    each([&](const CN105Climate& c, const char* n) { out.sample("cn105_handshakes_total", n, nullptr, (uint64_t) c.linkStats_.handshakes); });
+    out.family("cn105_reconnects_total", "counter", "UART reinitializations after a lost connection");
+    each([&](const CN105Climate& c, const char* n) { out.sample("cn105_reconnects_total", n, nullptr, (uint64_t) c.linkStats_.reconnects); });
+    out.family("cn105_link_errors_total", "counter", "Lost or corrupted replies (checksum, cycle timeout, lost request or write)");
+    each([&](const CN105Climate& c, const char* n) { out.sample("cn105_link_errors_total", n, nullptr, (uint64_t) c.linkStats_.linkErrors); });
+    out.family("cn105_decoder_errors_total", "counter", "Frames the decoder rejected");
+    each([&](const CN105Climate& c, const char* n) {
+        out.sample("cn105_decoder_errors_total", n, "kind=\"checksum\"", (uint64_t) c.linkStats_.checksumErrors);
+        out.sample("cn105_decoder_errors_total", n, "kind=\"unknown_packet\"", (uint64_t) c.linkStats_.unknownPackets);
+    });
+    out.family("cn105_rx_frames_total", "counter", "Frames received with a valid checksum");
+    each([&](const CN105Climate& c, const char* n) { out.sample("cn105_rx_frames_total", n, nullptr, (uint64_t) c.linkStats_.rxFrames); });
+    out.family("cn105_uart_bytes_total", "counter", "Bytes on the UART");
+    each([&](const CN105Climate& c, const char* n) {
+        out.sample("cn105_uart_bytes_total", n, "direction=\"tx\"", (uint64_t) c.linkStats_.txBytes);
+        out.sample("cn105_uart_bytes_total", n, "direction=\"rx\"", (uint64_t) c.linkStats_.rxBytes);
+    });
+    // rate() of this one is the bus utilization (0..1)
+    out.family("cn105_bus_busy_seconds_total", "counter", "Wire time of all bytes sent and received");
+    each([&](const CN105Climate& c, const char* n) {
+        uint64_t bytes = (uint64_t) c.linkStats_.txBytes + c.linkStats_.rxBytes;
+        out.sample("cn105_bus_busy_seconds_total", n, nullptr, bytes * c.txByteTimeUs_ / 1e6);
+    });
+
+    // --- requêtes info, par code ---
+    out.family("cn105_request_rtt_seconds", "summary", "End of transmission to decoded response, per info code");
+    each([&](const CN105Climate& c, const char* n) {
+        for (const InfoRequest& req : c.scheduler_.get_requests()) {
+            snprintf(labels, sizeof(labels), "code=\"0x%02X\"", req.code);
+            out.sample("cn105_request_rtt_seconds_sum", n, labels, req.rtt_sum_ms / 1000.0);
+            out.sample("cn105_request_rtt_seconds_count", n, labels, (uint64_t) req.responses);
+        }
+    });
+    out.family("cn105_request_last_rtt_seconds", "gauge", "Last measured round trip, per info code");
+    each([&](const CN105Climate& c, const char* n) {
+        for (const InfoRequest& req : c.scheduler_.get_requests()) {
+            snprintf(labels, sizeof(labels), "code=\"0x%02X\"", req.code);
+            out.sample("cn105_request_last_rtt_seconds", n, labels, req.last_rtt_ms / 1000.0);
+        }
+    });
+    out.family("cn105_request_timeouts_total", "counter", "Soft timeouts and lost on-demand requests, per info code");
+    each([&](const CN105Climate& c, const char* n) {
+        for (const InfoRequest& req : c.scheduler_.get_requests()) {
+            snprintf(labels, sizeof(labels), "code=\"0x%02X\"", req.code);
+            out.sample("cn105_request_timeouts_total", n, labels, (uint64_t) req.timeouts);
+        }
+    });
+    out.family("cn105_request_disabled", "gauge", "1 when an info code was disabled as not supported");
+    each([&](const CN105Climate& c, const char* n) {
+        for (const InfoRequest& req : c.scheduler_.get_requests()) {
+            snprintf(labels, sizeof(labels), "code=\"0x%02X\"", req.code);
+            out.sample("cn105_request_disabled", n, labels, (uint64_t) (req.disabled ? 1 : 0));
+        }
+    });
+
+    // --- cycles ---
+    out.family("cn105_cycles_started_total", "counter", "Polling cycles started");
+    each([&](const CN105Climate& c, const char* n) { out.sample("cn105_cycles_started_total", n, nullptr, (uint64_t) c.nbCycles_); });
+    out.family("cn105_cycle_timeouts_total", "counter", "Polling cycles reset after a timeout");
+    each([&](const CN105Climate& c, const char* n) { out.sample("cn105_cycle_timeouts_total", n, nullptr, (uint64_t) c.loopCycle.timedOutCycles); });
+    out.family("cn105_cycle_duration_seconds", "summary", "Polling cycle duration, timed out cycles included");
+    each([&](const CN105Climate& c, const char* n) {
+        out.sample("cn105_cycle_duration_seconds_sum", n, nullptr, c.loopCycle.durationSumMs / 1000.0);
+        out.sample("cn105_cycle_duration_seconds_count", n, nullptr, (uint64_t) c.loopCycle.endedCycles);
+    });
+    out.family("cn105_cycle_last_duration_seconds", "gauge", "Duration of the last polling cycle");
+    each([&](const CN105Climate& c, const char* n) { out.sample("cn105_cycle_last_duration_seconds", n, nullptr, c.loopCycle.lastDurationMs / 1000.0); });
+    out.family("cn105_pacing_rest_seconds", "gauge", "Learned rest time between cycles");
+    each([&](const CN105Climate& c, const char* n) { out.sample("cn105_pacing_rest_seconds", n, nullptr, c.pacing_.get_rest_time() / 1000.0); });
+
+    // --- écritures, par type ---
+    out.family("cn105_writes_sent_total", "counter", "Writes handed to the UART, per write type");
+    each([&](const CN105Climate& c, const char* n) {
+        for (int i = 0; i < WRITE_TXN_TYPE_COUNT; i++) {
+            uint8_t type = WriteTransactions::type_at(i);
+            snprintf(labels, sizeof(labels), "type=\"%s\"", WriteTransactions::type_name(type));
+            out.sample("cn105_writes_sent_total", n, labels, (uint64_t) c.writeTxns_.get_stats(type).sent);
+        }
+    });
+    out.family("cn105_write_retries_total", "counter", "Writes resent for lack of ACK, per write type");
+    each([&](const CN105Climate& c, const char* n) {
+        for (int i = 0; i < WRITE_TXN_TYPE_COUNT; i++) {
+            uint8_t type = WriteTransactions::type_at(i);
+            snprintf(labels, sizeof(labels), "type=\"%s\"", WriteTransactions::type_name(type));
+            out.sample("cn105_write_retries_total", n, labels, (uint64_t) c.writeTxns_.get_stats(type).retries);
+        }
+    });
+    out.family("cn105_write_outcomes_total", "counter", "Finished writes, per write type and outcome");
+    each([&](const CN105Climate& c, const char* n) {
+        for (int i = 0; i < WRITE_TXN_TYPE_COUNT; i++) {
+            uint8_t type = WriteTransactions::type_at(i);
+            const WriteTransactions::Stats& stats = c.writeTxns_.get_stats(type);
+            const char* name = WriteTransactions::type_name(type);
+            snprintf(labels, sizeof(labels), "type=\"%s\",outcome=\"acked\"", name);
+            out.sample("cn105_write_outcomes_total", n, labels, (uint64_t) stats.acked);
+            snprintf(labels, sizeof(labels), "type=\"%s\",outcome=\"lost\"", name);
+            out.sample("cn105_write_outcomes_total", n, labels, (uint64_t) stats.lost);
+            snprintf(labels, sizeof(labels), "type=\"%s\",outcome=\"superseded\"", name);
+            out.sample("cn105_write_outcomes_total", n, labels, (uint64_t) stats.superseded);
+        }
+    });
+    out.family("cn105_write_ack_latency_seconds", "summary", "Last transmission to ACK, per write type");
+    each([&](const CN105Climate& c, const char* n) {
+        for (int i = 0; i < WRITE_TXN_TYPE_COUNT; i++) {
+            uint8_t type = WriteTransactions::type_at(i);
+            const WriteTransactions::Stats& stats = c.writeTxns_.get_stats(type);
+            snprintf(labels, sizeof(labels), "type=\"%s\"", WriteTransactions::type_name(type));
+            out.sample("cn105_write_ack_latency_seconds_sum", n, labels, stats.latency_sum_ms / 1000.0);
+            out.sample("cn105_write_ack_latency_seconds_count", n, labels, (uint64_t) stats.acked);
+        }
+    });
+    out.family("cn105_write_ack_latency_max_seconds", "gauge", "Slowest ACK since boot, per write type");
+    each([&](const CN105Climate& c, const char* n) {
+        for (int i = 0; i < WRITE_TXN_TYPE_COUNT; i++) {
+            uint8_t type = WriteTransactions::type_at(i);
+            snprintf(labels, sizeof(labels), "type=\"%s\"", WriteTransactions::type_name(type));
+            out.sample("cn105_write_ack_latency_max_seconds", n, labels, c.writeTxns_.get_stats(type).max_latency_ms / 1000.0);
+        }
+    });
+    out.family("cn105_settings_writes_skipped_total", "counter", "Settings writes dropped because the heat pump already matched");
+    each([&](const CN105Climate& c, const char* n) {
+        out.sample("cn105_settings_writes_skipped_total", n, nullptr, (uint64_t) c.nbSkippedSettingsWrites_);
+    });
+}
+#endif
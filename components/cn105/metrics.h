@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "esphome/core/defines.h"
+
+namespace esphome {
+
+    class CN105Climate;
+
+    /**
+     * @brief Compteurs du lien UART depuis le boot
+     *
+     * Toujours tenus (quelques incréments par trame), exportés seulement avec `metrics: true`.
+     */
+    struct LinkStats {
+        uint32_t txBytes = 0;
+        uint32_t rxBytes = 0;
+        uint32_t rxFrames = 0;              // trames au checksum valide
+        uint32_t checksumErrors = 0;
+        uint32_t unknownPackets = 0;        // commande ou code de donnée inconnu
+        uint32_t linkErrors = 0;            // reportLinkError(), connecté ou non
+        uint32_t handshakes = 0;            // réponses 0x7A au paquet de connexion
+        uint32_t reconnects = 0;            // reconnectUART()
+    };
+
+#ifdef USE_CN105_METRICS
+    /**
+     * @class MetricsExporter
+     * @brief Métriques internes au format texte Prometheus (0.0.4)
+     *
+     * Chaque famille est écrite une fois, avec un échantillon par climatiseur (label `climate`), pour que
+     * plusieurs instances cn105 sur le même ESP restent une exposition valide.
+     */
+    class MetricsExporter {
+    public:
+        static void dump(const std::vector<CN105Climate*>& instances, const std::function<void(const char*)>& write);
+
+    private:
+        explicit MetricsExporter(const std::function<void(const char*)>& write) : write_(write) {}
+
+        void family(const char* name, const char* type, const char* help);
+        void sample(const char* name, const char* climate, const char* extra_labels, double value);
+        void sample(const char* name, const char* climate, const char* extra_labels, uint64_t value);
+
+        const std::function<void(const char*)>& write_;
+    };
+#endif
+
+}
@@ -0,0 +1,79 @@
+#include "pacing_controller.h"
+#include "Globals.h"
+
+using namespace esphome;
+
+void PacingController::init(uint32_t pref_hash) {
+    this->pref_ = global_preferences->make_preference<SavedPacing>(pref_hash);
+    this->pref_ready_ = true;
+
+    SavedPacing saved{};
+    if (this->pref_.load(&saved) &&
+        saved.rest_ms >= PACING_MIN_REST_MS && saved.rest_ms <= PACING_MAX_REST_MS &&
+        saved.floor_ms >= PACING_MIN_REST_MS && saved.floor_ms <= saved.rest_ms) {
+        this->rest_ms_ = saved.rest_ms;
+        this->floor_ms_ = saved.floor_ms;
+        ESP_LOGI(LOG_PACING_TAG, "Restored rest time %u ms (floor %u ms)", (unsigned) this->rest_ms_, (unsigned) this->floor_ms_);
+    } else {
+        ESP_LOGI(LOG_PACING_TAG, "No learned pacing yet, starting at %u ms", (unsigned) this->rest_ms_);
+    }
+}
+
+void PacingController::on_success() {
+    if (!this->armed_) {
+        return;
+    }
+    this->armed_ = false;
+    if (++this->streak_ < PACING_SUCCESS_STREAK) {
+        return;
+    }
+    this->streak_ = 0;
+
+    if (this->rest_ms_ > this->floor_ms_) {
+        uint32_t shorter = this->rest_ms_ - PACING_STEP_MS;
+        this->rest_ms_ = shorter > this->floor_ms_ ? shorter : this->floor_ms_;
+        ESP_LOGD(LOG_PACING_TAG, "Link clean, rest time shortened to %u ms", (unsigned) this->rest_ms_);
+        this->dirty_ = true;
+    } else if (this->floor_ms_ > PACING_MIN_REST_MS && ++this->floor_streaks_ >= PACING_FLOOR_PROBE_STREAKS) {
+        // a failure long ago may have been a one-off: probe one step below the floor again
+        this->floor_streaks_ = 0;
+        this->floor_ms_ -= PACING_STEP_MS;
+        ESP_LOGD(LOG_PACING_TAG, "Stable at %u ms, allowing probe down to %u ms", (unsigned) this->rest_ms_, (unsigned) this->floor_ms_);
+    }
+}
+
+void PacingController::on_failure(const char* reason) {
+    if (!this->armed_) {
+        return;
+    }
+    this->armed_ = false;
+    this->streak_ = 0;
+    this->floor_streaks_ = 0;
+
+    uint32_t floor = this->rest_ms_ + PACING_STEP_MS;
+    this->floor_ms_ = floor < PACING_MAX_REST_MS ? floor : PACING_MAX_REST_MS;
+
+    uint32_t longer = this->rest_ms_ * 3 / 2;
+    if (longer < this->floor_ms_) longer = this->floor_ms_;
+    this->rest_ms_ = longer < PACING_MAX_REST_MS ? longer : PACING_MAX_REST_MS;
+
+    ESP_LOGW(LOG_PACING_TAG, "%s: rest time raised to %u ms (floor %u ms)", reason, (unsigned) this->rest_ms_, (unsigned) this->floor_ms_);
+    this->dirty_ = true;
+}
+
+void PacingController::loop(uint32_t now) {
+    if (this->dirty_ && (now - this->last_save_ms_) >= PACING_SAVE_INTERVAL_MS) {
+        this->last_save_ms_ = now;
+        this->save_();
+    }
+}
+
+void PacingController::save_() {
+    if (!this->pref_ready_) {
+        return;
+    }
+    SavedPacing saved{ this->rest_ms_, this->floor_ms_ };
+    if (this->pref_.save(&saved)) {
+        this->dirty_ = false;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include "cn105_types.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+
+    /**
+     * @class PacingController
+     * @brief Apprend le temps de repos minimal après une écriture accepté par l'unité.
+     *
+     * On démarre prudemment (PACING_INITIAL_REST_MS) et on raccourcit de PACING_STEP_MS après chaque
+     * série d'échanges sans perte. Une réponse manquante ou corrompue allonge le repos (x1.5) et
+     * remonte le plancher au-dessus de la valeur fautive.
+     * Seul l'échange qui suit une écriture compte (arm()): un cycle de polling ordinaire n'a pas eu
+     * de repos et ne dit rien sur sa durée. La valeur retenue est persistée en flash au plus une fois
+     * par PACING_SAVE_INTERVAL_MS. L'écart minimal entre deux écritures en découle.
+     */
+    class PacingController {
+    public:
+        /**
+         * @brief Charge la valeur apprise lors d'un précédent démarrage
+         * @param pref_hash Clé de préférence propre à l'instance
+         */
+        void init(uint32_t pref_hash);
+
+        /// repos après une écriture avant de relancer un cycle
+        uint32_t get_rest_time() const { return rest_ms_; }
+
+        /// écart minimal entre deux écritures, jamais sous les 300 ms d'origine
+        uint32_t get_write_gap() const {
+            uint32_t gap = rest_ms_ * 2 / 5;
+            return gap > PACING_MIN_WRITE_GAP_MS ? gap : PACING_MIN_WRITE_GAP_MS;
+        }
+
+        /// une écriture vient de partir suivie du repos courant: le prochain échange le met à l'épreuve
+        void arm() { armed_ = true; }
+        bool is_armed() const { return armed_; }
+
+        /// le premier cycle après le repos s'est terminé sans perte (ignoré si rien n'est armé)
+        void on_success();
+
+        /// réponse manquante, cycle en timeout ou checksum invalide après le repos (ignoré si rien n'est armé)
+        void on_failure(const char* reason);
+
+        /// écrit la valeur apprise si elle a changé et que PACING_SAVE_INTERVAL_MS est écoulé
+        void loop(uint32_t now);
+
+    private:
+        struct SavedPacing {
+            uint32_t rest_ms;
+            uint32_t floor_ms;
+        };
+
+        uint32_t rest_ms_ = PACING_INITIAL_REST_MS;
+        uint32_t floor_ms_ = PACING_MIN_REST_MS;     // plus court repos non encore pris en défaut
+        uint8_t streak_ = 0;
+        uint8_t floor_streaks_ = 0;
+        bool armed_ = false;
+        ESPPreferenceObject pref_;
+        bool pref_ready_ = false;
+        bool dirty_ = false;
+        uint32_t last_save_ms_ = 0;
+
+        void save_();
+    };
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include "cn105_types.h"
+
+namespace esphome {
+
+    /**
+     * Outgoing CN105 frames: 0xFC, command, 0x01, 0x30, 0x10, type, 15 data bytes, checksum.
+     * Each message type is a compile-time descriptor (header + precomputed header sum) and each
+     * field a (flag byte, flag mask, data byte) triple. PacketEncoder only touches the fields it is
+     * given and keeps the checksum up to date as it goes.
+     */
+
+    static constexpr uint8_t PACKET_CHECKSUM_INDEX = PACKET_LEN - 1;
+
+    constexpr uint8_t packet_checksum_from_sum(uint8_t sum) {
+        return static_cast<uint8_t>((0xfc - sum) & 0xff);
+    }
+
+    struct PacketMessage {
+        uint8_t command;
+        uint8_t type;
+        uint8_t header_sum;         // sum of the 6 header bytes, folded at compile time
+    };
+
+    constexpr PacketMessage packet_message(uint8_t command, uint8_t type) {
+        return PacketMessage{ command, type, static_cast<uint8_t>(0xfc + command + 0x01 + 0x30 + 0x10 + type) };
+    }
+
+    struct PacketField {
+        uint8_t flag_byte;          // 0: field without flag
+        uint8_t flag_mask;
+        uint8_t data_byte;
+    };
+
+    // 0x41 set messages
+    static constexpr PacketMessage MSG_SET_SETTINGS = packet_message(0x41, 0x01);
+    static constexpr PacketMessage MSG_SET_REMOTE_TEMP = packet_message(0x41, 0x07);
+    static constexpr PacketMessage MSG_SET_RUN_STATES = packet_message(0x41, 0x08);
+    static constexpr PacketMessage MSG_SET_FUNCTIONS_1 = packet_message(0x41, FUNCTIONS_SET_PART1);
+    static constexpr PacketMessage MSG_SET_FUNCTIONS_2 = packet_message(0x41, FUNCTIONS_SET_PART2);
+
+    // 0x42 info requests, the type is the requested code
+    constexpr PacketMessage msg_info(uint8_t code) { return packet_message(0x42, code); }
+
+    // settings (0x01)
+    static constexpr PacketField FIELD_POWER{ 6, 0x01, 8 };
+    static constexpr PacketField FIELD_MODE{ 6, 0x02, 9 };
+    static constexpr PacketField FIELD_TEMPERATURE{ 6, 0x04, 10 };          // table index (tempMode false)
+    static constexpr PacketField FIELD_TEMPERATURE_HALF{ 6, 0x04, 19 };     // half degrees + 128 (tempMode true)
+    static constexpr PacketField FIELD_FAN{ 6, 0x08, 11 };
+    static constexpr PacketField FIELD_VANE{ 6, 0x10, 12 };
+    static constexpr PacketField FIELD_WIDEVANE{ 7, 0x01, 18 };             // bit 7: wide vane adjust
+
+    // remote temperature (0x07)
+    static constexpr PacketField FIELD_REMOTE_TEMP_CONTROL{ 0, 0, 6 };      // 0x01: use the remote temperature
+    static constexpr PacketField FIELD_REMOTE_TEMP_LEGACY{ 0, 0, 7 };
+    static constexpr PacketField FIELD_REMOTE_TEMP_HALF{ 0, 0, 8 };         // half degrees + 128
+
+    // run states (0x08)
+    static constexpr PacketField FIELD_AIRFLOW_CONTROL{ 6, 0x20, 11 };      // RUN_STATE_PACKET_1[4] of the original code
+    static constexpr PacketField FIELD_AIR_PURIFIER{ 7, 0x04, 17 };
+    static constexpr PacketField FIELD_NIGHT_MODE{ 7, 0x08, 18 };
+    static constexpr PacketField FIELD_CIRCULATOR{ 7, 0x10, 19 };
+
+    static constexpr uint8_t PACKET_DATA_OFFSET = 6;
+    static constexpr uint8_t PACKET_DATA_LEN = 15;
+
+    class PacketEncoder {
+    public:
+        PacketEncoder(uint8_t* packet, const PacketMessage& message) : packet_(packet), sum_(message.header_sum) {
+            memset(packet, 0, PACKET_LEN);
+            packet[0] = 0xfc;
+            packet[1] = message.command;
+            packet[2] = 0x01;
+            packet[3] = 0x30;
+            packet[4] = 0x10;
+            packet[5] = message.type;
+            packet[PACKET_CHECKSUM_INDEX] = packet_checksum_from_sum(sum_);
+        }
+
+        /// sets the flag of the field (once) and its data byte
+        PacketEncoder& set(const PacketField& field, uint8_t value) {
+            if (field.flag_mask != 0 && (this->packet_[field.flag_byte] & field.flag_mask) == 0) {
+                this->packet_[field.flag_byte] |= field.flag_mask;
+                this->sum_ += field.flag_mask;
+            }
+            this->sum_ += static_cast<uint8_t>(value - this->packet_[field.data_byte]);
+            this->packet_[field.data_byte] = value;
+            this->packet_[PACKET_CHECKSUM_INDEX] = packet_checksum_from_sum(this->sum_);
+            return *this;
+        }
+
+        /// raw data bytes, for messages without per-field flags (functions)
+        PacketEncoder& set_data(const uint8_t* data, uint8_t offset, uint8_t length) {
+            for (uint8_t i = 0; i < length && offset + i < PACKET_CHECKSUM_INDEX; i++) {
+                this->sum_ += static_cast<uint8_t>(data[i] - this->packet_[offset + i]);
+                this->packet_[offset + i] = data[i];
+            }
+            this->packet_[PACKET_CHECKSUM_INDEX] = packet_checksum_from_sum(this->sum_);
+            return *this;
+        }
+
+        bool has(const PacketField& field) const {
+            return field.flag_mask != 0 && (this->packet_[field.flag_byte] & field.flag_mask) != 0;
+        }
+
+        uint8_t checksum() const { return this->packet_[PACKET_CHECKSUM_INDEX]; }
+
+    private:
+        uint8_t* packet_;
+        uint8_t sum_;
+    };
+
+}
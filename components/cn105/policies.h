@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include "esphome/core/defines.h"
+#include "cn105_types.h"
+
+namespace esphome {
+
+    /**
+     * Politiques fixées à la compilation
+     *
+     * climate.py ajoute un define CN105_* quand toutes les instances cn105 du YAML partagent la même valeur
+     * d'une option. La politique correspondante rend alors la réponse constante et le compilateur retire
+     * la branche morte (et les tables qu'elle seule utilisait, ex. Fahrenheit). Sans define, on garde le test à l'exécution.
+     *
+     * Portée volontairement limitée à la consigne, aux unités et au repli stage:
+     * - pas d'instanciation de CN105Climate<Policies...>: la classe est répartie sur une quinzaine de .cpp et
+     *   ses entités gardent un CN105Climate*, tout passerait dans les headers pour un gain de quelques octets;
+     * - pas de politique de verrouillage: le seul mutex (esp32Mutex / esp8266Mutex) n'existe qu'en TEST_MODE
+     *   et dépend déjà de USE_ESP32;
+     * - les tests nullptr des entités optionnelles restent: une comparaison par publication, hors du chemin de décodage.
+     * Mesure hôte (g++ -Os, tous les .cpp): 101.7 Ko -> 97.8 Ko de texte avec SINGLE/CELSIUS/STAGE_STATUS_OFF.
+     */
+    namespace cn105_policy {
+
+        // bits de Capability qu'une politique fixe, et leur valeur
+        template<uint16_t MASK, uint16_t VALUES>
+        struct FixedCapabilities {
+            static constexpr uint16_t fixed_mask = MASK;
+            static constexpr uint16_t fixed_values = VALUES;
+        };
+
+        // Modèle de consigne
+        struct SingleSetpoint : FixedCapabilities<CAP_DUAL_SETPOINT, 0> {};
+        struct DualSetpoint : FixedCapabilities<CAP_DUAL_SETPOINT, CAP_DUAL_SETPOINT> {};
+        struct RuntimeSetpoint : FixedCapabilities<0, 0> {};
+
+#if defined(CN105_SETPOINT_SINGLE)
+        using Setpoint = SingleSetpoint;
+#elif defined(CN105_SETPOINT_DUAL)
+        using Setpoint = DualSetpoint;
+#else
+        using Setpoint = RuntimeSetpoint;
+#endif
+
+        // Unités de température côté HA
+        struct CelsiusUnits : FixedCapabilities<CAP_FAHRENHEIT, 0> {
+            static constexpr bool fahrenheit(bool) { return false; }
+        };
+        struct FahrenheitCompatUnits : FixedCapabilities<CAP_FAHRENHEIT, CAP_FAHRENHEIT> {
+            static constexpr bool fahrenheit(bool) { return true; }
+        };
+        struct RuntimeUnits : FixedCapabilities<0, 0> {
+            static constexpr bool fahrenheit(bool configured) { return configured; }
+        };
+
+#if defined(CN105_UNITS_CELSIUS)
+        using Units = CelsiusUnits;
+#elif defined(CN105_UNITS_FAHRENHEIT_COMPAT)
+        using Units = FahrenheitCompatUnits;
+#else
+        using Units = RuntimeUnits;
+#endif
+
+        // Stage comme repli pour l'état de fonctionnement (stage_sensor: use_as_operating_fallback)
+        struct StageStatus {
+#if defined(CN105_STAGE_STATUS_OFF)
+            static constexpr bool enabled(bool) { return false; }
+#elif defined(CN105_STAGE_STATUS_ON)
+            static constexpr bool enabled(bool) { return true; }
+#else
+            static constexpr bool enabled(bool configured) { return configured; }
+#endif
+        };
+
+        /**
+         * @brief Masque de capacités vu par le code: les bits fixés par les politiques priment sur le snapshot
+         */
+        constexpr uint16_t capabilities(uint16_t snapshot) {
+            return static_cast<uint16_t>((snapshot & ~(Setpoint::fixed_mask | Units::fixed_mask)) |
+                Setpoint::fixed_values | Units::fixed_values);
+        }
+    }
+
+}
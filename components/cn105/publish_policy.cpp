@@ -0,0 +1,42 @@
+#include "publish_policy.h"
+#include <cmath>
+
+using namespace esphome;
+
+void PublishPolicy::configure(float deadband, uint32_t min_interval_ms, uint32_t max_interval_ms) {
+    this->deadband_ = deadband;
+    this->min_interval_ms_ = min_interval_ms;
+    this->max_interval_ms_ = max_interval_ms;
+}
+
+bool PublishPolicy::offer(float value, uint32_t now) {
+    uint32_t elapsed = now - this->last_ms_;
+    bool publish;
+    if (!this->published_) {
+        publish = !std::isnan(value);                           // first known value always goes out
+    } else if ((this->max_interval_ms_ > 0) && (elapsed >= this->max_interval_ms_)) {
+        publish = true;                                         // keep-alive, even inside the deadband
+    } else if ((this->min_interval_ms_ > 0) && (elapsed < this->min_interval_ms_)) {
+        publish = false;                                        // too soon, the next frame will offer it again
+    } else {
+        publish = this->moved_(value);
+    }
+
+    if (publish) {
+        this->published_ = true;
+        this->last_value_ = value;
+        this->last_ms_ = now;
+    }
+    return publish;
+}
+
+bool PublishPolicy::moved_(float value) const {
+    bool was_nan = std::isnan(this->last_value_);
+    if (std::isnan(value) || was_nan) {
+        return std::isnan(value) != was_nan;
+    }
+    if (this->deadband_ > 0.0f) {
+        return std::fabs(value - this->last_value_) >= this->deadband_;
+    }
+    return value != this->last_value_;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+
+    /**
+     * Capteurs numériques dont la publication passe par une PublishPolicy
+     */
+    enum PublishedSensor : uint8_t {
+        PUBLISHED_COMPRESSOR_FREQUENCY = 0,
+        PUBLISHED_INPUT_POWER,
+        PUBLISHED_KWH,
+        PUBLISHED_RUNTIME_HOURS,
+        PUBLISHED_OUTSIDE_TEMPERATURE,
+        PUBLISHED_SENSOR_COUNT
+    };
+
+    /**
+     * @class PublishPolicy
+     * @brief Décide si une nouvelle valeur d'un capteur part vers HA (deadband, intervalles min et max)
+     *
+     * La valeur est comparée à la dernière valeur publiée, pas à la précédente reçue: une dérive lente
+     * finit par franchir le deadband. Sans réglage, seule une valeur différente est publiée.
+     */
+    class PublishPolicy {
+    public:
+        void configure(float deadband, uint32_t min_interval_ms, uint32_t max_interval_ms);
+
+        /**
+         * @brief À appeler à chaque trame qui porte la valeur, même inchangée (pour l'intervalle max)
+         * @return true si la valeur doit être publiée maintenant, elle devient alors la référence
+         */
+        bool offer(float value, uint32_t now);
+
+    private:
+        float deadband_ = 0.0f;
+        uint32_t min_interval_ms_ = 0;
+        uint32_t max_interval_ms_ = 0;
+
+        bool published_ = false;
+        float last_value_ = 0.0f;
+        uint32_t last_ms_ = 0;
+
+        bool moved_(float value) const;
+    };
+
+}
@@ -11,6 +11,10 @@ RequestScheduler::RequestScheduler(
     TerminateCallback terminate_callback,
     ContextCallback context_callback
 ) : current_request_index_(-1),
+burst_only_(false),
+single_shot_code_(0x00),
+last_rtt_ms_(0),
+avg_rtt_ms_(0),
 send_callback_(send_callback),
 timeout_callback_(timeout_callback),
 terminate_callback_(terminate_callback),
@@ -23,6 +27,19 @@ void RequestScheduler::register_request(InfoRequest& req) {
 void RequestScheduler::clear_requests() {
     requests_.clear();
     current_request_index_ = -1;
+    single_shot_code_ = 0x00;
+    while (!pending_refreshes_.empty()) {
+        resolve_refreshes(pending_refreshes_.front().code, false);
+    }
+}
+
+InfoRequest* RequestScheduler::find_request(uint8_t code) {
+    for (auto& req : requests_) {
+        if (req.code == code) {
+            return &req;
+        }
+    }
+    return nullptr;
 }
 
 void RequestScheduler::disable_request(uint8_t code) {
@@ -34,6 +51,10 @@ void RequestScheduler::disable_request(uint8_t code) {
     }
 }
 
+void RequestScheduler::set_burst_only(bool burst_only) {
+    burst_only_ = burst_only;
+}
+
 bool RequestScheduler::is_empty() const {
     return requests_.empty();
 }
@@ -60,21 +81,33 @@ void RequestScheduler::send_request(uint8_t code, CN105Climate* context) {
         ESP_LOGD(tag, "Sending %s (0x%02X)", req.description, req.code);
 
         req.awaiting = true;
-        req.last_request_time = CUSTOM_MILLIS;
 
         // Envoyer le paquet via le callback
         if (send_callback_) {
             send_callback_(req.code);
         }
 
+        // RTT et timeout comptent depuis la fin réelle de l'émission, pas depuis l'appel
+        uint32_t wire_ms = context ? context->getTxRemainingMs() : 0;
+        req.last_request_time = CUSTOM_MILLIS + wire_ms;
+
+        // Une requête hors cycle a toujours un timeout, pour ne pas bloquer le démarrage des cycles
+        uint32_t timeout_ms = req.soft_timeout_ms;
+        if (single_shot_code_ == req.code && timeout_ms == 0) {
+            timeout_ms = REFRESH_RESPONSE_TIMEOUT_MS;
+        }
+        if (timeout_ms > 0) {
+            timeout_ms += wire_ms;
+        }
+
         // Gérer le timeout si configuré et si le callback est disponible
-        if (req.soft_timeout_ms > 0 && timeout_callback_) {
+        if (timeout_ms > 0 && timeout_callback_) {
             uint8_t code_copy = req.code;
             const std::string tname = req.timeout_name.empty() ?
                 (std::string("info_timeout_") + std::to_string(code_copy)) :
                 req.timeout_name;
 
-            timeout_callback_(tname, req.soft_timeout_ms, [this, code_copy]() {
+            timeout_callback_(tname, timeout_ms, [this, code_copy]() {
                 // Obtenir le contexte pour send_next_after
                 CN105Climate* ctx = nullptr;
                 if (this->context_callback_) {
@@ -85,6 +118,17 @@ void RequestScheduler::send_request(uint8_t code, CN105Climate* context) {
                 for (auto& r : this->requests_) {
                     if (r.code == code_copy && r.awaiting) {
                         r.awaiting = false;
+                        r.timeouts++;
+                        if (this->single_shot_code_ == code_copy) {
+                            // requête hors cycle: pas d'enchaînement, on libère les appelants
+                            this->single_shot_code_ = 0x00;
+                            ESP_LOGW(LOG_CYCLE_TAG, "No response to on-demand %s (0x%02X)", r.description, r.code);
+                            if (ctx != nullptr) {
+                                ctx->reportLinkError("on-demand request lost");
+                            }
+                            this->resolve_refreshes(code_copy, false);
+                            break;
+                        }
                         r.failures++;
                         ESP_LOGW(LOG_CYCLE_TAG, "Soft timeout for %s (0x%02X), failures: %d",
                             r.description, r.code, r.failures);
@@ -113,14 +157,27 @@ void RequestScheduler::mark_response_seen(uint8_t code, CN105Climate* context) {
 
     for (auto& req : requests_) {
         if (req.code == code) {
+            uint32_t now = CUSTOM_MILLIS;
+            if (req.awaiting && (int32_t) (now - req.last_request_time) >= 0) {
+                uint32_t rtt = now - req.last_request_time;
+                last_rtt_ms_ = rtt;
+                avg_rtt_ms_ = (avg_rtt_ms_ == 0) ? rtt : (avg_rtt_ms_ * 7 + rtt) / 8;
+                req.last_rtt_ms = rtt;
+                req.rtt_sum_ms += rtt;
+                req.responses++;
+            }
             req.awaiting = false;
             req.failures = 0;
-            ESP_LOGD(LOG_CYCLE_TAG, "Receiving %s (0x%02X)", req.description, req.code);
+            req.last_response_time = now;
+            ESP_LOGD(LOG_CYCLE_TAG, "Receiving %s (0x%02X), rtt %u ms", req.description, req.code, (unsigned) last_rtt_ms_);
 
             // Appeler le callback onResponse si présent et si le contexte est disponible
             if (req.onResponse && context) {
                 req.onResponse(*context);
             }
+
+            // les données viennent d'être décodées: libérer les appelants en attente de ce code
+            resolve_refreshes(code, true);
             return;
         }
     }
@@ -151,6 +208,11 @@ void RequestScheduler::send_next_after(uint8_t previous_code, CN105Climate* cont
             continue;
         }
 
+        if (burst_only_ && !req.burst) {
+            ESP_LOGV(LOG_CYCLE_TAG, "Skipping %s (0x%02X): burst cycle", req.description, req.code);
+            continue;
+        }
+
         // Vérifier canSend si présent et si le contexte est disponible
         if (req.canSend && context) {
             if (!req.canSend(*context)) {
@@ -197,14 +259,111 @@ bool RequestScheduler::process_response(uint8_t code, CN105Climate* context) {
     }
     if (!handled) return false;
 
+    if (single_shot_code_ == code) {
+        // réponse à une requête hors cycle: ne pas enchaîner sur le reste du cycle
+        single_shot_code_ = 0x00;
+        mark_response_seen(code, context);
+        return true;
+    }
+
     mark_response_seen(code, context);
     send_next_after(code, context);
     return true;
 }
 
+uint32_t RequestScheduler::get_response_age(uint8_t code) const {
+    for (const auto& req : requests_) {
+        if (req.code == code) {
+            if (req.last_response_time == 0) {
+                return UINT32_MAX;
+            }
+            return CUSTOM_MILLIS - req.last_response_time;
+        }
+    }
+    return UINT32_MAX;
+}
+
+void RequestScheduler::request_refresh(uint8_t code, uint32_t max_age_ms, RefreshCallback callback) {
+    uint32_t age = get_response_age(code);
+    if (age <= max_age_ms) {
+        ESP_LOGV(LOG_CYCLE_TAG, "Refresh 0x%02X: data is fresh enough (%u ms)", code, (unsigned)age);
+        if (callback) callback(true);
+        return;
+    }
+
+    InfoRequest* req = find_request(code);
+    if (req == nullptr || req->disabled) {
+        ESP_LOGW(LOG_CYCLE_TAG, "Refresh 0x%02X: request unknown or disabled", code);
+        if (callback) callback(false);
+        return;
+    }
+
+    // coalescence: un seul aller-retour par code quel que soit le nombre d'appelants
+    for (auto& pending : pending_refreshes_) {
+        if (pending.code == code) {
+            pending.callbacks.push_back(std::move(callback));
+            ESP_LOGD(LOG_CYCLE_TAG, "Refresh 0x%02X: joining outstanding request (%d waiting)", code, (int)pending.callbacks.size());
+            return;
+        }
+    }
+
+    PendingRefresh pending{ code, false, CUSTOM_MILLIS, {} };
+    pending.callbacks.push_back(std::move(callback));
+    pending_refreshes_.push_back(std::move(pending));
+    ESP_LOGD(LOG_CYCLE_TAG, "Refresh 0x%02X: queued (data age: %u ms)", code, (unsigned)age);
+}
+
+bool RequestScheduler::service_refreshes() {
+    if (single_shot_code_ != 0x00) {
+        return false;
+    }
+
+    CN105Climate* context = context_callback_ ? context_callback_() : nullptr;
+
+    for (auto& pending : pending_refreshes_) {
+        if (pending.sent) continue;
+
+        InfoRequest* req = find_request(pending.code);
+        if (req == nullptr || req->disabled || (req->canSend && context && !req->canSend(*context))) {
+            resolve_refreshes(pending.code, false);
+            return false;       // la liste a changé, on reprendra au prochain loop
+        }
+
+        pending.sent = true;
+        single_shot_code_ = pending.code;
+        ESP_LOGD(LOG_CYCLE_TAG, "Refresh 0x%02X: sending on-demand request", pending.code);
+        send_request(pending.code, context);
+        return true;
+    }
+    return false;
+}
+
+bool RequestScheduler::has_single_shot_in_flight() const {
+    return single_shot_code_ != 0x00;
+}
+
+void RequestScheduler::resolve_refreshes(uint8_t code, bool fresh) {
+    for (auto it = pending_refreshes_.begin(); it != pending_refreshes_.end(); ++it) {
+        if (it->code != code) continue;
+
+        // sortir les callbacks avant de les appeler: un appelant peut redemander un rafraîchissement
+        std::vector<RefreshCallback> callbacks = std::move(it->callbacks);
+        pending_refreshes_.erase(it);
+        for (auto& callback : callbacks) {
+            if (callback) callback(fresh);
+        }
+        return;
+    }
+}
+
 void RequestScheduler::loop() {
-    // Actuellement, la gestion des timeouts est faite via des callbacks
-    // Cette méthode est prévue pour une gestion future si nécessaire
-    // (par exemple, pour vérifier les timeouts manuellement dans le loop principal)
+    // Les timeouts des requêtes sont gérés via des callbacks; ici on borne l'attente des appelants
+    for (const auto& pending : pending_refreshes_) {
+        if (CUSTOM_MILLIS - pending.since_ms > REFRESH_MAX_WAIT_MS) {
+            ESP_LOGW(LOG_CYCLE_TAG, "Refresh 0x%02X: gave up after %u ms", pending.code, (unsigned)REFRESH_MAX_WAIT_MS);
+            resolve_refreshes(pending.code, false);
+            return;             // itérateurs invalidés, le reste au prochain loop
+        }
+    }
 }
 
@@ -43,6 +43,12 @@ namespace esphome {
          */
         using ContextCallback = std::function<CN105Climate* ()>;
 
+        /**
+         * @brief Type de callback appelé quand une demande de rafraîchissement est résolue
+         * @param fresh true si une réponse a été décodée, false si le délai a expiré
+         */
+        using RefreshCallback = std::function<void(bool)>;
+
         /**
          * @brief Constructeur
          * @param send_callback Callback pour envoyer un paquet
@@ -74,6 +80,12 @@ namespace esphome {
          */
         void disable_request(uint8_t code);
 
+        /**
+         * @brief Restreint le cycle courant aux requêtes marquées burst
+         * @param burst_only true pendant une fenêtre burst (après une commande utilisateur)
+         */
+        void set_burst_only(bool burst_only);
+
         /**
          * @brief Vérifie si la file d'attente est vide
          * @return true si vide, false sinon
@@ -103,15 +115,66 @@ namespace esphome {
         bool process_response(uint8_t code, CN105Climate* context = nullptr);
 
         /**
-         * @brief Méthode à appeler dans le loop principal pour gérer les timeouts
-         * Note: La gestion des timeouts est actuellement gérée via des callbacks,
-         * cette méthode est prévue pour une gestion future si nécessaire.
+         * @brief Âge des dernières données décodées pour un code
+         * @param code Le code de la requête
+         * @return Âge en millisecondes, UINT32_MAX si jamais reçu
+         */
+        uint32_t get_response_age(uint8_t code) const;
+
+        /**
+         * @brief Demande des données de moins de max_age_ms pour un code
+         *
+         * Si les données sont assez fraîches, le callback est appelé immédiatement.
+         * Sinon l'appelant est rattaché à la demande en cours pour ce code (coalescence),
+         * ou une nouvelle demande est mise en attente jusqu'à ce que le bus soit libre.
+         * @param code Le code de la requête
+         * @param max_age_ms Âge maximal accepté
+         * @param callback Appelé avec true à la réception, false à l'expiration
+         */
+        void request_refresh(uint8_t code, uint32_t max_age_ms, RefreshCallback callback);
+
+        /**
+         * @brief Envoie la prochaine demande de rafraîchissement en attente, hors cycle
+         * @return true si une requête a été envoyée
+         */
+        bool service_refreshes();
+
+        /**
+         * @brief Indique si une requête hors cycle attend encore sa réponse
+         */
+        bool has_single_shot_in_flight() const;
+
+        /**
+         * @brief Temps entre la fin d'émission d'une requête et sa réponse décodée
+         * @return Dernière valeur et moyenne glissante (1/8), en millisecondes
+         */
+        uint32_t get_last_rtt_ms() const { return last_rtt_ms_; }
+        uint32_t get_avg_rtt_ms() const { return avg_rtt_ms_; }
+
+        /// requêtes enregistrées, avec leurs compteurs par code
+        const std::vector<InfoRequest>& get_requests() const { return requests_; }
+
+        /**
+         * @brief Méthode à appeler dans le loop principal
+         * Expire les demandes de rafraîchissement restées sans réponse.
          */
         void loop();
 
     private:
+        struct PendingRefresh {
+            uint8_t code;
+            bool sent;
+            uint32_t since_ms;
+            std::vector<RefreshCallback> callbacks;
+        };
+
         std::vector<InfoRequest> requests_;          // File d'attente des requêtes
         int current_request_index_;                  // Index de la requête courante
+        bool burst_only_;                            // Cycle burst: seules les requêtes burst sont envoyées
+        uint8_t single_shot_code_;                   // Requête hors cycle en attente de réponse (0x00 = aucune)
+        uint32_t last_rtt_ms_;                       // Dernier aller-retour mesuré
+        uint32_t avg_rtt_ms_;                        // Moyenne glissante des allers-retours
+        std::vector<PendingRefresh> pending_refreshes_;  // Demandes de rafraîchissement (une par code)
         SendCallback send_callback_;                  // Callback pour envoyer un paquet
         TimeoutCallback timeout_callback_;            // Callback pour gérer les timeouts
         TerminateCallback terminate_callback_;        // Callback pour terminer un cycle
@@ -123,6 +186,13 @@ namespace esphome {
          * @param context Contexte CN105Climate pour vérifier canSend (peut être nullptr)
          */
         void send_request(uint8_t code, CN105Climate* context = nullptr);
+
+        /**
+         * @brief Résout toutes les demandes de rafraîchissement d'un code
+         */
+        void resolve_refreshes(uint8_t code, bool fresh);
+
+        InfoRequest* find_request(uint8_t code);
     };
 
 }
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "cn105_types.h"
+
+namespace esphome {
+
+    /**
+     * Champs portés par un SettingsDelta
+     */
+    enum SettingsDeltaField : uint8_t {
+        DELTA_POWER = 0x01,
+        DELTA_MODE = 0x02,
+        DELTA_TEMPERATURE = 0x04,
+        DELTA_FAN = 0x08,
+        DELTA_VANE = 0x10,
+        DELTA_WIDEVANE = 0x20,
+    };
+
+    /**
+     * @brief Changement de réglage demandé par l'utilisateur (control(), selects de vane)
+     *
+     * Une fois posté, un delta n'est plus modifié: le producteur en construit un nouveau à chaque demande.
+     * Les réglages sont des index dans les tables (MODE_MAP, FAN_MAP...), rien n'est alloué.
+     */
+    struct SettingsDelta {
+        uint8_t fields = 0;
+        uint8_t power = SETTING_UNSET;
+        uint8_t mode = SETTING_UNSET;
+        uint8_t fan = SETTING_UNSET;
+        uint8_t vane = SETTING_UNSET;
+        uint8_t wideVane = SETTING_UNSET;
+        HalfDegrees temperature;
+        uint32_t stampMs = 0;
+
+        bool empty() const { return this->fields == 0; }
+
+        /**
+         * @brief Applique les champs du delta sur les réglages voulus, le plus récent gagne
+         */
+        void applyTo(wantedHeatpumpSettings& wanted) const {
+            if (this->fields & DELTA_POWER) wanted.power = this->power;
+            if (this->fields & DELTA_MODE) wanted.mode = this->mode;
+            if (this->fields & DELTA_TEMPERATURE) wanted.temperature = this->temperature;
+            if (this->fields & DELTA_FAN) wanted.fan = this->fan;
+            if (this->fields & DELTA_VANE) wanted.vane = this->vane;
+            if (this->fields & DELTA_WIDEVANE) wanted.wideVane = this->wideVane;
+            wanted.hasChanged = true;
+            wanted.hasBeenSent = false;
+            wanted.lastChange = this->stampMs;  // the debounce counts from the user's request
+        }
+
+        /**
+         * @brief Vrai si des réglages relus de l'unité portent toutes les valeurs du delta
+         */
+        bool matches(const heatpumpSettings& settings) const {
+            return same(DELTA_POWER, this->power, settings.power) && same(DELTA_MODE, this->mode, settings.mode) &&
+                same(DELTA_FAN, this->fan, settings.fan) && same(DELTA_VANE, this->vane, settings.vane) &&
+                same(DELTA_WIDEVANE, this->wideVane, settings.wideVane) &&
+                (!(this->fields & DELTA_TEMPERATURE) || (settings.temperature == this->temperature));
+        }
+
+        /**
+         * @brief Ajoute les champs d'un autre delta, ceux de l'autre priment
+         */
+        void merge(const SettingsDelta& other) {
+            if (other.fields & DELTA_POWER) this->power = other.power;
+            if (other.fields & DELTA_MODE) this->mode = other.mode;
+            if (other.fields & DELTA_TEMPERATURE) this->temperature = other.temperature;
+            if (other.fields & DELTA_FAN) this->fan = other.fan;
+            if (other.fields & DELTA_VANE) this->vane = other.vane;
+            if (other.fields & DELTA_WIDEVANE) this->wideVane = other.wideVane;
+            this->fields |= other.fields;
+        }
+
+    private:
+        bool same(uint8_t field, uint8_t expected, uint8_t received) const {
+            return !(this->fields & field) || (expected == received);
+        }
+    };
+
+    /**
+     * @class SettingsMailbox
+     * @brief Boîte aux lettres mono-producteur / mono-consommateur de SettingsDelta
+     *
+     * Le producteur (control(), callbacks des selects) poste, loop() dépile et fusionne dans wantedSettings.
+     * Anneau de taille fixe avec deux index atomiques: ni verrou, ni retry, ni allocation.
+     */
+    template<uint8_t CAPACITY>
+    class SettingsMailbox {
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "SettingsMailbox capacity must be a power of two");
+
+    public:
+        /**
+         * @return false si la boîte est pleine (loop() bloqué): le delta est perdu et compté
+         */
+        bool post(const SettingsDelta& delta) {
+            uint8_t head = this->head_.load(std::memory_order_relaxed);
+            uint8_t tail = this->tail_.load(std::memory_order_acquire);
+            if (static_cast<uint8_t>(head - tail) >= CAPACITY) {
+                this->dropped_++;
+                return false;
+            }
+            this->slots_[head & (CAPACITY - 1)] = delta;
+            this->head_.store(static_cast<uint8_t>(head + 1), std::memory_order_release);
+            return true;
+        }
+
+        bool take(SettingsDelta& delta) {
+            uint8_t tail = this->tail_.load(std::memory_order_relaxed);
+            if (tail == this->head_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            delta = this->slots_[tail & (CAPACITY - 1)];
+            this->tail_.store(static_cast<uint8_t>(tail + 1), std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const {
+            return this->tail_.load(std::memory_order_acquire) == this->head_.load(std::memory_order_acquire);
+        }
+
+        uint32_t get_dropped() const { return this->dropped_; }
+
+    private:
+        SettingsDelta slots_[CAPACITY];
+        std::atomic<uint8_t> head_{ 0 };
+        std::atomic<uint8_t> tail_{ 0 };
+        uint32_t dropped_ = 0;
+    };
+
+}
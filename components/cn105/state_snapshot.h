@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "cn105_types.h"
+
+namespace esphome {
+
+    /**
+     * Champs horodatés d'un StateSnapshot
+     */
+    enum SnapshotField : uint8_t {
+        SNAPSHOT_POWER = 0,
+        SNAPSHOT_MODE,
+        SNAPSHOT_TARGET_TEMPERATURE,
+        SNAPSHOT_FAN,
+        SNAPSHOT_VANE,
+        SNAPSHOT_WIDEVANE,
+        SNAPSHOT_ISEE,
+        SNAPSHOT_STAGE,
+        SNAPSHOT_SUB_MODE,
+        SNAPSHOT_AUTO_SUB_MODE,
+        SNAPSHOT_ROOM_TEMPERATURE,
+        SNAPSHOT_OUTSIDE_TEMPERATURE,
+        SNAPSHOT_RUNTIME_HOURS,
+        SNAPSHOT_OPERATING,
+        SNAPSHOT_COMPRESSOR_FREQUENCY,
+        SNAPSHOT_INPUT_POWER,
+        SNAPSHOT_KWH,
+        SNAPSHOT_AIR_PURIFIER,
+        SNAPSHOT_NIGHT_MODE,
+        SNAPSHOT_CIRCULATOR,
+        SNAPSHOT_AIRFLOW_CONTROL,
+        SNAPSHOT_FIELD_COUNT
+    };
+
+    /**
+     * @brief État de l'unité tel que décodé, copié d'un bloc pour les lambdas et les autres composants
+     *
+     * Chaque champ garde l'heure (millis) de la dernière trame qui l'a apporté, même si sa valeur n'a pas changé.
+     * Les réglages sont ceux relus de l'unité, pas ceux demandés et en attente d'écriture.
+     */
+    struct StateSnapshot {
+        uint32_t version = 0;                       // incrémenté à chaque trame décodée
+        heatpumpSettings settings{};
+        heatpumpStatus status{ HalfDegrees(), HalfDegrees(), false, {TIMER_MODE_MAP[0], 0, 0, 0, 0}, NAN, NAN, NAN, NAN };
+        heatpumpRunStates runStates{ -1, -1, -1, SETTING_UNSET };
+        uint32_t received = 0;                      // bit (1 << SnapshotField) si le champ a déjà été reçu
+        uint32_t stampMs[SNAPSHOT_FIELD_COUNT] = {};
+
+        bool has(SnapshotField field) const { return (this->received & (1UL << field)) != 0; }
+        uint32_t stamp(SnapshotField field) const { return this->stampMs[field]; }
+        // UINT32_MAX si le champ n'a jamais été reçu
+        uint32_t age(SnapshotField field, uint32_t now) const {
+            return this->has(field) ? now - this->stampMs[field] : UINT32_MAX;
+        }
+
+        void touch(SnapshotField field, uint32_t now) {
+            this->received |= (1UL << field);
+            this->stampMs[field] = now;
+        }
+    };
+    static_assert(SNAPSHOT_FIELD_COUNT <= 32, "StateSnapshot::received is a 32 bits mask");
+
+    /**
+     * @class SeqLock
+     * @brief Un écrivain, lecteurs sans verrou
+     *
+     * La séquence est impaire pendant une écriture. Un lecteur copie la valeur et garde la copie si la séquence
+     * n'a pas bougé entre le début et la fin; sinon il recommence, au plus SEQLOCK_READ_ATTEMPTS fois.
+     * Aujourd'hui le décodage et les lambdas tournent tous deux dans loop(): la première lecture réussit toujours.
+     * Si le décodage passe un jour dans une autre tâche, un écrivain préempté au milieu d'une écriture ne peut
+     * plus bloquer un lecteur: read() échoue au lieu de boucler.
+     */
+    template<typename T>
+    class SeqLock {
+    public:
+        template<typename F>
+        void write(F&& mutate) {
+            uint32_t seq = this->seq_.load(std::memory_order_relaxed);
+            this->seq_.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            mutate(this->value_);
+            this->seq_.store(seq + 2, std::memory_order_release);
+        }
+
+        /**
+         * @brief Une seule tentative, ne bloque jamais
+         * @return false si une écriture était en cours: out n'est pas modifié
+         */
+        bool try_read(T& out) const {
+            uint32_t before = this->seq_.load(std::memory_order_acquire);
+            if (before & 1) {
+                return false;
+            }
+            T copy = this->value_;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (this->seq_.load(std::memory_order_relaxed) != before) {
+                return false;
+            }
+            out = copy;
+            return true;
+        }
+
+        /**
+         * @brief Tentatives bornées, copie directe dans out (pas de copie intermédiaire sur la pile)
+         * @return false si aucune copie cohérente après `attempts` essais: out est alors indéterminé
+         */
+        bool read(T& out, uint8_t attempts = SEQLOCK_READ_ATTEMPTS) const {
+            for (uint8_t i = 0; i < attempts; i++) {
+                uint32_t before = this->seq_.load(std::memory_order_acquire);
+                if (before & 1) {
+                    continue;
+                }
+                out = this->value_;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (this->seq_.load(std::memory_order_relaxed) == before) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        std::atomic<uint32_t> seq_{ 0 };
+        T value_{};
+    };
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace esphome {
+
+    /**
+     * @class HalfDegrees
+     * @brief Température en demi-degrés Celsius, la résolution du protocole CN105
+     *
+     * C'est le type interne de toutes les consignes et températures ambiantes: les octets reçus et envoyés
+     * se convertissent par entiers ou par tables, le float n'apparaît qu'à la frontière ESPHome
+     * (climate, sensors, logs). Une valeur non définie remplace les anciens -1 / -100 / NAN.
+     */
+    class HalfDegrees {
+    public:
+        constexpr HalfDegrees() : halves_(UNSET) {}
+
+        static constexpr HalfDegrees from_halves(int halves) { return HalfDegrees(static_cast<int16_t>(halves)); }
+        static constexpr HalfDegrees from_degrees(int degrees) { return HalfDegrees(static_cast<int16_t>(degrees * 2)); }
+        // octet "demi-degrés + 128" des paquets 0x02, 0x03 et 0x07
+        static constexpr HalfDegrees from_half_byte(uint8_t value) { return from_halves(static_cast<int>(value) - 128); }
+        // arrondi au demi-degré le plus proche, NAN donne une valeur non définie
+        static HalfDegrees from_celsius(float celsius) {
+            return std::isnan(celsius) ? HalfDegrees() : from_halves(static_cast<int>(lroundf(celsius * 2.0f)));
+        }
+
+        constexpr bool is_set() const { return this->halves_ != UNSET; }
+        constexpr int16_t halves() const { return this->halves_; }
+        constexpr uint8_t half_byte() const { return static_cast<uint8_t>(this->halves_ + 128); }
+        constexpr float celsius() const { return this->is_set() ? this->halves_ * 0.5f : NAN; }
+
+        // degré entier le plus proche, demi-degré arrondi vers le haut
+        constexpr HalfDegrees rounded_to_degree() const {
+            return this->is_set() ? from_halves(((this->halves_ + 1) >> 1) * 2) : HalfDegrees();
+        }
+        constexpr HalfDegrees clamped(HalfDegrees low, HalfDegrees high) const {
+            return !this->is_set() ? *this : (*this < low ? low : (high < *this ? high : *this));
+        }
+        // milieu de [a, b] au demi-degré, arrondi vers le haut comme la consigne unique calculée en AUTO
+        static constexpr HalfDegrees midpoint(HalfDegrees a, HalfDegrees b) {
+            return (a.is_set() && b.is_set()) ? from_halves((a.halves_ + b.halves_ + 1) >> 1) : HalfDegrees();
+        }
+
+        // comme NAN, une opérande non définie rend le résultat non défini
+        constexpr HalfDegrees operator+(HalfDegrees other) const {
+            return (this->is_set() && other.is_set()) ? from_halves(this->halves_ + other.halves_) : HalfDegrees();
+        }
+        constexpr HalfDegrees operator-(HalfDegrees other) const {
+            return (this->is_set() && other.is_set()) ? from_halves(this->halves_ - other.halves_) : HalfDegrees();
+        }
+
+        constexpr bool operator==(HalfDegrees other) const { return this->halves_ == other.halves_; }
+        constexpr bool operator!=(HalfDegrees other) const { return this->halves_ != other.halves_; }
+        // comparaisons d'ordre fausses si une opérande n'est pas définie, comme avec NAN
+        constexpr bool operator<(HalfDegrees other) const { return this->is_set() && other.is_set() && this->halves_ < other.halves_; }
+        constexpr bool operator>(HalfDegrees other) const { return other < *this; }
+        constexpr bool operator<=(HalfDegrees other) const { return this->is_set() && other.is_set() && this->halves_ <= other.halves_; }
+        constexpr bool operator>=(HalfDegrees other) const { return other <= *this; }
+
+    private:
+        static constexpr int16_t UNSET = INT16_MIN;
+
+        constexpr explicit HalfDegrees(int16_t halves) : halves_(halves) {}
+
+        int16_t halves_;
+    };
+
+    /**
+     * Codes "legacy" (tempMode false): consigne 0x00 = 31°C ... 0x0F = 16°C, ambiante 0x00 = 10°C ... 0x1F = 41°C
+     * Les deux sont linéaires: décodés par calcul, sans table; code hors plage = non défini
+     */
+    namespace temperature_codec {
+        constexpr HalfDegrees decode_setpoint_code(uint8_t code) {
+            return code < 16 ? HalfDegrees::from_degrees(31 - code) : HalfDegrees();
+        }
+        constexpr HalfDegrees decode_room_code(uint8_t code) {
+            return code < 32 ? HalfDegrees::from_degrees(10 + code) : HalfDegrees();
+        }
+        // 0xFF si la consigne n'est pas un degré entier entre 16 et 31°C
+        constexpr uint8_t encode_setpoint_code(HalfDegrees setpoint) {
+            return (setpoint.is_set() && (setpoint.halves() & 1) == 0 && setpoint >= HalfDegrees::from_degrees(16) &&
+                setpoint <= HalfDegrees::from_degrees(31)) ? static_cast<uint8_t>(31 - setpoint.halves() / 2) : 0xFF;
+        }
+
+        static_assert(decode_setpoint_code(0x0F) == HalfDegrees::from_degrees(16), "legacy setpoint table");
+        static_assert(decode_room_code(0x1F) == HalfDegrees::from_degrees(41), "legacy room temperature table");
+        static_assert(encode_setpoint_code(HalfDegrees::from_degrees(22)) == 0x09, "legacy setpoint encoding");
+        static_assert(!decode_setpoint_code(0x10).is_set(), "legacy setpoint table bound");
+        static_assert(!decode_room_code(0x20).is_set(), "legacy room temperature table bound");
+    }
+
+}
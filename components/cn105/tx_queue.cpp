@@ -0,0 +1,127 @@
+#include "tx_queue.h"
+#include "packet_encoder.h"
+#include "Globals.h"
+
+using namespace esphome;
+
+// champs à drapeaux des écritures 0x41, par type (voir packet_encoder.h)
+struct FlaggedField {
+    uint8_t type;
+    const PacketField& field;
+};
+
+static const FlaggedField FLAGGED_FIELDS[] = {
+    { 0x01, FIELD_POWER },
+    { 0x01, FIELD_MODE },
+    { 0x01, FIELD_TEMPERATURE },
+    { 0x01, FIELD_TEMPERATURE_HALF },
+    { 0x01, FIELD_FAN },
+    { 0x01, FIELD_VANE },
+    { 0x01, FIELD_WIDEVANE },
+    { 0x08, FIELD_AIRFLOW_CONTROL },
+    { 0x08, FIELD_AIR_PURIFIER },
+    { 0x08, FIELD_NIGHT_MODE },
+    { 0x08, FIELD_CIRCULATOR },
+};
+
+// merge_into() keys on these masks: a wrong one merges the data byte under a flag the unit ignores
+// (run states flags of the original sendWantedRunStates: RUN_STATE_PACKET_1[4], RUN_STATE_PACKET_2[1..3])
+static_assert(FIELD_AIRFLOW_CONTROL.flag_byte == 6 && FIELD_AIRFLOW_CONTROL.flag_mask == 0x20, "airflow control flag");
+static_assert(FIELD_AIR_PURIFIER.flag_byte == 7 && FIELD_AIR_PURIFIER.flag_mask == 0x04, "air purifier flag");
+static_assert(FIELD_NIGHT_MODE.flag_byte == 7 && FIELD_NIGHT_MODE.flag_mask == 0x08, "night mode flag");
+static_assert(FIELD_CIRCULATOR.flag_byte == 7 && FIELD_CIRCULATOR.flag_mask == 0x10, "circulator flag");
+
+TxPriority TxQueue::priority_of(const uint8_t* packet, int length) {
+    if (length >= 6 && packet[1] == 0x41) {
+        return packet[5] == 0x07 ? TX_PRIORITY_REMOTE_TEMP : TX_PRIORITY_USER;
+    }
+    return TX_PRIORITY_INFO;
+}
+
+void TxQueue::merge_into(Entry& older, const uint8_t* newer) {
+    uint8_t merged[PACKET_LEN];
+    memcpy(merged, newer, PACKET_LEN);
+
+    // the temperature flag covers two data bytes (table and half degrees): a field is kept from the older
+    // packet when its flag is set there and not in the newer one
+    for (const auto& f : FLAGGED_FIELDS) {
+        if (f.type != newer[5]) continue;
+        bool older_has = (older.packet[f.field.flag_byte] & f.field.flag_mask) != 0;
+        bool newer_has = (newer[f.field.flag_byte] & f.field.flag_mask) != 0;
+        if (older_has && !newer_has) {
+            merged[f.field.flag_byte] |= f.field.flag_mask;
+            merged[f.field.data_byte] = older.packet[f.field.data_byte];
+        }
+    }
+
+    uint8_t sum = 0;
+    for (int i = 0; i < PACKET_CHECKSUM_INDEX; i++) {
+        sum += merged[i];
+    }
+    merged[PACKET_CHECKSUM_INDEX] = packet_checksum_from_sum(sum);
+    memcpy(older.packet, merged, PACKET_LEN);
+}
+
+bool TxQueue::push(const uint8_t* packet, int length) {
+    if (length <= 0 || length > PACKET_LEN) {
+        ESP_LOGE(TAG, "Packet length %d exceeds PACKET_LEN %d, dropping.", length, PACKET_LEN);
+        return false;
+    }
+    uint16_t key = static_cast<uint16_t>((packet[1] << 8) | (length > 5 ? packet[5] : 0));
+
+    for (auto& e : this->entries_) {
+        if (e.key == key && e.length == length) {
+            if (length == PACKET_LEN) {
+                merge_into(e, packet);
+            } else {
+                memcpy(e.packet, packet, static_cast<size_t>(length));
+            }
+            this->merged_++;
+            ESP_LOGD(TAG, "TX queue: 0x%02X/0x%02X superseded an unsent one", packet[1], packet[5]);
+            return true;
+        }
+    }
+
+    Entry entry{};
+    memcpy(entry.packet, packet, static_cast<size_t>(length));
+    entry.length = static_cast<uint8_t>(length);
+    entry.priority = priority_of(packet, length);
+    entry.key = key;
+    entry.seq = this->next_seq_++;
+
+    if (this->entries_.size() >= TX_QUEUE_MAX_ENTRIES) {
+        // make room by dropping the least important, oldest entry, unless the new one is even less important
+        auto victim = this->entries_.begin();
+        for (auto it = this->entries_.begin(); it != this->entries_.end(); ++it) {
+            if (it->priority > victim->priority) victim = it;
+        }
+        this->dropped_++;
+        if (victim->priority < entry.priority) {
+            ESP_LOGW(TAG, "TX queue full, dropping new 0x%02X/0x%02X", packet[1], packet[5]);
+            return false;
+        }
+        ESP_LOGW(TAG, "TX queue full, dropping queued 0x%02X/0x%02X", victim->packet[1], victim->packet[5]);
+        this->entries_.erase(victim);
+    }
+
+    this->entries_.push_back(entry);
+    return true;
+}
+
+const TxQueue::Entry* TxQueue::front() const {
+    const Entry* best = nullptr;
+    for (const auto& e : this->entries_) {
+        if (best == nullptr || e.priority < best->priority || (e.priority == best->priority && e.seq < best->seq)) {
+            best = &e;
+        }
+    }
+    return best;
+}
+
+bool TxQueue::pop(Entry& out) {
+    const Entry* best = this->front();
+    if (best == nullptr) return false;
+    out = *best;
+    this->entries_.erase(this->entries_.begin() + (best - this->entries_.data()));
+    return true;
+}
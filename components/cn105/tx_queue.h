@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "cn105_types.h"
+
+namespace esphome {
+
+    /**
+     * @brief Priorité d'envoi: une valeur plus petite passe avant
+     */
+    enum TxPriority : uint8_t {
+        TX_PRIORITY_USER = 0,           // settings 0x01, run states 0x08, functions 0x1F/0x21
+        TX_PRIORITY_REMOTE_TEMP = 1,    // remote temperature 0x07
+        TX_PRIORITY_INFO = 2,           // anything else; writePacket() only queues 0x41 frames
+    };
+
+    /**
+     * @class TxQueue
+     * @brief File d'envoi bornée, ordonnée par priorité puis par ordre d'arrivée.
+     *
+     * Un paquet du même type qu'un paquet pas encore envoyé le remplace au lieu de s'ajouter.
+     * Pour les écritures à drapeaux (0x01 settings, 0x08 run states), les champs de l'ancien paquet
+     * que le nouveau ne touche pas sont conservés: aucun changement utilisateur n'est perdu.
+     */
+    class TxQueue {
+    public:
+        struct Entry {
+            uint8_t packet[PACKET_LEN];
+            uint8_t length;
+            TxPriority priority;
+            uint16_t key;               // commande << 8 | type, clé de dédoublonnage
+            uint32_t seq;
+        };
+
+        static TxPriority priority_of(const uint8_t* packet, int length);
+
+        /**
+         * @brief Ajoute ou fusionne un paquet
+         * @return false si le paquet a été refusé (file pleine de paquets plus prioritaires)
+         */
+        bool push(const uint8_t* packet, int length);
+
+        /// prochain paquet à envoyer, nullptr si la file est vide
+        const Entry* front() const;
+
+        /// retire le prochain paquet à envoyer
+        bool pop(Entry& out);
+
+        bool empty() const { return entries_.empty(); }
+        size_t size() const { return entries_.size(); }
+        void clear() { entries_.clear(); }
+
+        uint32_t get_merged() const { return merged_; }
+        uint32_t get_dropped() const { return dropped_; }
+
+    private:
+        std::vector<Entry> entries_;
+        uint32_t next_seq_ = 0;
+        uint32_t merged_ = 0;
+        uint32_t dropped_ = 0;
+
+        static void merge_into(Entry& older, const uint8_t* newer);
+    };
+
+}
@@ -31,6 +31,18 @@ bool CN105Climate::hasChanged(const char* before, const char* now, const char* f
     return ((before == NULL) || (strcmp(before, now) != 0));
 }
 
+bool CN105Climate::hasChanged(uint8_t before, uint8_t now, const char* field, bool checkNotNull) {
+    if (now == SETTING_UNSET) {
+        if (checkNotNull) {
+            ESP_LOGE(TAG, "CAUTION: expected value in hasChanged() function for %s, got none", field);
+        } else {
+            ESP_LOGD(TAG, "No value in hasChanged() function for %s", field);
+        }
+        return false;
+    }
+    return ((before == SETTING_UNSET) || (before != now));
+}
+
 
 const char* CN105Climate::getIfNotNull(const char* what, const char* defaultValue) {
     if (what == NULL) {
@@ -43,12 +55,12 @@ const char* CN105Climate::getIfNotNull(const char* what, const char* defaultValu
  * This function calculates the temperature setting based on the mode and the temperature points.
  * It returns the temperature setting.
  */
-float CN105Climate::calculateTemperatureSetting(float setting) {
+HalfDegrees CN105Climate::calculateTemperatureSetting(HalfDegrees setting) {
     if (!this->tempMode) {
-        return this->lookupByteMapIndex(TEMP_MAP, 16, (int)(setting + 0.5)) > -1 ? setting : TEMP_MAP[0];
+        // legacy codes only carry whole degrees between 16 and 31
+        return setting.rounded_to_degree().clamped(HalfDegrees::from_degrees(16), HalfDegrees::from_degrees(31));
     } else {
-        setting = std::round(2.0f * setting) / 2.0f;  // Round to the nearest half-degree.
-        return setting < 10 ? 10 : (setting > 31 ? 31 : setting);
+        return setting.clamped(HalfDegrees::from_degrees(10), HalfDegrees::from_degrees(31));
     }
 }
 
@@ -58,46 +70,47 @@ float CN105Climate::calculateTemperatureSetting(float setting) {
  * It returns the temperature setting.
  */
 
-void CN105Climate::updateTargetTemperaturesFromSettings(float temperature) {
-    if (this->traits().get_supports_two_point_target_temperature()) {
+void CN105Climate::updateTargetTemperaturesFromSettings(HalfDegrees temperature) {
+    if (this->hasCapability(CAP_DUAL_SETPOINT)) {
 
         if (this->mode == climate::CLIMATE_MODE_HEAT) {
             this->setTargetTemperatureLow(temperature);
-            if (std::isnan(this->getTargetTemperatureHigh())) {
+            if (!this->getTargetTemperatureHigh().is_set()) {
                 this->setTargetTemperatureHigh(temperature);
             }
         } else if (this->mode == climate::CLIMATE_MODE_COOL) {
             this->setTargetTemperatureHigh(temperature);
-            if (std::isnan(this->getTargetTemperatureLow())) {
+            if (!this->getTargetTemperatureLow().is_set()) {
                 this->setTargetTemperatureLow(temperature);
             }
         } else if (this->mode == climate::CLIMATE_MODE_DRY) {
             this->setTargetTemperatureHigh(temperature);
-            if (std::isnan(this->getTargetTemperatureLow())) {
+            if (!this->getTargetTemperatureLow().is_set()) {
                 this->setTargetTemperatureLow(temperature);
             }
         } else if (this->mode == climate::CLIMATE_MODE_AUTO) {
             // En AUTO: si les deux bornes existent déjà, ne pas recentrer
-            bool lowDefined = !std::isnan(this->getTargetTemperatureLow());
-            bool highDefined = !std::isnan(this->getTargetTemperatureHigh());
+            const HalfDegrees halfSpan = HalfDegrees::from_degrees(2);
+            bool lowDefined = this->getTargetTemperatureLow().is_set();
+            bool highDefined = this->getTargetTemperatureHigh().is_set();
 
             if (lowDefined && highDefined) {
                 ESP_LOGD(LOG_SETTINGS_TAG, "AUTO keep dual setpoints [%.1f - %.1f], median %.1f",
-                    this->getTargetTemperatureLow(), this->getTargetTemperatureHigh(), temperature);
+                    this->getTargetTemperatureLow().celsius(), this->getTargetTemperatureHigh().celsius(), temperature.celsius());
             } else if (lowDefined && !highDefined) {
-                this->setTargetTemperatureHigh(this->getTargetTemperatureLow() + 2.0f);
+                this->setTargetTemperatureHigh(this->getTargetTemperatureLow() + halfSpan);
                 ESP_LOGD(LOG_SETTINGS_TAG, "AUTO fill missing high: [%.1f - %.1f]",
-                    this->getTargetTemperatureLow(), this->getTargetTemperatureHigh());
+                    this->getTargetTemperatureLow().celsius(), this->getTargetTemperatureHigh().celsius());
             } else if (!lowDefined && highDefined) {
-                this->setTargetTemperatureLow(this->getTargetTemperatureHigh() - 2.0f);
+                this->setTargetTemperatureLow(this->getTargetTemperatureHigh() - halfSpan);
                 ESP_LOGD(LOG_SETTINGS_TAG, "AUTO fill missing low: [%.1f - %.1f]",
-                    this->getTargetTemperatureLow(), this->getTargetTemperatureHigh());
+                    this->getTargetTemperatureLow().celsius(), this->getTargetTemperatureHigh().celsius());
             } else {
                 // aucune borne connue: initialiser autour de la médiane fournie
-                this->setTargetTemperatureLow(temperature - 2.0f);
-                this->setTargetTemperatureHigh(temperature + 2.0f);
+                this->setTargetTemperatureLow(temperature - halfSpan);
+                this->setTargetTemperatureHigh(temperature + halfSpan);
                 ESP_LOGD(LOG_SETTINGS_TAG, "AUTO init dual setpoints [%.1f - %.1f], median %.1f",
-                    this->getTargetTemperatureLow(), this->getTargetTemperatureHigh(), temperature);
+                    this->getTargetTemperatureLow().celsius(), this->getTargetTemperatureHigh().celsius(), temperature.celsius());
             }
 
             // Mémoriser dans currentSettings pour détection de glissement ultérieur
@@ -105,17 +118,18 @@ void CN105Climate::updateTargetTemperaturesFromSettings(float temperature) {
             this->currentSettings.dual_high_target = this->getTargetTemperatureHigh();
         } else {
 
-            if (std::isnan(this->getTargetTemperatureLow())) {
+            if (!this->getTargetTemperatureLow().is_set()) {
                 this->setTargetTemperatureLow(temperature);
             }
-            if (std::isnan(this->getTargetTemperatureHigh())) {
+            if (!this->getTargetTemperatureHigh().is_set()) {
                 this->setTargetTemperatureHigh(temperature);
             }
 
-            float theoricalSetPoint = this->calculateTemperatureSetting((this->getTargetTemperatureLow() + this->getTargetTemperatureHigh()) / 2.0f);
+            HalfDegrees theoricalSetPoint = this->calculateTemperatureSetting(
+                HalfDegrees::midpoint(this->getTargetTemperatureLow(), this->getTargetTemperatureHigh()));
 
             if (theoricalSetPoint != temperature) {
-                float delta = (this->getTargetTemperatureHigh() - this->getTargetTemperatureLow()) / 2.0f;
+                HalfDegrees delta = HalfDegrees::from_halves((this->getTargetTemperatureHigh() - this->getTargetTemperatureLow()).halves() / 2);
                 this->setTargetTemperatureLow(theoricalSetPoint - delta);
                 this->setTargetTemperatureHigh(theoricalSetPoint + delta);
             }
@@ -123,7 +137,7 @@ void CN105Climate::updateTargetTemperaturesFromSettings(float temperature) {
         }
     } else {
         ESP_LOGD(LOG_SETTINGS_TAG, "SINGLE SETPOINT %.1f",
-            temperature);
+            temperature.celsius());
         this->setTargetTemperature(temperature);
     }
 }
@@ -132,32 +146,32 @@ void CN105Climate::debugSettings(const char* settingName, wantedHeatpumpSettings
 #ifdef USE_ESP32
     ESP_LOGD(LOG_ACTION_EVT_TAG, "[%s]-> [power: %s, target °C: %.1f, mode: %s, fan: %s, vane: %s, wvane: %s, hasChanged ? -> %s, hasBeenSent ? -> %s]",
         getIfNotNull(settingName, "unnamed"),
-        getIfNotNull(settings.power, "-"),
-        settings.temperature,
-        getIfNotNull(settings.mode, "-"),
-        getIfNotNull(settings.fan, "-"),
-        getIfNotNull(settings.vane, "-"),
-        getIfNotNull(settings.wideVane, "-"),
+        settingLabel(POWER_MAP, settings.power, "-"),
+        settings.temperature.celsius(),
+        settingLabel(MODE_MAP, settings.mode, "-"),
+        settingLabel(FAN_MAP, settings.fan, "-"),
+        settingLabel(VANE_MAP, settings.vane, "-"),
+        settingLabel(WIDEVANE_MAP, settings.wideVane, "-"),
         settings.hasChanged ? "YES" : " NO",
         settings.hasBeenSent ? "YES" : " NO"
     );
 #else
     ESP_LOGD(LOG_ACTION_EVT_TAG, "[%-*s]-> [power: %-*s, target °C: %.1f, mode: %-*s, fan: %-*s, vane: %-*s, wvane: %-*s, hasChanged ? -> %s, hasBeenSent ? -> %s]",
         15, getIfNotNull(settingName, "unnamed"),
-        3, getIfNotNull(settings.power, "-"),
-        settings.temperature,
-        6, getIfNotNull(settings.mode, "-"),
-        6, getIfNotNull(settings.fan, "-"),
-        6, getIfNotNull(settings.vane, "-"),
-        6, getIfNotNull(settings.wideVane, "-"),
+        3, settingLabel(POWER_MAP, settings.power, "-"),
+        settings.temperature.celsius(),
+        6, settingLabel(MODE_MAP, settings.mode, "-"),
+        6, settingLabel(FAN_MAP, settings.fan, "-"),
+        6, settingLabel(VANE_MAP, settings.vane, "-"),
+        6, settingLabel(WIDEVANE_MAP, settings.wideVane, "-"),
         settings.hasChanged ? "YES" : " NO",
         settings.hasBeenSent ? "YES" : " NO"
     );
 #endif
 }
 
-float CN105Climate::getTargetTemperatureInCurrentMode() {
-    if (this->traits_.get_supports_two_point_target_temperature()) {
+HalfDegrees CN105Climate::getTargetTemperatureInCurrentMode() {
+    if (this->hasCapability(CAP_DUAL_SETPOINT)) {
         if (this->mode == climate::CLIMATE_MODE_HEAT) {
             return this->getTargetTemperatureLow();
         } else if (this->mode == climate::CLIMATE_MODE_COOL) {
@@ -165,67 +179,67 @@ float CN105Climate::getTargetTemperatureInCurrentMode() {
         } else if (this->mode == climate::CLIMATE_MODE_DRY) {
             return this->getTargetTemperatureHigh();
         } else {
-            return (this->getTargetTemperatureLow() + this->getTargetTemperatureHigh()) / 2.0f;
+            return HalfDegrees::midpoint(this->getTargetTemperatureLow(), this->getTargetTemperatureHigh());
         }
     } else {
         return this->getTargetTemperature();
     }
 }
 
-float CN105Climate::getTargetTemperature() {
+HalfDegrees CN105Climate::getTargetTemperature() {
     return this->fahrenheitSupport_.normalizeUiTemperatureToHeatpumpTemperature(this->target_temperature);
 }
 
-float CN105Climate::getTargetTemperatureLow() {
+HalfDegrees CN105Climate::getTargetTemperatureLow() {
     return this->fahrenheitSupport_.normalizeUiTemperatureToHeatpumpTemperature(this->target_temperature_low);
 }
 
-float CN105Climate::getTargetTemperatureHigh() {
+HalfDegrees CN105Climate::getTargetTemperatureHigh() {
     return this->fahrenheitSupport_.normalizeUiTemperatureToHeatpumpTemperature(this->target_temperature_high);
 }
 
-float CN105Climate::getCurrentTemperature() {
+HalfDegrees CN105Climate::getCurrentTemperature() {
     return this->fahrenheitSupport_.normalizeUiTemperatureToHeatpumpTemperature(this->current_temperature);
 }
 
-void CN105Climate::setTargetTemperature(float temperature) {
+void CN105Climate::setTargetTemperature(HalfDegrees temperature) {
     this->target_temperature = this->fahrenheitSupport_.normalizeHeatpumpTemperatureToUiTemperature(temperature);
 }
 
-void CN105Climate::setTargetTemperatureLow(float temperature) {
+void CN105Climate::setTargetTemperatureLow(HalfDegrees temperature) {
     this->target_temperature_low = this->fahrenheitSupport_.normalizeHeatpumpTemperatureToUiTemperature(temperature);
 }
 
-void CN105Climate::setTargetTemperatureHigh(float temperature) {
+void CN105Climate::setTargetTemperatureHigh(HalfDegrees temperature) {
     this->target_temperature_high = this->fahrenheitSupport_.normalizeHeatpumpTemperatureToUiTemperature(temperature);
 }
 
-void CN105Climate::setCurrentTemperature(float temperature) {
+void CN105Climate::setCurrentTemperature(HalfDegrees temperature) {
     this->current_temperature = this->fahrenheitSupport_.normalizeHeatpumpTemperatureToUiTemperature(temperature);
 }
 
 void CN105Climate::sanitizeDualSetpoints() {
-    if (!this->traits_.get_supports_two_point_target_temperature()) {
+    if (!this->hasCapability(CAP_DUAL_SETPOINT)) {
         return;
     }
     ESP_LOGD(LOG_DUAL_SP_TAG, "sanitizing dual setpoints...");
     // Si une borne est NaN, la reconstruire à partir de l'autre borne ou d'une valeur raisonnable
-    bool lowIsNaN = std::isnan(this->getTargetTemperatureLow());
-    bool highIsNaN = std::isnan(this->getTargetTemperatureHigh());
+    bool lowIsNaN = !this->getTargetTemperatureLow().is_set();
+    bool highIsNaN = !this->getTargetTemperatureHigh().is_set();
 
     if (lowIsNaN && highIsNaN) {
         // Rien à faire si on n'a aucune info; essayer currentSettings.temperature si valide
-        if (!std::isnan(this->currentSettings.temperature) && this->currentSettings.temperature > 0) {
-            this->setTargetTemperatureLow(this->currentSettings.temperature - 2.0f);
-            this->setTargetTemperatureHigh(this->currentSettings.temperature + 2.0f);
+        if (this->currentSettings.temperature > HalfDegrees::from_halves(0)) {
+            this->setTargetTemperatureLow(this->currentSettings.temperature - HalfDegrees::from_degrees(2));
+            this->setTargetTemperatureHigh(this->currentSettings.temperature + HalfDegrees::from_degrees(2));
         } else {
             ESP_LOGD(LOG_DUAL_SP_TAG, "No known temperature, using default values 18.0f - 22.0f");
-            this->setTargetTemperatureLow(18.0f);
-            this->setTargetTemperatureHigh(22.0f);
+            this->setTargetTemperatureLow(HalfDegrees::from_degrees(18));
+            this->setTargetTemperatureHigh(HalfDegrees::from_degrees(22));
         }
 
         ESP_LOGD(LOG_DUAL_SP_TAG, "AUTO sanitized dual setpoints [%.1f - %.1f]",
-            this->getTargetTemperatureLow(), this->getTargetTemperatureHigh());
+            this->getTargetTemperatureLow().celsius(), this->getTargetTemperatureHigh().celsius());
 
         return;
     }
@@ -233,25 +247,25 @@ void CN105Climate::sanitizeDualSetpoints() {
     if (lowIsNaN && !highIsNaN) {
         // Reconstruire low à partir de high
         this->setTargetTemperatureLow((this->mode == climate::CLIMATE_MODE_AUTO)
-            ? (this->getTargetTemperatureHigh() - 4.0f)
+            ? (this->getTargetTemperatureHigh() - HalfDegrees::from_degrees(4))
             : this->getTargetTemperatureHigh()); // en HEAT/COOL, une seule consigne peut suffire
     } else if (!lowIsNaN && highIsNaN) {
         // Reconstruire high à partir de low
         this->setTargetTemperatureHigh((this->mode == climate::CLIMATE_MODE_AUTO)
-            ? (this->getTargetTemperatureLow() + 4.0f)
+            ? (this->getTargetTemperatureLow() + HalfDegrees::from_degrees(4))
             : this->getTargetTemperatureLow());
     }
 
 
     ESP_LOGD(LOG_DUAL_SP_TAG, "AUTO sanitized dual setpoints [%.1f - %.1f]",
-        this->getTargetTemperatureLow(), this->getTargetTemperatureHigh());
+        this->getTargetTemperatureLow().celsius(), this->getTargetTemperatureHigh().celsius());
 }
 
 void CN105Climate::debugClimate(const char* settingName) {
     ESP_LOGD(LOG_SETTINGS_TAG, "[%s]-> [mode: %s, target °C: %.1f, fan: %s, swing: %s]",
         settingName,
         LOG_STR_ARG(climate_mode_to_string(this->mode)), // Utilisation de LOG_STR_ARG
-        this->getTargetTemperatureInCurrentMode(),
+        this->getTargetTemperatureInCurrentMode().celsius(),
         this->fan_mode.has_value() ? LOG_STR_ARG(climate_fan_mode_to_string(this->fan_mode.value())) : "-",
         LOG_STR_ARG(climate_swing_mode_to_string(this->swing_mode)));
 }
@@ -266,22 +280,22 @@ void CN105Climate::debugSettings(const char* settingName, heatpumpSettings& sett
 #ifdef USE_ESP32
     ESP_LOGD(LOG_SETTINGS_TAG, "[%s]-> [power: %s, target °C: %.1f, mode: %s, fan: %s, vane: %s, wvane: %s]",
         getIfNotNull(settingName, "unnamed"),
-        getIfNotNull(settings.power, "-"),
-        settings.temperature,
-        getIfNotNull(settings.mode, "-"),
-        getIfNotNull(settings.fan, "-"),
-        getIfNotNull(settings.vane, "-"),
-        getIfNotNull(settings.wideVane, "-")
+        settingLabel(POWER_MAP, settings.power, "-"),
+        settings.temperature.celsius(),
+        settingLabel(MODE_MAP, settings.mode, "-"),
+        settingLabel(FAN_MAP, settings.fan, "-"),
+        settingLabel(VANE_MAP, settings.vane, "-"),
+        settingLabel(WIDEVANE_MAP, settings.wideVane, "-")
     );
 #else
     ESP_LOGD(LOG_SETTINGS_TAG, "[%-*s]-> [power: %-*s, target °C: %.1f, mode: %-*s, fan: %-*s, vane: %-*s, wvane: %-*s]",
         15, getIfNotNull(settingName, "unnamed"),
-        3, getIfNotNull(settings.power, "-"),
-        settings.temperature,
-        6, getIfNotNull(settings.mode, "-"),
-        6, getIfNotNull(settings.fan, "-"),
-        6, getIfNotNull(settings.vane, "-"),
-        6, getIfNotNull(settings.wideVane, "-")
+        3, settingLabel(POWER_MAP, settings.power, "-"),
+        settings.temperature.celsius(),
+        6, settingLabel(MODE_MAP, settings.mode, "-"),
+        6, settingLabel(FAN_MAP, settings.fan, "-"),
+        6, settingLabel(VANE_MAP, settings.vane, "-"),
+        6, settingLabel(WIDEVANE_MAP, settings.wideVane, "-")
     );
 #endif
 }
@@ -295,11 +309,11 @@ void CN105Climate::debugStatus(const char* statusName, heatpumpStatus status) {
 #ifdef USE_ESP32
     ESP_LOGI(LOG_STATUS_TAG, "[%s]-> [room C°: %.1f, outside C°: %s, operating: %s, compressor freq: %.1f Hz]",
         statusName,
-        status.roomTemperature,
+        status.roomTemperature.celsius(),
         // Utilisation de snprintf dans l'expression ternaire
-        isnan(status.outsideAirTemperature)
+        !status.outsideAirTemperature.is_set()
         ? "N/A"
-        : (snprintf(outside_temp_buffer, sizeof(outside_temp_buffer), "%.1f", status.outsideAirTemperature) > 0 ? outside_temp_buffer : "ERR"),
+        : (snprintf(outside_temp_buffer, sizeof(outside_temp_buffer), "%.1f", status.outsideAirTemperature.celsius()) > 0 ? outside_temp_buffer : "ERR"),
         status.operating ? "YES" : "NO ",
         status.compressorFrequency);
 #else
@@ -309,11 +323,11 @@ void CN105Climate::debugStatus(const char* statusName, heatpumpStatus status) {
 
     ESP_LOGI(LOG_STATUS_TAG, "[%-*s]-> [room C°: %.1f, outside C°: %s, operating: %-*s, compressor freq: %.1f Hz]",
         15, statusName,
-        status.roomTemperature,
+        status.roomTemperature.celsius(),
         // Utilisation de snprintf dans l'expression ternaire
-        isnan(status.outsideAirTemperature)
+        !status.outsideAirTemperature.is_set()
         ? "N/A"
-        : (snprintf(outside_temp_buffer, sizeof(outside_temp_buffer), "%.1f", status.outsideAirTemperature) > 0 ? outside_temp_buffer : "ERR"),
+        : (snprintf(outside_temp_buffer, sizeof(outside_temp_buffer), "%.1f", status.outsideAirTemperature.celsius()) > 0 ? outside_temp_buffer : "ERR"),
         3, status.operating ? "YES" : "NO ",
         status.compressorFrequency);
 #endif
@@ -379,17 +393,7 @@ void CN105Climate::hpFunctionsDebug(uint8_t* packet, unsigned int length) {
     ESP_LOGD(LOG_FUNCTIONS_TAG, "Decoded %02X:%s", packet[0], output.c_str());
 }
 
-int CN105Climate::lookupByteMapIndex(const int valuesMap[], int len, int lookupValue, const char* debugInfo) {
-    for (int i = 0; i < len; i++) {
-        if (valuesMap[i] == lookupValue) {
-            return i;
-        }
-    }
-    ESP_LOGW("lookup", "%s caution value %d not found, returning -1", debugInfo, lookupValue);
-    //esphome::delay(200);
-    return -1;
-}
-int CN105Climate::lookupByteMapIndex(const char* valuesMap[], int len, const char* lookupValue, const char* debugInfo) {
+int CN105Climate::lookupByteMapIndex(const char* const valuesMap[], int len, const char* lookupValue, const char* debugInfo) {
     for (int i = 0; i < len; i++) {
         if (strcasecmp(valuesMap[i], lookupValue) == 0) {
             return i;
@@ -399,59 +403,17 @@ int CN105Climate::lookupByteMapIndex(const char* valuesMap[], int len, const cha
     //esphome::delay(200);
     return -1;
 }
-const char* CN105Climate::lookupByteMapValue(const char* valuesMap[], const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo, const char* defaultValue) {
+uint8_t CN105Climate::decodeSettingByte(const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo) {
     for (int i = 0; i < len; i++) {
         if (byteMap[i] == byteValue) {
-            return valuesMap[i];
-        }
-    }
-
-    if (defaultValue != nullptr) {
-        return defaultValue;
-    } else {
-        ESP_LOGW("lookup", "%s caution: value %d not found, returning value at index 0", debugInfo, byteValue);
-        return valuesMap[0];
-    }
-
-}
-int CN105Climate::lookupByteMapValue(const int valuesMap[], const uint8_t byteMap[], int len, uint8_t byteValue, const char* debugInfo) {
-    for (int i = 0; i < len; i++) {
-        if (byteMap[i] == byteValue) {
-            return valuesMap[i];
+            return i;
         }
     }
     ESP_LOGW("lookup", "%s caution: value %d not found, returning value at index 0", debugInfo, byteValue);
-    return valuesMap[0];
+    return 0;
 }
 
-#ifndef USE_ESP32
-/**
- * This methode emulates the esp32 lock_guard feature with a boolean variable
- *
-*/
-void CN105Climate::emulateMutex(const char* retryName, std::function<void()>&& f) {
-    this->set_retry(retryName, 100, 10, [this, f, retryName](uint8_t retry_count) {
-        if (this->wantedSettingsMutex) {
-            if (retry_count < 1) {
-                ESP_LOGW(retryName, "10 retry calls failed because mutex was locked, forcing unlock...");
-                this->wantedSettingsMutex = true;
-                f();
-                this->wantedSettingsMutex = false;
-                return RetryResult::DONE;
-            }
-            ESP_LOGI(retryName, "wantedSettingsMutex is already locked, defferring...");
-            return RetryResult::RETRY;
-        } else {
-            this->wantedSettingsMutex = true;
-            ESP_LOGD(retryName, "emulateMutex normal behaviour, locking...");
-            f();
-            ESP_LOGD(retryName, "emulateMutex unlocking...");
-            this->wantedSettingsMutex = false;
-            return RetryResult::DONE;
-        }
-        }, 1.2f);
-}
-#ifdef TEST_MODE
+#if !defined(USE_ESP32) && defined(TEST_MODE)
 
 void CN105Climate::testEmulateMutex(const char* retryName, std::function<void()>&& f) {
     this->set_retry(retryName, 100, 10, [this, f, retryName](uint8_t retry_count) {
@@ -476,7 +438,6 @@ void CN105Climate::testEmulateMutex(const char* retryName, std::function<void()>
         }, 1.2f);
 }
 #endif
-#endif
 
 #ifdef TEST_MODE
 void CN105Climate::logDelegate() {
@@ -0,0 +1,100 @@
+#include "web_handler.h"
+
+#ifdef USE_CN105_WEB
+#include <cstdio>
+#include "cn105.h"
+
+using namespace esphome;
+
+static const char* const HISTORY_PATH = "/cn105/history";
+static const char* const METRICS_PATH = "/cn105/metrics";
+
+CN105WebHandler* CN105WebHandler::handler_ = nullptr;
+
+#ifdef USE_CN105_HISTORY
+// clé JSON: le nom vient du YAML et peut contenir des guillemets
+static std::string escape_json(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+#endif
+
+void CN105WebHandler::register_instance(CN105Climate* climate) {
+    if (web_server_base::global_web_server_base == nullptr) {
+        ESP_LOGW(TAG, "web_server_base is not available, HTTP endpoints disabled");
+        return;
+    }
+    if (handler_ == nullptr) {
+        handler_ = new CN105WebHandler();  // NOLINT: lives as long as the web server
+        web_server_base::global_web_server_base->add_handler(handler_);
+    }
+    handler_->instances_.push_back(climate);
+}
+
+bool CN105WebHandler::canHandle(AsyncWebServerRequest* request) const {
+    return request->url() == HISTORY_PATH || request->url() == METRICS_PATH;
+}
+
+void CN105WebHandler::handleRequest(AsyncWebServerRequest* request) {
+    if (request->url() == HISTORY_PATH) {
+        this->handle_history_(request);
+    } else if (request->url() == METRICS_PATH) {
+        this->handle_metrics_(request);
+    }
+}
+
+void CN105WebHandler::handle_history_(AsyncWebServerRequest* request) {
+#ifdef USE_CN105_HISTORY
+    AsyncResponseStream* stream = request->beginResponseStream("application/json");
+    auto write = [stream](const char* chunk) { stream->print(chunk); };
+    stream->print("{");
+    bool first = true;
+    size_t budget = HISTORY_MAX_RESPONSE_BYTES;
+    for (CN105Climate* climate : this->instances_) {
+        if (!climate->hasHistory()) {
+            continue;
+        }
+        stream->print(first ? "\"" : ",\"");
+        stream->print(escape_json(std::string(climate->get_name().c_str())).c_str());
+        stream->print("\":");
+        if (budget >= HistoryRecorder::DUMP_MAX_BYTES) {
+            budget -= HistoryRecorder::DUMP_MAX_BYTES;
+            climate->dumpHistory(write);
+        } else {
+            ESP_LOGW(LOG_HISTORY_TAG, "%s: history left out of the response (%u bytes max)",
+                climate->get_name().c_str(), (unsigned) HISTORY_MAX_RESPONSE_BYTES);
+            stream->print("null");
+        }
+        first = false;
+    }
+    stream->print("}");
+    request->send(stream);
+#else
+    request->send(404, "text/plain", "history is not enabled");
+#endif
+}
+
+void CN105WebHandler::handle_metrics_(AsyncWebServerRequest* request) {
+#ifdef USE_CN105_METRICS
+    AsyncResponseStream* stream = request->beginResponseStream("text/plain; version=0.0.4; charset=utf-8");
+    MetricsExporter::dump(this->instances_, [stream](const char* chunk) { stream->print(chunk); });
+    request->send(stream);
+#else
+    request->send(404, "text/plain", "metrics are not enabled");
+#endif
+}
+
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_CN105_WEB
+#include <vector>
+#include "esphome/components/web_server_base/web_server_base.h"
+
+namespace esphome {
+
+    class CN105Climate;
+
+    /**
+     * @class CN105WebHandler
+     * @brief Points d'accès HTTP du composant, sur le serveur de web_server_base
+     *
+     * Un seul handler pour toutes les instances cn105: chaque réponse contient une entrée par climatiseur.
+     * Les réponses passent par AsyncResponseStream, qui garde tout le document en RAM jusqu'à l'envoi
+     * (le serveur ESP-IDF n'a pas de réponse chunked). /cn105/history est donc borné à HISTORY_MAX_RESPONSE_BYTES
+     * (au pire ~10 Ko par climatiseur); au-delà, les climatiseurs suivants valent null.
+     */
+    class CN105WebHandler : public AsyncWebHandler {
+    public:
+        static void register_instance(CN105Climate* climate);
+
+        bool canHandle(AsyncWebServerRequest* request) const override;
+        void handleRequest(AsyncWebServerRequest* request) override;
+        bool isRequestHandlerTrivial() const override { return false; }
+
+    protected:
+        void handle_history_(AsyncWebServerRequest* request);
+        void handle_metrics_(AsyncWebServerRequest* request);
+
+        std::vector<CN105Climate*> instances_;
+
+        static CN105WebHandler* handler_;
+    };
+
+}
+#endif
@@ -0,0 +1,183 @@
+#include "write_transactions.h"
+#include "packet_encoder.h"
+#include "Globals.h"
+
+using namespace esphome;
+
+// les types d'écriture suivis, même ordre que stats_
+static const uint8_t WRITE_TXN_TYPES[WRITE_TXN_TYPE_COUNT] = { 0x01, 0x07, 0x08, 0x1F, 0x21 };
+
+WriteTransactions::WriteTransactions(ResendCallback resend_callback, OutcomeCallback outcome_callback) :
+    min_ack_ms_(0),
+    resend_callback_(resend_callback),
+    outcome_callback_(outcome_callback) {
+    this->set_baud_rate(2400);
+}
+
+bool WriteTransactions::is_transactional(const uint8_t* packet, int length) {
+    return length == PACKET_LEN && packet[0] == 0xfc && packet[1] == 0x41;
+}
+
+const char* WriteTransactions::type_name(uint8_t type) {
+    switch (type) {
+    case 0x01: return "settings";
+    case 0x07: return "remote temp";
+    case 0x08: return "run states";
+    case 0x1F: return "functions 1";
+    case 0x21: return "functions 2";
+    default: return "unknown";
+    }
+}
+
+bool WriteTransactions::has_flag_bytes(uint8_t type) {
+    return type == 0x01 || type == 0x08;
+}
+
+uint8_t WriteTransactions::type_at(int index) {
+    return WRITE_TXN_TYPES[index];
+}
+
+void WriteTransactions::set_baud_rate(uint32_t baud) {
+    if (baud == 0) return;
+    // counted from the end of our frame, a 0x61 cannot arrive before the ACK itself went over the wire (11 bits per byte, 8E1)
+    uint32_t wire_ms = (PACKET_LEN * 11 * 1000) / baud;
+    this->min_ack_ms_ = wire_ms * 3 / 4;
+}
+
+WriteTransactions::Stats& WriteTransactions::stats_for(uint8_t type) {
+    for (int i = 0; i < WRITE_TXN_TYPE_COUNT; i++) {
+        if (WRITE_TXN_TYPES[i] == type) return this->stats_[i];
+    }
+    return this->unknown_stats_;
+}
+
+const WriteTransactions::Stats& WriteTransactions::get_stats(uint8_t type) const {
+    for (int i = 0; i < WRITE_TXN_TYPE_COUNT; i++) {
+        if (WRITE_TXN_TYPES[i] == type) return this->stats_[i];
+    }
+    return this->unknown_stats_;
+}
+
+void WriteTransactions::track(const uint8_t* packet, int length, uint32_t tx_done_ms) {
+    uint8_t type = packet[5];
+    uint32_t now = CUSTOM_MILLIS;
+
+    // une écriture plus récente du même type rend les précédentes obsolètes, sauf pour les écritures partielles
+    // à drapeaux (0x01, 0x08): seuls les champs repris par la nouvelle sont retirés de l'ancienne, qui reste
+    // à acquitter (et à renvoyer) pour les autres
+    for (auto& t : this->pending_) {
+        if (t.type != type || t.superseded) {
+            continue;
+        }
+        if (!has_flag_bytes(type) || length != PACKET_LEN) {
+            t.superseded = true;
+            continue;
+        }
+        uint8_t remaining6 = t.packet[6] & static_cast<uint8_t>(~packet[6]);
+        uint8_t remaining7 = t.packet[7] & static_cast<uint8_t>(~packet[7]);
+        if (remaining6 == 0 && remaining7 == 0) {
+            t.superseded = true;
+        } else if (remaining6 != t.packet[6] || remaining7 != t.packet[7]) {
+            t.packet[6] = remaining6;
+            t.packet[7] = remaining7;
+            uint8_t sum = 0;
+            for (int i = 0; i < PACKET_CHECKSUM_INDEX; i++) {
+                sum += t.packet[i];
+            }
+            t.packet[PACKET_CHECKSUM_INDEX] = packet_checksum_from_sum(sum);
+            ESP_LOGD(LOG_WRITE_TXN_TAG, "%s write partly replaced, still awaiting ACK for its other fields", type_name(type));
+        }
+    }
+
+    if (this->pending_.size() >= WRITE_TXN_MAX_IN_FLIGHT) {
+        ESP_LOGW(LOG_WRITE_TXN_TAG, "Too many unacknowledged writes, dropping oldest %s", type_name(this->pending_.front().type));
+        this->finish_head(false, now);
+    }
+
+    Transaction t{};
+    memcpy(t.packet, packet, static_cast<size_t>(length));
+    t.length = static_cast<uint8_t>(length);
+    t.type = type;
+    t.attempts = 1;
+    t.superseded = false;
+    t.sent_ms = tx_done_ms;
+    t.deadline_ms = tx_done_ms + WRITE_ACK_TIMEOUT_MS;
+    this->pending_.push_back(t);
+
+    this->stats_for(type).sent++;
+    ESP_LOGV(LOG_WRITE_TXN_TAG, "%s write sent, %d awaiting ACK", type_name(type), (int) this->pending_.size());
+}
+
+void WriteTransactions::acknowledge() {
+    uint32_t now = CUSTOM_MILLIS;
+    if (this->pending_.empty()) {
+        ESP_LOGD(LOG_WRITE_TXN_TAG, "ACK without pending write (late ACK of a retried write?)");
+        return;
+    }
+    if ((int32_t) (now - this->pending_.front().sent_ms) < (int32_t) this->min_ack_ms_) {
+        // too early to be ours: late ACK of the previous attempt
+        ESP_LOGD(LOG_WRITE_TXN_TAG, "ACK %u ms after %s write, too early: ignored", (unsigned) (now - this->pending_.front().sent_ms),
+            type_name(this->pending_.front().type));
+        return;
+    }
+    this->finish_head(true, now);
+}
+
+void WriteTransactions::finish_head(bool acked, uint32_t now) {
+    Transaction t = this->pending_.front();
+    this->pending_.erase(this->pending_.begin());
+    Stats& s = this->stats_for(t.type);
+
+    if (acked) {
+        uint32_t latency = (int32_t) (now - t.sent_ms) > 0 ? now - t.sent_ms : 0;
+        s.acked++;
+        s.last_latency_ms = latency;
+        s.latency_sum_ms += latency;
+        s.avg_latency_ms = (s.avg_latency_ms == 0) ? latency : (s.avg_latency_ms * 7 + latency) / 8;
+        if (latency > s.max_latency_ms) s.max_latency_ms = latency;
+        ESP_LOGD(LOG_WRITE_TXN_TAG, "%s write acknowledged in %u ms (attempt %d)", type_name(t.type), (unsigned) latency, t.attempts);
+    } else if (t.superseded) {
+        s.superseded++;
+        ESP_LOGD(LOG_WRITE_TXN_TAG, "%s write unacknowledged but superseded by a newer one", type_name(t.type));
+    } else {
+        s.lost++;
+        ESP_LOGW(LOG_WRITE_TXN_TAG, "%s write lost after %d attempts (sent %u, acked %u, lost %u)", type_name(t.type), t.attempts,
+            (unsigned) s.sent, (unsigned) s.acked, (unsigned) s.lost);
+    }
+
+    if (this->outcome_callback_ && !(t.superseded && !acked)) {
+        this->outcome_callback_(t.type, acked, t.packet);
+    }
+}
+
+void WriteTransactions::loop(bool bus_free) {
+    if (this->pending_.empty()) return;
+
+    uint32_t now = CUSTOM_MILLIS;
+    Transaction& head = this->pending_.front();
+    if ((int32_t) (now - head.deadline_ms) < 0) return;
+
+    if (head.superseded || head.attempts >= WRITE_MAX_ATTEMPTS) {
+        this->finish_head(false, now);
+        return;
+    }
+    if (!bus_free) return;      // do not interleave a resend with a cycle waiting for its replies
+
+    head.attempts++;
+    this->stats_for(head.type).retries++;
+    ESP_LOGW(LOG_WRITE_TXN_TAG, "No ACK for %s write, resending (attempt %d/%d)", type_name(head.type), head.attempts, WRITE_MAX_ATTEMPTS);
+    uint32_t tx_done_ms = this->resend_callback_ ? this->resend_callback_(head.packet, head.length) : 0;
+    if (tx_done_ms == 0) {
+        this->finish_head(false, now);
+        return;
+    }
+    head.sent_ms = tx_done_ms;
+    head.deadline_ms = tx_done_ms + (WRITE_ACK_TIMEOUT_MS << (head.attempts - 1));     // backoff x2
+}
+
+void WriteTransactions::clear() {
+    uint32_t now = CUSTOM_MILLIS;
+    while (!this->pending_.empty()) {
+        this->finish_head(false, now);
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "cn105_types.h"
+
+namespace esphome {
+
+    /**
+     * @class WriteTransactions
+     * @brief Suivi des écritures 0x41 (settings, remote temp, run states, functions) jusqu'à leur ACK 0x61.
+     *
+     * L'unité acquitte les écritures dans l'ordre, sans identifiant: chaque ACK est rapproché de la plus
+     * ancienne écriture en attente. Une écriture sans ACK est renvoyée avec un délai doublé à chaque
+     * tentative, puis déclarée perdue. Une écriture remplacée par une plus récente du même type
+     * n'est plus renvoyée (on ne veut pas réappliquer une consigne périmée).
+     */
+    class WriteTransactions {
+    public:
+        /**
+         * @brief Renvoie un paquet sur l'UART
+         * @return Instant de fin d'émission, 0 si le paquet n'a pas pu être écrit
+         */
+        using ResendCallback = std::function<uint32_t(uint8_t*, int)>;
+
+        /**
+         * @brief Appelé quand une écriture est acquittée (true) ou perdue (false)
+         * packet: la trame telle que suivie, réduite aux champs qu'aucune écriture plus récente n'a réécrits
+         */
+        using OutcomeCallback = std::function<void(uint8_t type, bool acked, const uint8_t* packet)>;
+
+        struct Stats {
+            uint32_t sent = 0;
+            uint32_t acked = 0;
+            uint32_t retries = 0;
+            uint32_t lost = 0;
+            uint32_t superseded = 0;
+            uint32_t last_latency_ms = 0;
+            uint32_t avg_latency_ms = 0;    // moyenne glissante (1/8)
+            uint32_t max_latency_ms = 0;
+            uint64_t latency_sum_ms = 0;    // sur `acked` écritures
+        };
+
+        WriteTransactions(ResendCallback resend_callback, OutcomeCallback outcome_callback);
+
+        /// vrai pour un paquet 0x41 qui sera acquitté par un 0x61
+        static bool is_transactional(const uint8_t* packet, int length);
+
+        /// libellé du type d'écriture (octet 5 du paquet)
+        static const char* type_name(uint8_t type);
+
+        /// écritures partielles: les octets 6 et 7 portent un drapeau par champ écrit
+        static bool has_flag_bytes(uint8_t type);
+
+        /// type d'écriture suivi n° index (0 .. WRITE_TXN_TYPE_COUNT - 1)
+        static uint8_t type_at(int index);
+
+        /// le délai minimal d'un ACK dépend de la vitesse du bus
+        void set_baud_rate(uint32_t baud);
+
+        /**
+         * @brief Enregistre une écriture qui vient d'être confiée à l'UART
+         * @param tx_done_ms Instant où son dernier octet quitte la FIFO
+         */
+        void track(const uint8_t* packet, int length, uint32_t tx_done_ms);
+
+        /// rapproche un ACK 0x61 de la plus ancienne écriture en attente
+        void acknowledge();
+
+        /**
+         * @brief Renvoie ou abandonne les écritures sans ACK
+         * @param bus_free false si un cycle attend une réponse: le renvoi est différé
+         */
+        void loop(bool bus_free);
+
+        /// abandonne tout (reconnexion): les écritures en vol sont comptées perdues
+        void clear();
+
+        size_t in_flight() const { return pending_.size(); }
+        const Stats& get_stats(uint8_t type) const;
+
+    private:
+        struct Transaction {
+            uint8_t packet[PACKET_LEN];
+            uint8_t length;
+            uint8_t type;
+            uint8_t attempts;
+            bool superseded;
+            uint32_t sent_ms;
+            uint32_t deadline_ms;
+        };
+
+        std::vector<Transaction> pending_;
+        Stats stats_[WRITE_TXN_TYPE_COUNT];
+        Stats unknown_stats_;
+        uint32_t min_ack_ms_;
+        ResendCallback resend_callback_;
+        OutcomeCallback outcome_callback_;
+
+        Stats& stats_for(uint8_t type);
+        void finish_head(bool acked, uint32_t now);
+    };
+
+}